@@ -0,0 +1,42 @@
+/**
+ * @file bench_common.h
+ * @brief Helpers shared by the benchmarks.
+ *
+ * Every benchmark is a standalone program linked against the engine
+ * objects, so the helpers are static inline and each program compiles its
+ * own copy. Benchmarks that run the engine define their own setup() and
+ * define BENCH_OWN_SETUP before including this header.
+ */
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "../include/canvas.h"
+
+#ifndef BENCH_OWN_SETUP
+/* The engine calls setup() from runEngine, which the benchmark never uses */
+void setup(void) {}
+#endif
+
+/* Wall-clock time in seconds */
+static inline double getCurrentTime(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* Uniform random float in [min, max] from rand() */
+static inline float randomRange(float min, float max) {
+    return min + ((float)rand() / RAND_MAX) * (max - min);
+}
+
+/* Clear the whole back buffer to black, without touching the dirty rectangles */
+static inline void clearCanvas(Canvas* canvas) {
+    memset(canvas->backBuffer, 0, sizeof(uint32_t) * (size_t)canvas->pitch * canvas->bufferHeight);
+}
+
+#endif // BENCH_COMMON_H
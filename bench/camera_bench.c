@@ -0,0 +1,140 @@
+/**
+ * @file camera_bench.c
+ * @brief Benchmark of drawing a large world through a camera.
+ *
+ * 1M triangle outlines are spread over a world 50 canvases wide. The camera
+ * turns slightly and zooms out step by step, from a view holding a few
+ * hundred triangles to one holding all of them. For every zoom the frame is
+ * culled with camera_updateAndCull and drawn with renderTrianglesCamera on
+ * the exact path and on the LOD buckets. The time per frame and per visible
+ * triangle shows what the cost follows: the visible set, not the world.
+ *
+ * First, triangles spread over the canvas are drawn through a camera at
+ * zoom 1, no rotation, on the world origin, and compared with the same
+ * triangles drawn directly, unculled, with renderTrianglesSIMD or
+ * renderTrianglesLOD. The camera's culling must only drop triangles off the
+ * canvas, so the images must be identical; the run fails on a mismatch.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/camera.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH     1600
+#define BENCH_HEIGHT    1200
+#define BENCH_TRIANGLES 1000000
+#define BENCH_WORLD     80000.0f   /* World edge length, world units */
+#define BENCH_REPEATS   10
+#define CHECK_TRIANGLES 100000
+
+/* Cull and draw BENCH_REPEATS frames, return ms per frame (lod NULL = exact path) */
+static double timeFrames(Canvas* canvas, const Camera* camera, TriangleDataSIMD* world,
+                         TriangleDataSIMD* view, TriangleLOD* lod, double* cullMs) {
+    double total = 0.0, culling = 0.0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        clearCanvas(canvas);
+        double start = getCurrentTime();
+        camera_updateAndCull(camera, canvas, world, 0.0f);
+        culling += getCurrentTime() - start;
+        renderTrianglesCamera(canvas, camera, world, view, lod);
+        total += getCurrentTime() - start;
+    }
+    *cullMs = culling * 1000.0 / BENCH_REPEATS;
+    return total * 1000.0 / BENCH_REPEATS;
+}
+
+/* Pixels that differ between drawing data through an untransformed camera
+   and drawing it directly (lod NULL = exact path) */
+static long checkIdentity(Canvas* canvas, TriangleDataSIMD* data, TriangleDataSIMD* view,
+                          TriangleLOD* lod, uint32_t* reference) {
+    size_t pixels = (size_t)canvas->pitch * canvas->bufferHeight;
+    // Reference: every triangle drawn, clipped by the rasterizer
+    clearCanvas(canvas);
+    memset(data->visible, 1, sizeof(bool) * (size_t)data->count);
+    if (lod) {
+        renderTrianglesLOD(canvas, data, lod);
+    } else {
+        renderTrianglesSIMD(canvas, data);
+    }
+    memcpy(reference, canvas->backBuffer, sizeof(uint32_t) * pixels);
+
+    Camera identity;
+    camera_init(&identity);
+    clearCanvas(canvas);
+    camera_updateAndCull(&identity, canvas, data, 0.0f);
+    renderTrianglesCamera(canvas, &identity, data, view, lod);
+
+    long diff = 0;
+    for (size_t i = 0; i < pixels; i++) diff += reference[i] != canvas->backBuffer[i];
+    return diff;
+}
+
+int main(void) {
+    Canvas canvas;
+    if (!Canvas_InitHeadless(&canvas, BENCH_WIDTH, BENCH_HEIGHT)) return 1;
+
+    TriangleDataSIMD world, view;
+    triangleDataSIMD_init(&world, BENCH_TRIANGLES);
+    triangleDataSIMD_init(&view, BENCH_TRIANGLES);
+    TriangleLOD lod;
+    triangleLOD_init(&lod, LOD_POINT_BELOW, LOD_PATTERN_BELOW);
+
+    srand(1234);
+    world.count = BENCH_TRIANGLES;
+    for (int i = 0; i < BENCH_TRIANGLES; i++) {
+        world.cx[i] = randomRange(-BENCH_WORLD / 2, BENCH_WORLD / 2);
+        world.cy[i] = randomRange(-BENCH_WORLD / 2, BENCH_WORLD / 2);
+        world.size[i] = randomRange(4.0f, 12.0f);
+        world.angle[i] = randomRange(0.0f, 6.2831853f);
+        world.color[i] = 0xFF000000u | (uint32_t)rand();
+    }
+
+    TriangleDataSIMD check;
+    triangleDataSIMD_init(&check, CHECK_TRIANGLES);
+    uint32_t* reference = malloc(sizeof(uint32_t) * (size_t)canvas.pitch * canvas.bufferHeight);
+    if (!reference) return 1;
+    check.count = CHECK_TRIANGLES;
+    for (int i = 0; i < CHECK_TRIANGLES; i++) {
+        check.cx[i] = randomRange(-BENCH_WIDTH * 0.55f, BENCH_WIDTH * 0.55f);
+        check.cy[i] = randomRange(-BENCH_HEIGHT * 0.55f, BENCH_HEIGHT * 0.55f);
+        check.size[i] = randomRange(1.0f, 12.0f);
+        check.angle[i] = randomRange(0.0f, 6.2831853f);
+        check.color[i] = 0xFF000000u | (uint32_t)rand();
+    }
+    long exactMismatch = checkIdentity(&canvas, &check, &view, NULL, reference);
+    long lodMismatch = checkIdentity(&canvas, &check, &view, &lod, reference);
+    printf("untransformed camera vs direct drawing, %d triangles: %ld exact / %ld lod pixels differ\n",
+           CHECK_TRIANGLES, exactMismatch, lodMismatch);
+    free(reference);
+    triangleDataSIMD_free(&check);
+
+    Camera camera;
+    camera_init(&camera);
+    camera.x = 1000.0f;
+    camera.y = -500.0f;
+    camera.rotation = 0.3f;
+
+    printf("%dx%d, %d triangles over %.0fx%.0f world units, %d repeats\n", BENCH_WIDTH, BENCH_HEIGHT,
+           BENCH_TRIANGLES, BENCH_WORLD, BENCH_WORLD, BENCH_REPEATS);
+    printf("%8s %9s %9s %12s %12s %14s %12s\n", "zoom", "visible", "cull ms", "exact ms", "lod ms",
+           "lod ns/visible", "speedup");
+    const float zooms[] = { 2.0f, 1.0f, 0.25f, 0.1f, 0.05f, 0.02f };
+    for (int z = 0; z < (int)(sizeof(zooms) / sizeof(zooms[0])); z++) {
+        camera_setZoom(&camera, zooms[z]);
+        double cullMs, exactMs, lodMs;
+        exactMs = timeFrames(&canvas, &camera, &world, &view, NULL, &cullMs);
+        lodMs = timeFrames(&canvas, &camera, &world, &view, &lod, &cullMs);
+        int visible = view.count;
+        printf("%8.2f %9d %9.3f %12.3f %12.3f %14.2f %11.2fx\n", camera.zoom, visible, cullMs, exactMs,
+               lodMs, visible ? lodMs * 1e6 / visible : 0.0, exactMs / lodMs);
+    }
+
+    triangleLOD_free(&lod);
+    triangleDataSIMD_free(&view);
+    triangleDataSIMD_free(&world);
+    Canvas_Destroy(&canvas);
+    return exactMismatch == 0 && lodMismatch == 0 ? 0 : 1;
+}
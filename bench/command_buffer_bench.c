@@ -0,0 +1,188 @@
+/**
+ * @file command_buffer_bench.c
+ * @brief Benchmark of deferred drawing through the command buffer.
+ *
+ * A frame of interleaved draws, the way layers of small objects issue them:
+ * each object draws a triangle outline, a line and a few blended spans. The
+ * frame is drawn immediately, call by call, and recorded into a
+ * CommandBuffer and executed, once on this thread and once on a tile
+ * renderer with one worker per core. Execution runs in recording order
+ * (the default) and with sortByType, which draws every group by primitive
+ * type, so overlapping pixels can end up in a different order; the share of
+ * pixels that differ from the immediate image is printed. In recording
+ * order the image must be the immediate one.
+ *
+ * Within a type the recording order must hold when sorting too:
+ * overlapping lines of different colors, recorded on both sides of a
+ * barrier, are executed and compared with the same lines drawn immediately.
+ * The run fails on any differing pixel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/blend.h"
+#include "../include/command_buffer.h"
+#include "../include/tile_renderer.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH   1600
+#define BENCH_HEIGHT  1200
+#define BENCH_OBJECTS 50000
+#define BENCH_SPANS   4       /* Spans per object */
+#define BENCH_GROUPS  8       /* Layers, one group each */
+#define BENCH_REPEATS 10
+#define ORDER_LINES   4000    /* Overlapping lines of the order check */
+
+typedef struct {
+    float       cx, cy, size, angle;
+    PackedColor color;
+} BenchObject;
+
+static BenchObject objects[BENCH_OBJECTS];
+
+/* Screen row and columns of span s of an object: a small bar under it */
+static void objectSpan(const BenchObject* o, int s, int* y, int* x0, int* x1) {
+    *y = BENCH_HEIGHT / 2 - (int)o->cy + (int)o->size + 2 + s;
+    *x0 = BENCH_WIDTH / 2 + (int)(o->cx - o->size);
+    *x1 = BENCH_WIDTH / 2 + (int)(o->cx + o->size);
+}
+
+static void drawImmediate(Canvas* canvas) {
+    for (int i = 0; i < BENCH_OBJECTS; i++) {
+        const BenchObject* o = &objects[i];
+        drawTrianglePacked(canvas, o->cx, o->cy, o->size, o->angle, o->color);
+        drawLinePacked(canvas, (int)o->cx, (int)o->cy, (int)(o->cx + 3 * o->size), (int)o->cy, o->color);
+        for (int s = 0; s < BENCH_SPANS; s++) {
+            int y, x0, x1;
+            objectSpan(o, s, &y, &x0, &x1);
+            blendSpan(canvas, y, x0, x1, (o->color & 0x00FFFFFFu) | 0x80000000u, BLEND_ALPHA);
+        }
+    }
+}
+
+static void record(CommandBuffer* buffer) {
+    for (int i = 0; i < BENCH_OBJECTS; i++) {
+        const BenchObject* o = &objects[i];
+        if (i % (BENCH_OBJECTS / BENCH_GROUPS) == 0) commandBuffer_barrier(buffer);
+        commandBuffer_triangle(buffer, o->cx, o->cy, o->size, o->angle, o->color);
+        commandBuffer_line(buffer, (int)o->cx, (int)o->cy, (int)(o->cx + 3 * o->size), (int)o->cy, o->color);
+        for (int s = 0; s < BENCH_SPANS; s++) {
+            int y, x0, x1;
+            objectSpan(o, s, &y, &x0, &x1);
+            commandBuffer_span(buffer, y, x0, x1, (o->color & 0x00FFFFFFu) | 0x80000000u, BLEND_ALPHA);
+        }
+    }
+}
+
+/* Draw the frame BENCH_REPEATS times, return ms per frame (buffer NULL = immediate) */
+static double timeFrame(Canvas* canvas, CommandBuffer* buffer, TileRenderer* tiles, double* recordMs) {
+    double total = 0.0, recording = 0.0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        clearCanvas(canvas);
+        double start = getCurrentTime();
+        if (buffer) {
+            record(buffer);
+            recording += getCurrentTime() - start;
+            commandBuffer_execute(buffer, canvas, tiles);
+        } else {
+            drawImmediate(canvas);
+        }
+        total += getCurrentTime() - start;
+    }
+    if (recordMs) *recordMs = recording * 1000.0 / BENCH_REPEATS;
+    return total * 1000.0 / BENCH_REPEATS;
+}
+
+static size_t differingPixels(const uint32_t* a, const uint32_t* b, size_t count) {
+    size_t diff = 0;
+    for (size_t i = 0; i < count; i++) diff += a[i] != b[i];
+    return diff;
+}
+
+/* Overlapping lines in a 64x64 area, half before a barrier and half after,
+   executed through the buffer; returns the pixels that differ from drawing
+   them immediately (-1 when out of memory) */
+static long checkLineOrder(Canvas* canvas, CommandBuffer* buffer, TileRenderer* tiles,
+                           uint32_t* reference, size_t pixels) {
+    static int coords[ORDER_LINES][4];
+    static PackedColor colors[ORDER_LINES];
+    for (int i = 0; i < ORDER_LINES; i++) {
+        for (int k = 0; k < 4; k++) coords[i][k] = (int)randomRange(-32.0f, 32.0f);
+        colors[i] = 0xFF000000u | (uint32_t)rand();
+    }
+
+    clearCanvas(canvas);
+    for (int i = 0; i < ORDER_LINES; i++) {
+        drawLinePacked(canvas, coords[i][0], coords[i][1], coords[i][2], coords[i][3], colors[i]);
+    }
+    memcpy(reference, canvas->backBuffer, sizeof(uint32_t) * pixels);
+
+    clearCanvas(canvas);
+    for (int i = 0; i < ORDER_LINES; i++) {
+        if (i == ORDER_LINES / 2) commandBuffer_barrier(buffer);
+        if (!commandBuffer_line(buffer, coords[i][0], coords[i][1], coords[i][2], coords[i][3], colors[i])) {
+            commandBuffer_reset(buffer);
+            return -1;
+        }
+    }
+    commandBuffer_execute(buffer, canvas, tiles);
+
+    long diff = 0;
+    for (size_t i = 0; i < pixels; i++) diff += reference[i] != canvas->backBuffer[i];
+    return diff;
+}
+
+int main(void) {
+    Canvas canvas;
+    if (!Canvas_InitHeadless(&canvas, BENCH_WIDTH, BENCH_HEIGHT)) return 1;
+    CommandBuffer buffer;
+    commandBuffer_init(&buffer);
+    TileRenderer tiles;
+    if (!tileRenderer_init(&tiles, 0)) return 1;
+
+    srand(1234);
+    for (int i = 0; i < BENCH_OBJECTS; i++) {
+        objects[i].cx = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+        objects[i].cy = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+        objects[i].size = randomRange(2.0f, 12.0f);
+        objects[i].angle = randomRange(0.0f, 6.2831853f);
+        objects[i].color = 0xFF000000u | (uint32_t)rand();
+    }
+
+    size_t pixels = (size_t)canvas.pitch * canvas.bufferHeight;
+    uint32_t* reference = malloc(sizeof(uint32_t) * pixels);
+    if (!reference) return 1;
+
+    printf("%dx%d, %d objects (%d draws each), %d groups, %d repeats\n", BENCH_WIDTH, BENCH_HEIGHT,
+           BENCH_OBJECTS, 2 + BENCH_SPANS, BENCH_GROUPS, BENCH_REPEATS);
+    double immediateMs = timeFrame(&canvas, NULL, NULL, NULL);
+    memcpy(reference, canvas.backBuffer, sizeof(uint32_t) * pixels);
+    printf("  immediate:        %9.3f ms  %d draw calls\n", immediateMs, BENCH_OBJECTS * (2 + BENCH_SPANS));
+
+    size_t recordedMismatch = 0;
+    for (int sorted = 0; sorted < 2; sorted++) {
+        buffer.sortByType = sorted;
+        for (int tiled = 0; tiled < 2; tiled++) {
+            double recordMs;
+            double deferredMs = timeFrame(&canvas, &buffer, tiled ? &tiles : NULL, &recordMs);
+            size_t diff = differingPixels(reference, canvas.backBuffer, pixels);
+            if (!sorted) recordedMismatch += diff;
+            printf("  %-9s %2d wkr: %9.3f ms  %6d batches  (recording %.3f ms)  %.2fx  %.2f%% pixels differ\n",
+                   sorted ? "by type," : "in order,", tiled ? tiles.pool.workerCount : 1, deferredMs,
+                   buffer.batches, recordMs, immediateMs / deferredMs, 100.0 * diff / pixels);
+        }
+    }
+
+    long orderMismatch = checkLineOrder(&canvas, &buffer, NULL, reference, pixels);
+    long tiledOrderMismatch = checkLineOrder(&canvas, &buffer, &tiles, reference, pixels);
+    printf("  line order across a barrier, by type: %ld / %ld pixels differ (this thread / tiled)\n",
+           orderMismatch, tiledOrderMismatch);
+
+    free(reference);
+    tileRenderer_free(&tiles);
+    commandBuffer_free(&buffer);
+    Canvas_Destroy(&canvas);
+    return recordedMismatch == 0 && orderMismatch == 0 && tiledOrderMismatch == 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file draw_triangles_bench.c
+ * @brief Benchmark of the batched drawTriangles API against per-object calls.
+ *
+ * Draws an array of physics-demo-like objects (position, velocity, size,
+ * angle, packed color and an active flag per struct) once with one
+ * drawTrianglePacked call per active object and once with a single
+ * drawTriangles call over a strided view of the array. A quarter of the
+ * objects are inactive and some lie off the canvas. Both must cover the
+ * same pixels; the checksum counts set pixels.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/triangle.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH   1280
+#define BENCH_HEIGHT  720
+#define BENCH_REPEATS 20
+
+/* Same layout as the physics demo's objects */
+typedef struct {
+    float cx, cy;
+    float vx, vy;
+    float size;
+    float angle;
+    float angularVelocity;
+    PackedColor color;
+    bool active;
+} BenchObject;
+
+static long setPixels(const Canvas* canvas) {
+    long set = 0;
+    for (int y = 0; y < canvas->bufferHeight; y++) {
+        for (int x = 0; x < canvas->bufferWidth; x++) {
+            set += canvas->backBuffer[(size_t)y * canvas->pitch + x] != 0;
+        }
+    }
+    return set;
+}
+
+/* Draw the objects BENCH_REPEATS times, return ms per frame */
+static double timeObjects(Canvas* canvas, const BenchObject* objects, int count, bool batched, long* pixels) {
+    double total = 0.0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        clearCanvas(canvas);
+        double start = getCurrentTime();
+        if (batched) {
+            TriangleView view = {0};
+            view.cx = &objects[0].cx;
+            view.cy = &objects[0].cy;
+            view.size = &objects[0].size;
+            view.angle = &objects[0].angle;
+            view.stride = sizeof(BenchObject);
+            view.color = &objects[0].color;
+            view.active = &objects[0].active;
+            view.count = count;
+            drawTriangles(canvas, &view);
+        } else {
+            for (int i = 0; i < count; i++) {
+                if (!objects[i].active) continue;
+                const BenchObject* o = &objects[i];
+                drawTrianglePacked(canvas, o->cx, o->cy, o->size, o->angle, o->color);
+            }
+        }
+        total += getCurrentTime() - start;
+    }
+    *pixels = setPixels(canvas);
+    return total * 1000.0 / BENCH_REPEATS;
+}
+
+int main(void) {
+    static const int counts[] = { 2000, 20000, 200000 };
+
+    Canvas canvas;
+    if (!Canvas_InitHeadless(&canvas, BENCH_WIDTH, BENCH_HEIGHT)) return 1;
+
+    printf("%dx%d, %d repeats, 25%% inactive, 10%% off the canvas\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_REPEATS);
+    printf("%8s %12s %12s %9s %10s\n", "objects", "per call ms", "batched ms", "speedup", "pixels");
+    for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        int count = counts[c];
+        BenchObject* objects = malloc(sizeof(BenchObject) * (size_t)count);
+        if (!objects) return 1;
+        srand(42);
+        for (int i = 0; i < count; i++) {
+            float spread = rand() % 10 == 0 ? 2.0f : 0.5f;
+            objects[i].cx = randomRange(-spread, spread) * BENCH_WIDTH;
+            objects[i].cy = randomRange(-spread, spread) * BENCH_HEIGHT;
+            objects[i].vx = objects[i].vy = 0.0f;
+            objects[i].size = randomRange(5.0f, 15.0f);
+            objects[i].angle = randomRange(0.0f, 6.2831853f);
+            objects[i].angularVelocity = 0.0f;
+            objects[i].color = 0xFF000000u | (uint32_t)rand();
+            objects[i].active = rand() % 4 != 0;
+        }
+
+        long callPixels, batchPixels;
+        double callMs = timeObjects(&canvas, objects, count, false, &callPixels);
+        double batchMs = timeObjects(&canvas, objects, count, true, &batchPixels);
+        printf("%8d %12.3f %12.3f %8.2fx %10ld%s\n", count, callMs, batchMs, callMs / batchMs, batchPixels,
+               callPixels == batchPixels ? "" : " (differs from per call)");
+        free(objects);
+    }
+
+    Canvas_Destroy(&canvas);
+    return 0;
+}
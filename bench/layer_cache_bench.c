@@ -0,0 +1,150 @@
+/**
+ * @file layer_cache_bench.c
+ * @brief Benchmark of cached layers.
+ *
+ * Runs the engine headless with two scenes, once with every layer rendered
+ * each frame and once with the static layer cached:
+ * - full scenery: an opaque background with static circles and triangles
+ *   under a layer of moving circles, composited with one copy per frame
+ * - sparse overlay: the moving circles under a few static rotated
+ *   rectangles, composited by blending only the regions they cover
+ * A frame sink checksums every frame, so both runs must produce the same
+ * images.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../include/engine.h"
+#include "../include/primitives.h"
+#include "../include/triangle.h"
+#define BENCH_OWN_SETUP
+#include "bench_common.h"
+
+#define BENCH_WIDTH     1600
+#define BENCH_HEIGHT    1200
+#define BENCH_FRAMES    200
+#define BENCH_MOVING    200
+#define BENCH_CIRCLES   2000
+#define BENCH_TRIANGLES 20000
+#define BENCH_OBSTACLES 5
+
+static float statics[BENCH_TRIANGLES][4]; /* cx, cy, size, angle */
+static PackedColor staticColors[BENCH_TRIANGLES];
+static float moving[BENCH_MOVING][4];     /* cx, cy, vx, vy */
+static bool sparse;                       /* Scene: sparse overlay instead of full scenery */
+static uint64_t checksum;
+
+static void movingUpdate(float dt) {
+    for (int i = 0; i < BENCH_MOVING; i++) {
+        moving[i][0] += moving[i][2] * dt;
+        moving[i][1] += moving[i][3] * dt;
+        if (moving[i][0] < -BENCH_WIDTH / 2 || moving[i][0] > BENCH_WIDTH / 2) moving[i][2] = -moving[i][2];
+        if (moving[i][1] < -BENCH_HEIGHT / 2 || moving[i][1] > BENCH_HEIGHT / 2) moving[i][3] = -moving[i][3];
+    }
+}
+
+static void movingRender(void) {
+    Canvas* canvas = getCanvas();
+    for (int i = 0; i < BENCH_MOVING; i++) {
+        fillCirclePacked(canvas, moving[i][0], moving[i][1], 12.0f, 0xFFF0C040u, BLEND_REPLACE);
+    }
+}
+
+static void staticUpdate(float dt) { (void)dt; }
+
+static void staticRender(void) {
+    Canvas* canvas = getCanvas();
+    if (sparse) {
+        for (int i = 0; i < BENCH_OBSTACLES; i++) {
+            fillRotatedRectPacked(canvas, statics[i][0] * 0.6f, statics[i][1] * 0.6f, 160.0f, 90.0f,
+                                  statics[i][3], staticColors[i], BLEND_REPLACE);
+        }
+        return;
+    }
+    fillRectPacked(canvas, 0.0f, 0.0f, BENCH_WIDTH, BENCH_HEIGHT, 0xFF141432u, BLEND_REPLACE);
+    for (int i = 0; i < BENCH_CIRCLES; i++) {
+        fillCirclePacked(canvas, statics[i][0], statics[i][1], statics[i][2] * 3.0f, staticColors[i],
+                         BLEND_REPLACE);
+    }
+    for (int i = 0; i < BENCH_TRIANGLES; i++) {
+        drawTrianglePacked(canvas, statics[i][0], statics[i][1], statics[i][2], statics[i][3],
+                           staticColors[i]);
+    }
+}
+
+static Layer background = { "Static", staticUpdate, staticRender, true };
+static Layer movers = { "Moving", movingUpdate, movingRender, true };
+static Layer overlay = { "Overlay", staticUpdate, staticRender, true };
+
+/* Frame sink: FNV-1a over every finished frame */
+static void checksumFrame(void* data, const uint32_t* pixels, int pitch, int width, int height) {
+    (void)data;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            checksum = (checksum ^ pixels[(size_t)y * pitch + x]) * 1099511628211ull;
+        }
+    }
+}
+
+/* Called by runEngineHeadless once the canvas exists; the layers are registered in main */
+void setup(void) {
+    Canvas_AddFrameSink(getCanvas(), checksumFrame, NULL);
+}
+
+/* Run one scene from the same start state, return ms per frame */
+static double runScene(bool cached, const char* staticLayer) {
+    srand(99);
+    for (int i = 0; i < BENCH_MOVING; i++) {
+        moving[i][0] = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+        moving[i][1] = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+        moving[i][2] = randomRange(-300.0f, 300.0f);
+        moving[i][3] = randomRange(-300.0f, 300.0f);
+    }
+    setLayerCached(staticLayer, cached);
+    checksum = 1469598103934665603ull;
+    double start = getCurrentTime();
+    runEngineHeadless(BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES, 1.0f / 60.0f);
+    return (getCurrentTime() - start) * 1000.0 / BENCH_FRAMES;
+}
+
+int main(void) {
+    srand(1234);
+    for (int i = 0; i < BENCH_TRIANGLES; i++) {
+        statics[i][0] = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+        statics[i][1] = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+        statics[i][2] = randomRange(2.0f, 10.0f);
+        statics[i][3] = randomRange(0.0f, 6.2831853f);
+        staticColors[i] = Canvas_PackColor((Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() });
+    }
+
+    printf("%dx%d, %d frames per run\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES);
+    printf("%-36s %12s %12s %10s\n", "scene", "ms/frame", "cached", "speedup");
+
+    int mismatch = 0;
+    for (int scene = 0; scene < 2; scene++) {
+        sparse = scene == 1;
+        const char* staticLayer = sparse ? "Overlay" : "Static";
+        if (sparse) {
+            registerLayer(&movers);
+            registerLayer(&overlay);
+        } else {
+            registerLayer(&background);
+            registerLayer(&movers);
+        }
+
+        double plainMs = runScene(false, staticLayer);
+        uint64_t plainSum = checksum;
+        double cachedMs = runScene(true, staticLayer);
+        mismatch += checksum != plainSum;
+
+        printf("%-36s %12.3f %12.3f %9.2fx\n",
+               sparse ? "sparse overlay (5 rects)" : "full scenery (2k circles, 20k tris)",
+               plainMs, cachedMs, plainMs / cachedMs);
+
+        unregisterLayer("Moving");
+        unregisterLayer(staticLayer);
+    }
+    printf("checksum mismatches: %d\n", mismatch);
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file line_bench.c
+ * @brief Benchmark of the clipped direct-write line rasterizer against the
+ *        previous per-pixel Canvas_PutPixel implementation.
+ *
+ * Runs without a window: the canvas only gets a back buffer. Each scenario is
+ * drawn by both paths into separate buffers, and the pixel outputs are
+ * compared to make sure the two rasterizers agree. The same lines are then
+ * drawn in one drawLinesBatchSIMD call, which must keep painter's order
+ * where lines of different colors overlap; the run fails on any mismatch.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/triangle.h"
+#include "../include/triangle_simd.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH   800
+#define BENCH_HEIGHT  600
+#define BENCH_REPEATS 20
+
+/* Previous drawLine: Bresenham with one bounds-checked Canvas_PutPixel per step */
+static void drawLinePutPixel(Canvas* canvas, int x0, int y0, int x1, int y1, Color color) {
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy, e2;
+    while (true) {
+        Canvas_PutPixel(canvas, x0, y0, color);
+        if (x0 == x1 && y0 == y1) break;
+        e2 = 2*err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+typedef void (*LineFn)(Canvas*, int, int, int, int, Color);
+
+typedef struct {
+    const char* name;
+    int count;
+    int* coords;   /* 4 ints per line */
+    Color* colors;
+} Scenario;
+
+static int randomInt(int min, int max) {
+    return min + rand() % (max - min + 1);
+}
+
+/* Short edges like the ones the triangle demo draws */
+static void makeShortLines(Scenario* s, int count) {
+    s->name = "short edges (1-22 px)";
+    s->count = count;
+    s->coords = malloc(sizeof(int) * 4 * (size_t)count);
+    s->colors = malloc(sizeof(Color) * (size_t)count);
+    for (int i = 0; i < count; i++) {
+        int x = randomInt(-BENCH_WIDTH / 2, BENCH_WIDTH / 2);
+        int y = randomInt(-BENCH_HEIGHT / 2, BENCH_HEIGHT / 2);
+        s->coords[i * 4 + 0] = x;
+        s->coords[i * 4 + 1] = y;
+        s->coords[i * 4 + 2] = x + randomInt(-11, 11);
+        s->coords[i * 4 + 3] = y + randomInt(-11, 11);
+        s->colors[i] = (Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() };
+    }
+}
+
+/* Long lines that start and end far outside the canvas */
+static void makeLongLines(Scenario* s, int count) {
+    s->name = "long lines, mostly off screen";
+    s->count = count;
+    s->coords = malloc(sizeof(int) * 4 * (size_t)count);
+    s->colors = malloc(sizeof(Color) * (size_t)count);
+    for (int i = 0; i < count; i++) {
+        s->coords[i * 4 + 0] = randomInt(-20000, 20000);
+        s->coords[i * 4 + 1] = randomInt(-20000, 20000);
+        s->coords[i * 4 + 2] = randomInt(-20000, 20000);
+        s->coords[i * 4 + 3] = randomInt(-20000, 20000);
+        s->colors[i] = (Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() };
+    }
+}
+
+/* Many lines of different colors crossing in a small area */
+static void makeOverlappingLines(Scenario* s, int count) {
+    s->name = "overlapping, 64x64 px area";
+    s->count = count;
+    s->coords = malloc(sizeof(int) * 4 * (size_t)count);
+    s->colors = malloc(sizeof(Color) * (size_t)count);
+    for (int i = 0; i < count; i++) {
+        s->coords[i * 4 + 0] = randomInt(-32, 32);
+        s->coords[i * 4 + 1] = randomInt(-32, 32);
+        s->coords[i * 4 + 2] = randomInt(-32, 32);
+        s->coords[i * 4 + 3] = randomInt(-32, 32);
+        s->colors[i] = (Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() };
+    }
+}
+
+/* Draw every line of the scenario BENCH_REPEATS times, return ms per pass */
+static double runScenario(Canvas* canvas, const Scenario* s, LineFn fn) {
+    double start = getCurrentTime();
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        memset(canvas->backBuffer, 0, (size_t)canvas->width * canvas->height * sizeof(uint32_t));
+        for (int i = 0; i < s->count; i++) {
+            const int* c = &s->coords[i * 4];
+            fn(canvas, c[0], c[1], c[2], c[3], s->colors[i]);
+        }
+    }
+    return (getCurrentTime() - start) * 1000.0 / BENCH_REPEATS;
+}
+
+/* Same as runScenario with one drawLinesBatchSIMD call per pass */
+static double runScenarioBatched(Canvas* canvas, const Scenario* s) {
+    int* lines = malloc(sizeof(int) * 4 * (size_t)s->count);
+    PackedColor* pixels = malloc(sizeof(PackedColor) * (size_t)s->count);
+    if (!lines || !pixels) {
+        free(lines);
+        free(pixels);
+        return -1.0;
+    }
+    for (int i = 0; i < s->count; i++) {
+        const int* c = &s->coords[i * 4];
+        lines[i * 4 + 0] = BENCH_WIDTH / 2 + c[0];
+        lines[i * 4 + 1] = BENCH_HEIGHT / 2 - c[1];
+        lines[i * 4 + 2] = BENCH_WIDTH / 2 + c[2];
+        lines[i * 4 + 3] = BENCH_HEIGHT / 2 - c[3];
+        pixels[i] = Canvas_PackColor(s->colors[i]);
+    }
+
+    double start = getCurrentTime();
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        memset(canvas->backBuffer, 0, (size_t)canvas->width * canvas->height * sizeof(uint32_t));
+        drawLinesBatchSIMD(canvas, lines, pixels, s->count);
+    }
+    double ms = (getCurrentTime() - start) * 1000.0 / BENCH_REPEATS;
+    free(lines);
+    free(pixels);
+    return ms;
+}
+
+static int countMismatches(const uint32_t* reference, const uint32_t* pixels) {
+    int mismatch = 0;
+    for (int p = 0; p < BENCH_WIDTH * BENCH_HEIGHT; p++) {
+        mismatch += reference[p] != pixels[p];
+    }
+    return mismatch;
+}
+
+int main(void) {
+    Canvas canvas;
+    memset(&canvas, 0, sizeof(canvas));
+    canvas.width = BENCH_WIDTH;
+    canvas.height = BENCH_HEIGHT;
+    bool buffers = Canvas_SetRenderScale(&canvas, 1.0f); /* full-size pixel buffers */
+    uint32_t* reference = malloc((size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+    if (!buffers || !reference) {
+        fprintf(stderr, "Failed to allocate benchmark buffers\n");
+        return 1;
+    }
+
+    srand(1234);
+    Scenario scenarios[3];
+    makeShortLines(&scenarios[0], 300000);
+    makeLongLines(&scenarios[1], 2000);
+    makeOverlappingLines(&scenarios[2], 20000);
+
+    int failures = 0;
+    printf("%-32s %12s %12s %9s %10s %12s %10s\n", "scenario", "putpixel ms", "clipped ms", "speedup",
+           "mismatch", "batched ms", "mismatch");
+    for (int i = 0; i < 3; i++) {
+        const Scenario* s = &scenarios[i];
+        double oldMs = runScenario(&canvas, s, drawLinePutPixel);
+        memcpy(reference, canvas.backBuffer, (size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+        double newMs = runScenario(&canvas, s, drawLine);
+        int mismatch = countMismatches(reference, canvas.backBuffer);
+        double batchMs = runScenarioBatched(&canvas, s);
+        int batchMismatch = batchMs < 0.0 ? -1 : countMismatches(reference, canvas.backBuffer);
+        failures += mismatch != 0 || batchMismatch != 0;
+
+        printf("%-32s %12.3f %12.3f %8.1fx %10d %12.3f %10d\n", s->name, oldMs, newMs, oldMs / newMs,
+               mismatch, batchMs, batchMismatch);
+        free(s->coords);
+        free(s->colors);
+    }
+
+    free(reference);
+    free(canvas.ownedBuffer);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file lod_bench.c
+ * @brief Benchmark and error report of the size-bucketed LOD render paths.
+ *
+ * Draws 1M triangle outlines, most of them below two pixels, with
+ * renderTrianglesSIMD and with renderTrianglesLOD, and prints the time per
+ * frame and per instance and the size of each bucket. A second scene has
+ * only sub-pixel triangles, where every instance is a single store.
+ * The error is measured like in stamp_bench.c over lone triangles of the
+ * point and pattern buckets: the share of the exact outline's pixels the
+ * bucket sets too, and the share of pixels of either image more than one
+ * pixel away from the other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/triangle_simd.h"
+#include "../include/triangle_lod.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH     1600
+#define BENCH_HEIGHT    1200
+#define BENCH_TRIANGLES 1000000
+#define BENCH_REPEATS   10
+#define BENCH_SAMPLES   4000
+#define SAMPLE_CANVAS   64
+
+/* Sizes (half-heights): 70% below 1 px, 20% from 1 to 2, 10% from 2 to 10 */
+static float sceneSize(bool subPixelOnly) {
+    float r = randomRange(0.0f, 1.0f);
+    if (subPixelOnly || r < 0.7f) return randomRange(0.05f, 0.95f);
+    if (r < 0.9f) return randomRange(1.0f, 1.95f);
+    return randomRange(2.0f, 10.0f);
+}
+
+static void fillScene(TriangleDataSIMD* data, bool subPixelOnly) {
+    data->count = BENCH_TRIANGLES;
+    for (int i = 0; i < BENCH_TRIANGLES; i++) {
+        data->cx[i] = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+        data->cy[i] = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+        data->size[i] = sceneSize(subPixelOnly);
+        data->angle[i] = randomRange(0.0f, 6.2831853f);
+        data->color[i] = 0xFF000000u | (uint32_t)rand();
+        data->visible[i] = true;
+    }
+}
+
+/* Draw the scene BENCH_REPEATS times, return ms per frame (lod NULL = exact path) */
+static double timeScene(Canvas* canvas, TriangleDataSIMD* data, TriangleLOD* lod) {
+    double total = 0.0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        clearCanvas(canvas);
+        double start = getCurrentTime();
+        if (lod) renderTrianglesLOD(canvas, data, lod);
+        else renderTrianglesSIMD(canvas, data);
+        total += getCurrentTime() - start;
+    }
+    return total * 1000.0 / BENCH_REPEATS;
+}
+
+/* Is any pixel of image set within one pixel of (x, y)? */
+static bool setNear(const uint32_t* image, int pitch, int size, int x, int y) {
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = x + dx, ny = y + dy;
+            if (nx >= 0 && ny >= 0 && nx < size && ny < size && image[ny * pitch + nx]) return true;
+        }
+    }
+    return false;
+}
+
+/* Error of lone triangles with half-heights from minSize to maxSize */
+static void bucketError(Canvas* canvas, TriangleLOD* lod, float minSize, float maxSize,
+                        double* match, double* far) {
+    TriangleDataSIMD one;
+    triangleDataSIMD_init(&one, 1);
+    one.count = 1;
+    one.visible[0] = true;
+    one.color[0] = 0xFFFFFFFFu;
+    int pitch = canvas->pitch, size = canvas->bufferWidth;
+    size_t pixels = (size_t)pitch * canvas->bufferHeight;
+    uint32_t* exact = malloc(sizeof(uint32_t) * pixels);
+    long same = 0, exactTotal = 0, distant = 0, total = 0;
+
+    srand(99);
+    for (int s = 0; s < BENCH_SAMPLES; s++) {
+        one.cx[0] = randomRange(-10.0f, 10.0f);
+        one.cy[0] = randomRange(-10.0f, 10.0f);
+        one.size[0] = randomRange(minSize, maxSize);
+        one.angle[0] = randomRange(0.0f, 6.2831853f);
+
+        clearCanvas(canvas);
+        renderTrianglesSIMD(canvas, &one);
+        memcpy(exact, canvas->backBuffer, sizeof(uint32_t) * pixels);
+        clearCanvas(canvas);
+        renderTrianglesLOD(canvas, &one, lod);
+        const uint32_t* approx = canvas->backBuffer;
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                size_t i = (size_t)y * pitch + x;
+                if (exact[i]) {
+                    exactTotal++;
+                    total++;
+                    same += approx[i] != 0;
+                    distant += !setNear(approx, pitch, size, x, y);
+                }
+                if (approx[i]) {
+                    total++;
+                    distant += !setNear(exact, pitch, size, x, y);
+                }
+            }
+        }
+    }
+
+    free(exact);
+    triangleDataSIMD_free(&one);
+    *match = exactTotal ? 100.0 * same / exactTotal : 0.0;
+    *far = total ? 100.0 * distant / total : 0.0;
+}
+
+static void runScene(Canvas* canvas, TriangleDataSIMD* data, TriangleLOD* lod, const char* name) {
+    double exactMs = timeScene(canvas, data, NULL);
+    double lodMs = timeScene(canvas, data, lod);
+    printf("%s\n", name);
+    printf("  exact: %9.3f ms  %6.2f ns/instance\n", exactMs, exactMs * 1e6 / BENCH_TRIANGLES);
+    printf("  lod:   %9.3f ms  %6.2f ns/instance  %.2fx\n", lodMs, lodMs * 1e6 / BENCH_TRIANGLES, exactMs / lodMs);
+    printf("  buckets: %d points, %d patterns, %d full\n", lod->pointCount, lod->tinyCount, lod->fullCount);
+}
+
+int main(void) {
+    Canvas canvas, sample;
+    if (!Canvas_InitHeadless(&canvas, BENCH_WIDTH, BENCH_HEIGHT) ||
+        !Canvas_InitHeadless(&sample, SAMPLE_CANVAS, SAMPLE_CANVAS)) return 1;
+
+    TriangleDataSIMD data;
+    triangleDataSIMD_init(&data, BENCH_TRIANGLES);
+    TriangleLOD lod;
+    triangleLOD_init(&lod, LOD_POINT_BELOW, LOD_PATTERN_BELOW);
+
+    printf("%dx%d, %d triangles, %d repeats, thresholds %.1f / %.1f px\n", BENCH_WIDTH, BENCH_HEIGHT,
+           BENCH_TRIANGLES, BENCH_REPEATS, LOD_POINT_BELOW, LOD_PATTERN_BELOW);
+    srand(1234);
+    fillScene(&data, false);
+    runScene(&canvas, &data, &lod, "mixed sizes (70% sub-pixel, 20% tiny, 10% up to 10 px)");
+    fillScene(&data, true);
+    runScene(&canvas, &data, &lod, "sub-pixel only");
+
+    double match, far;
+    printf("%8s %12s %12s\n", "bucket", "same pixel", "off > 1 px");
+    bucketError(&sample, &lod, 0.05f, 0.95f, &match, &far);
+    printf("%8s %11.2f%% %11.2f%%\n", "points", match, far);
+    bucketError(&sample, &lod, 1.0f, 1.95f, &match, &far);
+    printf("%8s %11.2f%% %11.2f%%\n", "patterns", match, far);
+
+    triangleLOD_free(&lod);
+    triangleDataSIMD_free(&data);
+    Canvas_Destroy(&canvas);
+    Canvas_Destroy(&sample);
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file occlusion_bench.c
+ * @brief Benchmark of front-to-back filling with coverage-buffer occlusion.
+ *
+ * Fills 100k overlapping triangles in painter's order with
+ * renderFilledTrianglesSIMD, then front to back with
+ * renderFilledTrianglesOccluded, in submission order and sorted by layer
+ * and depth keys. The keyed reference fills the triangles after sorting
+ * them by key. Each pair of images must be identical; the checksums are
+ * printed and the run fails on a mismatch.
+ *
+ * Triangles with vertices tens of thousands of pixels off the canvas (one
+ * spanning it, one with only its apex on it) are filled both ways too and
+ * compared with a per-pixel test of their edge functions; the run fails
+ * if a pixel differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/triangle_simd.h"
+#include "../include/occlusion.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH     1600
+#define BENCH_HEIGHT    1200
+#define BENCH_TRIANGLES 100000
+#define BENCH_LAYERS    4
+#define BENCH_REPEATS   10
+#define FAR_TRIANGLES   8
+
+static uint64_t checksum(const Canvas* canvas) {
+    uint64_t sum = 1469598103934665603ull;
+    for (int y = 0; y < canvas->bufferHeight; y++) {
+        for (int x = 0; x < canvas->bufferWidth; x++) {
+            sum = (sum ^ canvas->backBuffer[(size_t)y * canvas->pitch + x]) * 1099511628211ull;
+        }
+    }
+    return sum;
+}
+
+/* Keys of the triangles, for qsort of the keyed reference */
+static const uint32_t* sortKeys;
+
+static int compareByKey(const void* a, const void* b) {
+    int i = *(const int*)a, j = *(const int*)b;
+    if (sortKeys[i] != sortKeys[j]) return sortKeys[i] < sortKeys[j] ? -1 : 1;
+    return i - j;
+}
+
+/* Fill the triangles of data in order by testing every pixel against
+   their edge functions (same winding, sampling and top-left rule as the
+   rasterizer), in 128-bit integers so that no vertex is too far */
+static void fillReference(Canvas* canvas, const TriangleDataSIMD* data) {
+    int halfW = canvas->bufferWidth / 2, halfH = canvas->bufferHeight / 2;
+    for (int i = 0; i < data->count; i++) {
+        int vx[3], vy[3];
+        calcTriangleVertices(data->cx[i], data->cy[i], data->size[i], data->angle[i], vx, vy);
+        long long x[3], y[3];
+        for (int v = 0; v < 3; v++) {
+            x[v] = halfW + (long long)vx[v];
+            y[v] = halfH - (long long)vy[v];
+        }
+        __int128 area = (__int128)(x[1] - x[0]) * (y[2] - y[0]) - (__int128)(y[1] - y[0]) * (x[2] - x[0]);
+        if (area == 0) continue;
+        if (area < 0) {
+            long long tx = x[1], ty = y[1];
+            x[1] = x[2]; y[1] = y[2];
+            x[2] = tx; y[2] = ty;
+        }
+        for (int py = 0; py < canvas->bufferHeight; py++) {
+            for (int px = 0; px < canvas->bufferWidth; px++) {
+                bool inside = true;
+                for (int e = 0; e < 3 && inside; e++) {
+                    int a = (e + 1) % 3, b = (e + 2) % 3;
+                    long long dx = x[b] - x[a], dy = y[b] - y[a];
+                    __int128 edge = (__int128)dx * (py - y[a]) - (__int128)dy * (px - x[a]);
+                    bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+                    inside = topLeft ? edge >= 0 : edge > 0;
+                }
+                if (inside) canvas->backBuffer[(size_t)py * canvas->pitch + px] = data->color[i];
+            }
+        }
+    }
+}
+
+/* Pixels that differ from the reference when triangles reaching far past
+   the guard band are filled in painter's order and front to back */
+static long checkFarTriangles(Canvas* canvas, CoverageBuffer* coverage, uint32_t* reference) {
+    TriangleDataSIMD far;
+    triangleDataSIMD_init(&far, FAR_TRIANGLES);
+    far.count = FAR_TRIANGLES;
+    for (int i = 0; i < FAR_TRIANGLES; i++) {
+        far.cx[i] = randomRange(-30000.0f, 30000.0f);
+        far.cy[i] = randomRange(-30000.0f, 30000.0f);
+        far.size[i] = randomRange(20000.0f, 40000.0f);
+        far.angle[i] = randomRange(0.0f, 6.2831853f);
+        far.color[i] = 0xFF000000u | (uint32_t)rand();
+        far.visible[i] = true;
+    }
+    /* Spanning the canvas, and reaching into it with the apex only */
+    far.cx[0] = 0.0f;     far.cy[0] = 0.0f;             far.size[0] = 40000.0f; far.angle[0] = 0.3f;
+    far.cx[1] = 0.0f;     far.cy[1] = 20000.0f - 100.0f; far.size[1] = 20000.0f; far.angle[1] = 0.0f;
+
+    size_t pixels = (size_t)canvas->pitch * canvas->bufferHeight;
+    clearCanvas(canvas);
+    fillReference(canvas, &far);
+    memcpy(reference, canvas->backBuffer, sizeof(uint32_t) * pixels);
+
+    long diff = 0;
+    for (int path = 0; path < 2; path++) {
+        clearCanvas(canvas);
+        if (path == 0) renderFilledTrianglesSIMD(canvas, &far);
+        else renderFilledTrianglesOccluded(canvas, &far, coverage, NULL);
+        for (size_t p = 0; p < pixels; p++) diff += reference[p] != canvas->backBuffer[p];
+    }
+    triangleDataSIMD_free(&far);
+    return diff;
+}
+
+int main(void) {
+    static const struct { const char* name; float minSize, maxSize; } scenes[] = {
+        { "demo sizes 1-11", 1.0f, 11.0f },
+        { "large 8-40", 8.0f, 40.0f }
+    };
+    const int sceneCount = (int)(sizeof(scenes) / sizeof(scenes[0]));
+
+    Canvas canvas;
+    if (!Canvas_InitHeadless(&canvas, BENCH_WIDTH, BENCH_HEIGHT)) return 1;
+
+    TriangleDataSIMD data, sorted;
+    triangleDataSIMD_init(&data, BENCH_TRIANGLES);
+    triangleDataSIMD_init(&sorted, BENCH_TRIANGLES);
+    Triangle* triangles = malloc(sizeof(Triangle) * BENCH_TRIANGLES);
+    uint32_t* keys = malloc(sizeof(uint32_t) * BENCH_TRIANGLES);
+    int* byKey = malloc(sizeof(int) * BENCH_TRIANGLES);
+    CoverageBuffer coverage;
+    coverage_init(&coverage);
+    if (!triangles || !keys || !byKey) {
+        fprintf(stderr, "Failed to allocate benchmark buffers\n");
+        return 1;
+    }
+
+    printf("%dx%d, %d filled triangles, %d repeats\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_TRIANGLES, BENCH_REPEATS);
+    printf("%-16s %-22s %10s %10s %18s\n", "scene", "path", "ms", "rejected", "checksum");
+
+    int mismatch = 0;
+    for (int sc = 0; sc < sceneCount; sc++) {
+        srand(1234);
+        for (int i = 0; i < BENCH_TRIANGLES; i++) {
+            triangles[i].cx = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+            triangles[i].cy = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+            triangles[i].size = randomRange(scenes[sc].minSize, scenes[sc].maxSize);
+            triangles[i].angle = randomRange(0.0f, 6.2831853f);
+            triangles[i].speed = 0.0f;
+            triangles[i].color = (Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() };
+            keys[i] = COVERAGE_SORT_KEY(rand() % BENCH_LAYERS, rand());
+            byKey[i] = i;
+        }
+        triangleDataSIMD_fromTriangles(&data, triangles, BENCH_TRIANGLES);
+        updateAndCullSIMD(&data, 0.0f, BENCH_WIDTH, BENCH_HEIGHT);
+
+        /* Painter's order by key: the same triangles sorted, culled the same */
+        sortKeys = keys;
+        qsort(byKey, BENCH_TRIANGLES, sizeof(int), compareByKey);
+        for (int i = 0; i < BENCH_TRIANGLES; i++) {
+            sorted.cx[i] = data.cx[byKey[i]];
+            sorted.cy[i] = data.cy[byKey[i]];
+            sorted.size[i] = data.size[byKey[i]];
+            sorted.angle[i] = data.angle[byKey[i]];
+            sorted.color[i] = data.color[byKey[i]];
+            sorted.visible[i] = data.visible[byKey[i]];
+        }
+        sorted.count = BENCH_TRIANGLES;
+
+        for (int path = 0; path < 4; path++) {
+            static const char* pathNames[] = {
+                "painter's order", "front to back", "painter's by key", "front to back by key"
+            };
+            double total = 0.0;
+            for (int r = 0; r < BENCH_REPEATS; r++) {
+                clearCanvas(&canvas);
+                double start = getCurrentTime();
+                switch (path) {
+                    case 0: renderFilledTrianglesSIMD(&canvas, &data); break;
+                    case 1: renderFilledTrianglesOccluded(&canvas, &data, &coverage, NULL); break;
+                    case 2: renderFilledTrianglesSIMD(&canvas, &sorted); break;
+                    default: renderFilledTrianglesOccluded(&canvas, &data, &coverage, keys); break;
+                }
+                total += getCurrentTime() - start;
+            }
+
+            /* Each front-to-back image must match the painter's one before it */
+            static uint64_t reference;
+            uint64_t sum = checksum(&canvas);
+            if (path % 2 == 0) reference = sum;
+            else mismatch += sum != reference;
+
+            char rejected[16] = "-";
+            if (path % 2 == 1) snprintf(rejected, sizeof(rejected), "%d", coverage.occluded);
+            printf("%-16s %-22s %10.3f %10s %18llx\n", scenes[sc].name, pathNames[path],
+                   total * 1000.0 / BENCH_REPEATS, rejected, (unsigned long long)sum);
+        }
+    }
+    printf("image mismatches: %d\n", mismatch);
+
+    uint32_t* reference = malloc(sizeof(uint32_t) * (size_t)canvas.pitch * canvas.bufferHeight);
+    if (!reference) return 1;
+    long farMismatch = checkFarTriangles(&canvas, &coverage, reference);
+    printf("triangles past the guard band: %ld pixels differ from the reference\n", farMismatch);
+    free(reference);
+
+    coverage_free(&coverage);
+    triangleDataSIMD_free(&data);
+    triangleDataSIMD_free(&sorted);
+    free(triangles);
+    free(keys);
+    free(byKey);
+    Canvas_Destroy(&canvas);
+    return mismatch || farMismatch ? 1 : 0;
+}
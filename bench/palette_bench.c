@@ -0,0 +1,125 @@
+/**
+ * @file palette_bench.c
+ * @brief Benchmark of the 8-bit indexed canvas mode against direct ARGB drawing.
+ *
+ * Draws a frame of wireframe triangles the way the triangle demo does,
+ * once into the 32-bit back buffer and once into the index buffer followed by
+ * the palette expansion Canvas_Update performs. Both frames include the
+ * clear; index 0 is transparent, so the indexed frame clears the back buffer
+ * it is expanded over as well. Runs without a window: the canvas only gets
+ * its buffers. The expanded indexed frame is compared pixel by pixel with
+ * the ARGB frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/triangle.h"
+#include "../include/primitives.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH     800
+#define BENCH_HEIGHT    600
+#define BENCH_TRIANGLES 100000
+#define BENCH_REPEATS   20
+
+typedef struct {
+    float cx, cy, size, angle;
+    uint8_t index;
+} BenchTriangle;
+
+static void drawFrameARGB(Canvas* canvas, const BenchTriangle* t, int count) {
+    fillRow(canvas->backBuffer, canvas->width * canvas->height, 0xFF000000u);
+    for (int i = 0; i < count; i++) {
+        drawTrianglePacked(canvas, t[i].cx, t[i].cy, t[i].size, t[i].angle,
+                           canvas->palette[t[i].index]);
+    }
+}
+
+static void drawFrameIndexed(Canvas* canvas, const BenchTriangle* t, int count) {
+    fillRow(canvas->backBuffer, canvas->width * canvas->height, 0xFF000000u);
+    Canvas_ClearIndexed(canvas, 0);
+    for (int i = 0; i < count; i++) {
+        drawTriangleIndexed(canvas, t[i].cx, t[i].cy, t[i].size, t[i].angle, t[i].index);
+    }
+    Canvas_ExpandIndexed(canvas->backBuffer, canvas->indexBuffer,
+                         canvas->width * canvas->height, canvas->palette);
+}
+
+typedef void (*FrameFn)(Canvas*, const BenchTriangle*, int);
+
+/* Draw repeats frames, return ms per frame */
+static double runFrames(Canvas* canvas, const BenchTriangle* t, int count, FrameFn fn) {
+    double start = getCurrentTime();
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        fn(canvas, t, count);
+    }
+    return (getCurrentTime() - start) * 1000.0 / BENCH_REPEATS;
+}
+
+int main(void) {
+    Canvas canvas;
+    memset(&canvas, 0, sizeof(canvas));
+    canvas.width = BENCH_WIDTH;
+    canvas.height = BENCH_HEIGHT;
+    bool buffers = Canvas_SetRenderScale(&canvas, 1.0f); /* full-size pixel buffers */
+    uint32_t* reference = malloc((size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+    BenchTriangle* triangles = malloc(sizeof(BenchTriangle) * BENCH_TRIANGLES);
+    if (!buffers || !reference || !triangles || !Canvas_SetIndexed(&canvas, true)) {
+        fprintf(stderr, "Failed to allocate benchmark buffers\n");
+        return 1;
+    }
+
+    /* Index 0 is transparent over the black background, the rest random colors */
+    PackedColor palette[CANVAS_PALETTE_SIZE];
+    srand(1234);
+    palette[0] = 0xFF000000u;
+    for (int i = 1; i < CANVAS_PALETTE_SIZE; i++) {
+        palette[i] = Canvas_PackColor((Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() });
+    }
+    Canvas_SetPalette(&canvas, 0, CANVAS_PALETTE_SIZE, palette);
+
+    /* The triangle demo's size range, then larger shapes where pixel writes dominate */
+    const float sizeRanges[2][2] = { { 2.0f, 5.0f }, { 20.0f, 80.0f } };
+    printf("%d triangles per frame, %dx%d canvas\n", BENCH_TRIANGLES, BENCH_WIDTH, BENCH_HEIGHT);
+    printf("%-36s %12s\n", "scenario", "ms/frame");
+
+    int mismatch = 0;
+    for (int scene = 0; scene < 2; scene++) {
+        for (int i = 0; i < BENCH_TRIANGLES; i++) {
+            triangles[i].cx = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+            triangles[i].cy = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+            triangles[i].size = randomRange(sizeRanges[scene][0], sizeRanges[scene][1]);
+            triangles[i].angle = randomRange(0.0f, 6.2831853f);
+            triangles[i].index = (uint8_t)(1 + rand() % (CANVAS_PALETTE_SIZE - 1));
+        }
+
+        double argbMs = runFrames(&canvas, triangles, BENCH_TRIANGLES, drawFrameARGB);
+        memcpy(reference, canvas.backBuffer, (size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+        double indexedMs = runFrames(&canvas, triangles, BENCH_TRIANGLES, drawFrameIndexed);
+        printf("size %g-%g:\n", sizeRanges[scene][0], sizeRanges[scene][1]);
+        printf("  %-34s %12.3f\n", "ARGB clear + draw", argbMs);
+        printf("  %-34s %12.3f  (%.2fx)\n", "indexed clear + draw + expand", indexedMs, argbMs / indexedMs);
+
+        for (int p = 0; p < BENCH_WIDTH * BENCH_HEIGHT; p++) {
+            mismatch += reference[p] != canvas.backBuffer[p];
+        }
+    }
+
+    /* Expansion alone, the extra work indexed mode adds to Canvas_Update */
+    double start = getCurrentTime();
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        Canvas_ExpandIndexed(canvas.backBuffer, canvas.indexBuffer,
+                             BENCH_WIDTH * BENCH_HEIGHT, canvas.palette);
+    }
+    printf("%-36s %12.3f\n", "palette expansion only",
+           (getCurrentTime() - start) * 1000.0 / BENCH_REPEATS);
+    printf("indexed mismatch: %d\n", mismatch);
+
+    Canvas_SetIndexed(&canvas, false);
+    free(triangles);
+    free(reference);
+    free(canvas.ownedBuffer);
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file post_fx_bench.c
+ * @brief Benchmark of the post-processing passes at 1080p.
+ *
+ * Runs without a window: the canvas only gets a back buffer. Every chain
+ * processes the same test frame, once on a single worker and once on one
+ * worker per core. The checksum of the output is printed so builds with
+ * SIMD=none, sse2 and avx2 can be compared: the kernels must agree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/primitives.h"
+#include "../include/post_fx.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH   1920
+#define BENCH_HEIGHT  1080
+#define BENCH_REPEATS 30
+
+static uint32_t* testFrame;
+static uint8_t curveRed[256], curveGreen[256], curveBlue[256];
+
+/* Build one of the chains on fx */
+static void buildChain(PostFx* fx, int chain) {
+    postFx_clear(fx);
+    switch (chain) {
+        case 0: postFx_addDecay(fx, 0.9f); break;
+        case 1: postFx_addBlur(fx, 4, 1); break;
+        case 2: postFx_addBlur(fx, 4, 3); break;
+        case 3: postFx_addBloom(fx, 160, 8, 2, 0.8f); break;
+        case 4: postFx_addGrade(fx, curveRed, curveGreen, curveBlue); break;
+        default:
+            postFx_addDecay(fx, 0.9f);
+            postFx_addBloom(fx, 160, 8, 2, 0.8f);
+            postFx_addGrade(fx, curveRed, curveGreen, curveBlue);
+            break;
+    }
+}
+
+/* Run a chain over the test frame, return ms per frame and the output checksum */
+static double runChain(Canvas* canvas, PostFx* fx, int chain, uint64_t* checksum) {
+    buildChain(fx, chain);
+    double total = 0.0;
+    for (int i = 0; i < BENCH_REPEATS; i++) {
+        memcpy(canvas->backBuffer, testFrame, sizeof(uint32_t) * BENCH_WIDTH * BENCH_HEIGHT);
+        double start = getCurrentTime();
+        postFx_apply(fx, canvas);
+        total += getCurrentTime() - start;
+    }
+    uint64_t sum = 1469598103934665603ull;
+    for (size_t i = 0; i < (size_t)BENCH_WIDTH * BENCH_HEIGHT; i++) {
+        sum = (sum ^ canvas->backBuffer[i]) * 1099511628211ull;
+    }
+    *checksum = sum;
+    return total * 1000.0 / BENCH_REPEATS;
+}
+
+int main(void) {
+    static const char* names[] = {
+        "decay (trails)", "box blur r4", "gaussian r4 (3 boxes)", "bloom t160 r8",
+        "grade (LUT)", "decay + bloom + grade"
+    };
+    const int chains = (int)(sizeof(names) / sizeof(names[0]));
+
+    Canvas canvas;
+    if (!Canvas_InitHeadless(&canvas, BENCH_WIDTH, BENCH_HEIGHT)) return 1;
+
+    /* Test frame: random colored circles on a dark gradient */
+    srand(42);
+    for (int y = 0; y < BENCH_HEIGHT; y++) {
+        for (int x = 0; x < BENCH_WIDTH; x++) {
+            canvas.backBuffer[(size_t)y * canvas.pitch + x] = 0xFF000000u | (uint32_t)(y * 40 / BENCH_HEIGHT);
+        }
+    }
+    for (int i = 0; i < 400; i++) {
+        float cx = (float)(rand() % BENCH_WIDTH - BENCH_WIDTH / 2);
+        float cy = (float)(rand() % BENCH_HEIGHT - BENCH_HEIGHT / 2);
+        PackedColor color = 0xFF000000u | ((uint32_t)rand() & 0xFFFFFFu);
+        fillCirclePacked(&canvas, cx, cy, (float)(4 + rand() % 40), color, BLEND_REPLACE);
+    }
+    testFrame = malloc(sizeof(uint32_t) * BENCH_WIDTH * BENCH_HEIGHT);
+    memcpy(testFrame, canvas.backBuffer, sizeof(uint32_t) * BENCH_WIDTH * BENCH_HEIGHT);
+
+    /* A warm, contrasty curve */
+    for (int i = 0; i < 256; i++) {
+        int s = i < 128 ? i * i / 128 : 255 - (255 - i) * (255 - i) / 128;
+        curveRed[i] = (uint8_t)(s + (255 - s) / 12);
+        curveGreen[i] = (uint8_t)s;
+        curveBlue[i] = (uint8_t)(s * 7 / 8);
+    }
+
+    int cores = workerPool_cpuCount();
+    printf("%dx%d, %d repeats, %d cores\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_REPEATS, cores);
+    printf("%-26s %12s %12s %18s\n", "chain", "1 worker ms", "all ms", "checksum");
+
+    PostFx single, all;
+    if (!postFx_init(&single, 1) || !postFx_init(&all, 0)) return 1;
+    int mismatch = 0;
+    for (int chain = 0; chain < chains; chain++) {
+        uint64_t sumSingle, sumAll;
+        double singleMs = runChain(&canvas, &single, chain, &sumSingle);
+        double allMs = runChain(&canvas, &all, chain, &sumAll);
+        mismatch += sumSingle != sumAll;
+        printf("%-26s %12.3f %12.3f %18llx\n", names[chain], singleMs, allMs, (unsigned long long)sumAll);
+    }
+    printf("worker count mismatches: %d\n", mismatch);
+
+    postFx_free(&single);
+    postFx_free(&all);
+    free(testFrame);
+    Canvas_Destroy(&canvas);
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file present_bench.c
+ * @brief Benchmark of the canvas present modes.
+ *
+ * Opens a real window in each present mode and times Canvas_Update, i.e.
+ * getting a finished frame onto the screen: the texture upload in
+ * PRESENT_COPY, the unlock in PRESENT_LOCK_TEXTURE and the surface update
+ * in PRESENT_WINDOW_SURFACE. Every frame is fully redrawn so the dirty
+ * rectangles cover the window and each mode presents the whole frame.
+ * Set SDL_VIDEODRIVER=dummy to run without a display.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/primitives.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH  1600
+#define BENCH_HEIGHT 1200
+#define BENCH_FRAMES 200
+
+int main(void) {
+    const PresentMode modes[] = { PRESENT_COPY, PRESENT_LOCK_TEXTURE, PRESENT_WINDOW_SURFACE };
+    const char* names[] = { "copy (SDL_UpdateTexture)", "lock texture", "window surface" };
+
+    printf("%dx%d window, %d frames, full redraw each frame\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES);
+    printf("%-28s %12s %12s %8s\n", "mode", "draw ms", "present ms", "pitch");
+
+    int failed = 0;
+    for (int m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m++) {
+        Canvas canvas;
+        memset(&canvas, 0, sizeof(canvas));
+        if (!Canvas_Init(&canvas, BENCH_WIDTH, BENCH_HEIGHT)) {
+            fprintf(stderr, "Failed to initialize canvas: %s\n", SDL_GetError());
+            return 1;
+        }
+        if (!Canvas_SetPresentMode(&canvas, modes[m])) {
+            printf("%-28s %12s\n", names[m], "unavailable");
+            Canvas_Destroy(&canvas);
+            failed++;
+            continue;
+        }
+
+        double drawMs = 0.0, presentMs = 0.0;
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            double start = getCurrentTime();
+            Canvas_BeginFrame(&canvas);
+            /* A moving band over a full background, so every pixel is written */
+            fillRect(&canvas, 0.0f, 0.0f, BENCH_WIDTH, BENCH_HEIGHT, (Color){ 20, 20, 50 });
+            fillRect(&canvas, (float)(f % 200) - 100.0f, 0.0f, 200.0f, BENCH_HEIGHT, (Color){ 200, 80, 40 });
+            double drawn = getCurrentTime();
+            Canvas_Update(&canvas);
+            double end = getCurrentTime();
+            drawMs += (drawn - start) * 1000.0;
+            presentMs += (end - drawn) * 1000.0;
+        }
+        printf("%-28s %12.3f %12.3f %8d\n", names[m],
+               drawMs / BENCH_FRAMES, presentMs / BENCH_FRAMES, canvas.pitch);
+        Canvas_Destroy(&canvas);
+    }
+    return failed == (int)(sizeof(modes) / sizeof(modes[0])) ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file primitives_bench.c
+ * @brief Benchmark of the span-based filled primitives.
+ *
+ * Draws 10k filled circles per frame with fillCircle and with the previous
+ * hello world drawCircle (a Bresenham circle redrawn for every radius with
+ * Canvas_PutPixel), then times rotated rectangles and convex polygons. Runs
+ * without a window: the canvas only gets a back buffer. Unrotated rectangles
+ * are drawn through all three span paths and compared pixel by pixel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/canvas.h"
+#include "../include/primitives.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH   800
+#define BENCH_HEIGHT  600
+#define BENCH_SHAPES  10000
+#define BENCH_REPEATS 10
+
+typedef struct {
+    float cx, cy;
+    float w, h;      /* circle radius in w */
+    float angle;
+    Color color;
+} Shape;
+
+/* Previous drawCircle from the hello world demo */
+static void drawCirclePutPixel(Canvas* canvas, float cx, float cy, float radius, Color color) {
+    int x = 0;
+    int y = (int)radius;
+    int d = 3 - 2 * (int)radius;
+
+    while (y >= x) {
+        Canvas_PutPixel(canvas, (int)cx + x, (int)cy + y, color);
+        Canvas_PutPixel(canvas, (int)cx + y, (int)cy + x, color);
+        Canvas_PutPixel(canvas, (int)cx - x, (int)cy + y, color);
+        Canvas_PutPixel(canvas, (int)cx - y, (int)cy + x, color);
+        Canvas_PutPixel(canvas, (int)cx + x, (int)cy - y, color);
+        Canvas_PutPixel(canvas, (int)cx + y, (int)cy - x, color);
+        Canvas_PutPixel(canvas, (int)cx - x, (int)cy - y, color);
+        Canvas_PutPixel(canvas, (int)cx - y, (int)cy - x, color);
+        if (d < 0) {
+            d = d + 4 * x + 6;
+        } else {
+            d = d + 4 * (x - y) + 10;
+            y--;
+        }
+        x++;
+    }
+
+    for (int r = 0; r < radius; r++) {
+        int x = 0;
+        int y = r;
+        int d = 3 - 2 * r;
+        while (y >= x) {
+            for (int i = (int)cx - x; i <= (int)cx + x; i++) {
+                Canvas_PutPixel(canvas, i, (int)cy + y, color);
+                Canvas_PutPixel(canvas, i, (int)cy - y, color);
+            }
+            for (int i = (int)cx - y; i <= (int)cx + y; i++) {
+                Canvas_PutPixel(canvas, i, (int)cy + x, color);
+                Canvas_PutPixel(canvas, i, (int)cy - x, color);
+            }
+            if (d < 0) {
+                d = d + 4 * x + 6;
+            } else {
+                d = d + 4 * (x - y) + 10;
+                y--;
+            }
+            x++;
+        }
+    }
+}
+
+static void drawOldCircle(Canvas* canvas, const Shape* s) {
+    drawCirclePutPixel(canvas, s->cx, s->cy, s->w, s->color);
+}
+
+static void drawCircleSpans(Canvas* canvas, const Shape* s) {
+    fillCircle(canvas, s->cx, s->cy, s->w, s->color);
+}
+
+static void drawRotatedRectSpans(Canvas* canvas, const Shape* s) {
+    fillRotatedRect(canvas, s->cx, s->cy, s->w, s->h, s->angle, s->color);
+}
+
+/* Regular hexagon through fillConvexPolygon */
+static void drawHexagonSpans(Canvas* canvas, const Shape* s) {
+    float xs[6], ys[6];
+    for (int i = 0; i < 6; i++) {
+        float a = s->angle + (float)i * 1.0471976f;
+        xs[i] = s->cx + cosf(a) * s->w;
+        ys[i] = s->cy + sinf(a) * s->w;
+    }
+    fillConvexPolygon(canvas, xs, ys, 6, s->color);
+}
+
+/* The same axis-aligned rectangle through the three span paths */
+static void drawRectSpans(Canvas* canvas, const Shape* s) {
+    fillRect(canvas, s->cx, s->cy, s->w, s->h, s->color);
+}
+
+static void drawRectAsRotated(Canvas* canvas, const Shape* s) {
+    fillRotatedRect(canvas, s->cx, s->cy, s->w, s->h, 0.0f, s->color);
+}
+
+static void drawRectAsPolygon(Canvas* canvas, const Shape* s) {
+    float xs[4] = { s->cx - s->w / 2, s->cx + s->w / 2, s->cx + s->w / 2, s->cx - s->w / 2 };
+    float ys[4] = { s->cy - s->h / 2, s->cy - s->h / 2, s->cy + s->h / 2, s->cy + s->h / 2 };
+    fillConvexPolygon(canvas, xs, ys, 4, s->color);
+}
+
+typedef void (*ShapeFn)(Canvas*, const Shape*);
+
+/* Draw every shape repeats times, return ms per frame */
+static double runFrames(Canvas* canvas, const Shape* shapes, int count, ShapeFn fn, int repeats) {
+    double start = getCurrentTime();
+    for (int r = 0; r < repeats; r++) {
+        memset(canvas->backBuffer, 0, (size_t)canvas->width * canvas->height * sizeof(uint32_t));
+        for (int i = 0; i < count; i++) {
+            fn(canvas, &shapes[i]);
+        }
+    }
+    return (getCurrentTime() - start) * 1000.0 / repeats;
+}
+
+static int countMismatches(const uint32_t* a, const uint32_t* b) {
+    int mismatch = 0;
+    for (int p = 0; p < BENCH_WIDTH * BENCH_HEIGHT; p++) {
+        mismatch += a[p] != b[p];
+    }
+    return mismatch;
+}
+
+int main(void) {
+    Canvas canvas;
+    memset(&canvas, 0, sizeof(canvas));
+    canvas.width = BENCH_WIDTH;
+    canvas.height = BENCH_HEIGHT;
+    bool buffers = Canvas_SetRenderScale(&canvas, 1.0f); /* full-size pixel buffers */
+    uint32_t* reference = malloc((size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+    Shape* shapes = malloc(sizeof(Shape) * BENCH_SHAPES);
+    if (!buffers || !reference || !shapes) {
+        fprintf(stderr, "Failed to allocate benchmark buffers\n");
+        return 1;
+    }
+
+    /* Circles and rectangles the size of the hello world demo shapes */
+    srand(1234);
+    for (int i = 0; i < BENCH_SHAPES; i++) {
+        shapes[i].cx = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+        shapes[i].cy = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+        shapes[i].w = randomRange(15.0f, 30.0f);
+        shapes[i].h = randomRange(15.0f, 30.0f);
+        shapes[i].angle = randomRange(0.0f, 6.2831853f);
+        shapes[i].color = (Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() };
+    }
+
+    printf("%d shapes per frame, %dx%d canvas\n", BENCH_SHAPES, BENCH_WIDTH, BENCH_HEIGHT);
+    printf("%-36s %12s\n", "scenario", "ms/frame");
+
+    /* The old circle takes seconds per frame, one frame is enough */
+    double oldMs = runFrames(&canvas, shapes, BENCH_SHAPES, drawOldCircle, 1);
+    double newMs = runFrames(&canvas, shapes, BENCH_SHAPES, drawCircleSpans, BENCH_REPEATS);
+    printf("%-36s %12.3f\n", "circles, Bresenham + PutPixel", oldMs);
+    printf("%-36s %12.3f  (%.1fx)\n", "circles, spans", newMs, oldMs / newMs);
+    printf("%-36s %12.3f\n", "rotated rects, spans",
+           runFrames(&canvas, shapes, BENCH_SHAPES, drawRotatedRectSpans, BENCH_REPEATS));
+    printf("%-36s %12.3f\n", "hexagons, spans",
+           runFrames(&canvas, shapes, BENCH_SHAPES, drawHexagonSpans, BENCH_REPEATS));
+
+    /* Axis-aligned rects must come out the same through every path */
+    runFrames(&canvas, shapes, BENCH_SHAPES, drawRectSpans, BENCH_REPEATS);
+    memcpy(reference, canvas.backBuffer, (size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+    runFrames(&canvas, shapes, BENCH_SHAPES, drawRectAsRotated, BENCH_REPEATS);
+    int rotatedMismatch = countMismatches(reference, canvas.backBuffer);
+    runFrames(&canvas, shapes, BENCH_SHAPES, drawRectAsPolygon, BENCH_REPEATS);
+    int polygonMismatch = countMismatches(reference, canvas.backBuffer);
+    printf("rect mismatch: rotated %d, polygon %d\n", rotatedMismatch, polygonMismatch);
+
+    free(shapes);
+    free(reference);
+    free(canvas.ownedBuffer);
+    return (rotatedMismatch || polygonMismatch) ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file render_scale_bench.c
+ * @brief Benchmark of the internal render scale.
+ *
+ * Draws the same logical scene (wireframe triangles like the triangle demo
+ * plus filled circles) at several render scales and times the drawing and
+ * the upscale Canvas_Update performs before the upload. Runs without a
+ * window: Canvas_SetRenderScale only allocates the pixel buffers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/triangle_simd.h"
+#include "../include/primitives.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH     1600
+#define BENCH_HEIGHT    1200
+#define BENCH_TRIANGLES 100000
+#define BENCH_CIRCLES   2000
+#define BENCH_REPEATS   10
+
+int main(void) {
+    Triangle* triangles = malloc(sizeof(Triangle) * BENCH_TRIANGLES);
+    float* circles = malloc(sizeof(float) * 3 * BENCH_CIRCLES); /* cx, cy, radius */
+    TriangleDataSIMD data;
+    triangleDataSIMD_init(&data, BENCH_TRIANGLES);
+    if (!triangles || !circles) {
+        fprintf(stderr, "Failed to allocate benchmark buffers\n");
+        return 1;
+    }
+
+    srand(1234);
+    for (int i = 0; i < BENCH_TRIANGLES; i++) {
+        triangles[i].cx = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+        triangles[i].cy = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+        triangles[i].size = randomRange(2.0f, 10.0f);
+        triangles[i].angle = randomRange(0.0f, 6.2831853f);
+        triangles[i].speed = 0.0f;
+        triangles[i].color = (Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() };
+    }
+    for (int i = 0; i < BENCH_CIRCLES; i++) {
+        circles[i * 3 + 0] = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+        circles[i * 3 + 1] = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+        circles[i * 3 + 2] = randomRange(15.0f, 30.0f);
+    }
+    triangleDataSIMD_fromTriangles(&data, triangles, BENCH_TRIANGLES);
+    updateAndCullSIMD(&data, 0.0f, BENCH_WIDTH, BENCH_HEIGHT);
+
+    const float scales[] = { 1.0f, 0.75f, 0.5f };
+    printf("%dx%d window, %d triangles + %d circles per frame\n",
+           BENCH_WIDTH, BENCH_HEIGHT, BENCH_TRIANGLES, BENCH_CIRCLES);
+    printf("%-8s %12s %12s %12s %12s\n", "scale", "buffer", "draw ms", "upscale ms", "total ms");
+
+    for (int s = 0; s < (int)(sizeof(scales) / sizeof(scales[0])); s++) {
+        Canvas canvas;
+        memset(&canvas, 0, sizeof(canvas));
+        canvas.width = BENCH_WIDTH;
+        canvas.height = BENCH_HEIGHT;
+        if (!Canvas_SetRenderScale(&canvas, scales[s])) {
+            fprintf(stderr, "Failed to allocate canvas buffers\n");
+            return 1;
+        }
+        size_t bufferBytes = (size_t)canvas.bufferWidth * canvas.bufferHeight * sizeof(uint32_t);
+
+        double drawMs = 0.0, upscaleMs = 0.0;
+        for (int r = 0; r < BENCH_REPEATS; r++) {
+            double start = getCurrentTime();
+            memset(canvas.backBuffer, 0, bufferBytes);
+            for (int i = 0; i < BENCH_CIRCLES; i++) {
+                fillCircle(&canvas, circles[i * 3], circles[i * 3 + 1], circles[i * 3 + 2],
+                           triangles[i].color);
+            }
+            renderTrianglesSIMD(&canvas, &data);
+            double drawn = getCurrentTime();
+            if (canvas.scaledBuffer) {
+                Canvas_Upscale(canvas.scaledBuffer, canvas.width, canvas.width, canvas.height,
+                               canvas.backBuffer, canvas.bufferWidth, canvas.bufferHeight);
+            }
+            double end = getCurrentTime();
+            drawMs += (drawn - start) * 1000.0;
+            upscaleMs += (end - drawn) * 1000.0;
+        }
+
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%dx%d", canvas.bufferWidth, canvas.bufferHeight);
+        printf("%-8.2f %12s %12.3f %12.3f %12.3f\n", scales[s], buffer,
+               drawMs / BENCH_REPEATS, upscaleMs / BENCH_REPEATS, (drawMs + upscaleMs) / BENCH_REPEATS);
+
+        free(canvas.ownedBuffer);
+        free(canvas.scaledBuffer);
+    }
+
+    triangleDataSIMD_free(&data);
+    free(circles);
+    free(triangles);
+    return 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file scene_bench.c
+ * @brief Benchmark of the retained scene against immediate-mode drawing.
+ *
+ * Runs the engine headless over a field of triangle outlines of which only
+ * a few turn each frame. The immediate run transforms and draws every
+ * triangle each frame; the retained run adds them to a Scene once, updates
+ * the turning ones through their handles and lets scene_draw redraw only
+ * the tiles they touch. A frame sink checksums every frame, so both runs
+ * must produce the same images.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../include/engine.h"
+#include "../include/scene.h"
+#include "../include/triangle.h"
+#define BENCH_OWN_SETUP
+#include "bench_common.h"
+
+#define BENCH_WIDTH     1600
+#define BENCH_HEIGHT    1200
+#define BENCH_FRAMES    200
+#define BENCH_TRIANGLES 100000
+
+static float triangles[BENCH_TRIANGLES][4]; /* cx, cy, size, angle */
+static PackedColor colors[BENCH_TRIANGLES];
+static SceneHandle handles[BENCH_TRIANGLES];
+static Scene scene;
+static bool retained;
+static int turning;                          /* Triangles turned per frame */
+static int nextTurning;
+static uint64_t checksum;
+
+static void fieldUpdate(float dt) {
+    for (int i = 0; i < turning; i++) {
+        int t = nextTurning;
+        nextTurning = (nextTurning + 7919) % BENCH_TRIANGLES;
+        triangles[t][3] += 2.0f * dt;
+        if (retained) {
+            scene_setTriangle(&scene, handles[t], triangles[t][0], triangles[t][1],
+                              triangles[t][2], triangles[t][3]);
+        }
+    }
+}
+
+static void fieldRender(void) {
+    Canvas* canvas = getCanvas();
+    if (retained) {
+        scene_draw(&scene, canvas);
+        return;
+    }
+    for (int i = 0; i < BENCH_TRIANGLES; i++) {
+        drawTrianglePacked(canvas, triangles[i][0], triangles[i][1], triangles[i][2],
+                           triangles[i][3], colors[i]);
+    }
+}
+
+static Layer field = { "Field", fieldUpdate, fieldRender, true };
+
+/* Frame sink: FNV-1a over every finished frame */
+static void checksumFrame(void* data, const uint32_t* pixels, int pitch, int width, int height) {
+    (void)data;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            checksum = (checksum ^ pixels[(size_t)y * pitch + x]) * 1099511628211ull;
+        }
+    }
+}
+
+/* Called by runEngineHeadless once the canvas exists; the layer is registered in main */
+void setup(void) {
+    Canvas_AddFrameSink(getCanvas(), checksumFrame, NULL);
+}
+
+/* Run the field from the same start state, return ms per frame */
+static double runField(bool useScene) {
+    srand(1234);
+    for (int i = 0; i < BENCH_TRIANGLES; i++) {
+        triangles[i][0] = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+        triangles[i][1] = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+        triangles[i][2] = randomRange(2.0f, 5.0f);
+        triangles[i][3] = randomRange(0.0f, 6.2831853f);
+        colors[i] = Canvas_PackColor((Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() });
+    }
+    retained = useScene;
+    nextTurning = 0;
+    if (retained) {
+        scene_init(&scene);
+        for (int i = 0; i < BENCH_TRIANGLES; i++) {
+            handles[i] = scene_addTriangle(&scene, triangles[i][0], triangles[i][1],
+                                           triangles[i][2], triangles[i][3], colors[i]);
+        }
+    }
+    checksum = 1469598103934665603ull;
+    double start = getCurrentTime();
+    runEngineHeadless(BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES, 1.0f / 60.0f);
+    double ms = (getCurrentTime() - start) * 1000.0 / BENCH_FRAMES;
+    if (retained) scene_free(&scene);
+    return ms;
+}
+
+int main(void) {
+    static const int turningCounts[] = { 10, 100, 1000, 10000 };
+
+    registerLayer(&field);
+    printf("%dx%d, %d triangles, %d frames per run\n",
+           BENCH_WIDTH, BENCH_HEIGHT, BENCH_TRIANGLES, BENCH_FRAMES);
+    printf("%-24s %12s %12s %10s\n", "turning per frame", "immediate", "retained", "speedup");
+
+    int mismatch = 0;
+    for (size_t i = 0; i < sizeof(turningCounts) / sizeof(turningCounts[0]); i++) {
+        turning = turningCounts[i];
+        double immediateMs = runField(false);
+        uint64_t immediateSum = checksum;
+        double retainedMs = runField(true);
+        mismatch += checksum != immediateSum;
+        printf("%-24d %12.3f %12.3f %9.2fx\n", turning, immediateMs, retainedMs,
+               immediateMs / retainedMs);
+    }
+    printf("checksum mismatches: %d\n", mismatch);
+    return mismatch ? 1 : 0;
+}
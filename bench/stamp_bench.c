@@ -0,0 +1,152 @@
+/**
+ * @file stamp_bench.c
+ * @brief Benchmark and error report of the stamp cache for small triangles.
+ *
+ * Draws the triangle demo's scene (100k outlines, sizes 1 to 11) with
+ * renderTrianglesSIMD and with renderTrianglesStamped for several size
+ * cutoffs and angle step counts. For each setting it prints the speedup
+ * and the pixel error over a sample of lone triangles: the share of the
+ * exact outline's pixels the stamp sets too, and the share of pixels of
+ * either outline more than one pixel away from the other. A stamp ignores
+ * where inside its pixel the center lies, so outlines often shift by one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/canvas.h"
+#include "../include/triangle_simd.h"
+#include "../include/stamp_cache.h"
+#include "bench_common.h"
+
+#define BENCH_WIDTH     1600
+#define BENCH_HEIGHT    1200
+#define BENCH_TRIANGLES 100000
+#define BENCH_REPEATS   10
+#define BENCH_SAMPLES   4000
+#define SAMPLE_CANVAS   128
+
+/* Draw the scene BENCH_REPEATS times, return ms per frame (cache NULL = exact path) */
+static double timeScene(Canvas* canvas, TriangleDataSIMD* data, StampCache* cache) {
+    double total = 0.0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        clearCanvas(canvas);
+        double start = getCurrentTime();
+        if (cache) renderTrianglesStamped(canvas, data, cache);
+        else renderTrianglesSIMD(canvas, data);
+        total += getCurrentTime() - start;
+    }
+    return total * 1000.0 / BENCH_REPEATS;
+}
+
+/* Is any pixel of image set within one pixel of (x, y)? */
+static bool setNear(const uint32_t* image, int pitch, int size, int x, int y) {
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = x + dx, ny = y + dy;
+            if (nx >= 0 && ny >= 0 && nx < size && ny < size && image[ny * pitch + nx]) return true;
+        }
+    }
+    return false;
+}
+
+/* Compare the outlines of lone triangles drawn both ways: the share of
+ * exact pixels the stamp sets too, and the share of pixels of either
+ * outline with no pixel of the other within one pixel */
+static void outlineError(Canvas* canvas, StampCache* cache, double* match, double* far) {
+    TriangleDataSIMD one;
+    triangleDataSIMD_init(&one, 1);
+    one.count = 1;
+    one.visible[0] = true;
+    one.color[0] = 0xFFFFFFFFu;
+    int pitch = canvas->pitch, size = canvas->bufferWidth;
+    size_t pixels = (size_t)pitch * canvas->bufferHeight;
+    uint32_t* exact = malloc(sizeof(uint32_t) * pixels);
+    long same = 0, exactTotal = 0, distant = 0, total = 0;
+
+    srand(99);
+    for (int s = 0; s < BENCH_SAMPLES; s++) {
+        one.cx[0] = randomRange(-200.0f, 200.0f) * (float)SAMPLE_CANVAS / BENCH_WIDTH;
+        one.cy[0] = randomRange(-200.0f, 200.0f) * (float)SAMPLE_CANVAS / BENCH_WIDTH;
+        one.size[0] = randomRange(1.0f, (float)cache->maxSize);
+        one.angle[0] = randomRange(0.0f, 6.2831853f);
+
+        clearCanvas(canvas);
+        renderTrianglesSIMD(canvas, &one);
+        memcpy(exact, canvas->backBuffer, sizeof(uint32_t) * pixels);
+        clearCanvas(canvas);
+        renderTrianglesStamped(canvas, &one, cache);
+        const uint32_t* stamped = canvas->backBuffer;
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                size_t i = (size_t)y * pitch + x;
+                if (exact[i]) {
+                    exactTotal++;
+                    total++;
+                    same += stamped[i] != 0;
+                    distant += !setNear(stamped, pitch, size, x, y);
+                }
+                if (stamped[i]) {
+                    total++;
+                    distant += !setNear(exact, pitch, size, x, y);
+                }
+            }
+        }
+    }
+
+    free(exact);
+    triangleDataSIMD_free(&one);
+    *match = exactTotal ? 100.0 * same / exactTotal : 0.0;
+    *far = total ? 100.0 * distant / total : 0.0;
+}
+
+int main(void) {
+    static const int cutoffs[] = { 4, 8, 12 };
+    static const int steps[] = { 16, 32, 64, 128 };
+
+    Canvas canvas, sample;
+    if (!Canvas_InitHeadless(&canvas, BENCH_WIDTH, BENCH_HEIGHT) ||
+        !Canvas_InitHeadless(&sample, SAMPLE_CANVAS, SAMPLE_CANVAS)) return 1;
+
+    /* The triangle demo's scene */
+    Triangle* triangles = malloc(sizeof(Triangle) * BENCH_TRIANGLES);
+    TriangleDataSIMD data;
+    triangleDataSIMD_init(&data, BENCH_TRIANGLES);
+    srand(1234);
+    for (int i = 0; i < BENCH_TRIANGLES; i++) {
+        triangles[i].cx = randomRange(-BENCH_WIDTH / 2.0f, BENCH_WIDTH / 2.0f);
+        triangles[i].cy = randomRange(-BENCH_HEIGHT / 2.0f, BENCH_HEIGHT / 2.0f);
+        triangles[i].size = randomRange(1.0f, 11.0f);
+        triangles[i].angle = randomRange(0.0f, 6.2831853f);
+        triangles[i].speed = 0.0f;
+        triangles[i].color = (Color){ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() };
+    }
+    triangleDataSIMD_fromTriangles(&data, triangles, BENCH_TRIANGLES);
+
+    double exactMs = timeScene(&canvas, &data, NULL);
+
+    printf("%dx%d, %d triangles (sizes 1-11), %d repeats\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_TRIANGLES, BENCH_REPEATS);
+    printf("exact path: %.3f ms\n", exactMs);
+    printf("%6s %6s %10s %9s %9s %12s %12s\n", "cutoff", "steps", "ms", "speedup", "stamped", "same pixel", "off > 1 px");
+
+    for (int c = 0; c < (int)(sizeof(cutoffs) / sizeof(cutoffs[0])); c++) {
+        for (int a = 0; a < (int)(sizeof(steps) / sizeof(steps[0])); a++) {
+            StampCache cache;
+            if (!stampCache_init(&cache, cutoffs[c], steps[a])) return 1;
+            double ms = timeScene(&canvas, &data, &cache);
+
+            int stamped = cache.stamped;
+            double match, far;
+            outlineError(&sample, &cache, &match, &far);
+            printf("%6d %6d %10.3f %8.2fx %9d %11.2f%% %11.2f%%\n", cutoffs[c], steps[a], ms, exactMs / ms,
+                   stamped, match, far);
+            stampCache_free(&cache);
+        }
+    }
+
+    free(triangles);
+    triangleDataSIMD_free(&data);
+    Canvas_Destroy(&canvas);
+    Canvas_Destroy(&sample);
+    return 0;
+}
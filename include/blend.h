@@ -0,0 +1,44 @@
+#ifndef BLEND_H
+#define BLEND_H
+
+#include "canvas.h"
+#include <stdint.h>
+
+// How a source color is combined with the pixel already in the back buffer.
+// Source pixels are packed ARGB8888 and their alpha weights the source:
+//   BLEND_REPLACE   dst = src (alpha ignored)
+//   BLEND_ALPHA     dst = src * a + dst * (1 - a)        (source-over)
+//   BLEND_ADD       dst = min(dst + src * a, 1)
+//   BLEND_MULTIPLY  dst = dst * (src * a + (1 - a))
+// The canvas is opaque, so the written alpha is always 255. The SSE2/AVX2
+// kernels use the same integer math as the scalar path and give identical results.
+typedef enum {
+    BLEND_REPLACE,
+    BLEND_ALPHA,
+    BLEND_ADD,
+    BLEND_MULTIPLY
+} BlendMode;
+
+// Blend one packed ARGB source pixel onto dst
+uint32_t blendPixel(uint32_t dst, uint32_t src, BlendMode mode);
+
+// Blend a single packed ARGB color onto count pixels starting at dst
+void blendFillRow(uint32_t* dst, int count, uint32_t src, BlendMode mode);
+
+// Blend count packed ARGB source pixels onto dst
+void blendRow(uint32_t* dst, const uint32_t* src, int count, BlendMode mode);
+
+// Source-over of count pixels of an image with transparent areas (a cached
+// layer): opaque source pixels are copied, fully transparent ones leave dst
+// untouched and the rest blend as BLEND_ALPHA
+void compositeRow(uint32_t* dst, const uint32_t* src, int count);
+
+// Blend a color onto pixels x0..x1 (inclusive) of screen row y (top-left origin), clipped to the canvas
+void blendSpan(Canvas* canvas, int y, int x0, int x1, uint32_t src, BlendMode mode);
+
+// Blend a width x height ARGB image (srcPitch pixels per row) with its top-left
+// corner at screen position (x, y), clipped to the canvas
+void blendBlit(Canvas* canvas, int x, int y, const uint32_t* src, int width, int height,
+               int srcPitch, BlendMode mode);
+
+#endif // BLEND_H
@@ -0,0 +1,50 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "canvas.h"
+#include "triangle_simd.h"
+#include "triangle_lod.h"
+
+// 2D camera over a world larger than the canvas. World coordinates have
+// the canvas' orientation (y up); the camera maps them to canvas coords
+// (center origin, the units of the drawing API and getMouseX/Y):
+//   canvas = rotate(world - (x, y), -rotation) * zoom
+// so (x, y) is shown at the center of the canvas, zoom > 1 magnifies and a
+// positive rotation turns the view counter-clockwise over the world.
+typedef struct Camera {
+    float x, y;       // World point at the center of the canvas
+    float zoom;       // Canvas units per world unit, > 0 (see camera_setZoom)
+    float rotation;   // Radians
+} Camera;
+
+// Centered on the world origin, zoom 1, no rotation: world = canvas coords
+void camera_init(Camera* camera);
+
+// Set the zoom; false (zoom unchanged) unless it is finite and > 0, since
+// the view and the inverse mapping divide by it
+bool camera_setZoom(Camera* camera, float zoom);
+
+// Map a point between world and canvas coordinates
+void camera_worldToCanvas(const Camera* camera, float wx, float wy, float* cx, float* cy);
+void camera_canvasToWorld(const Camera* camera, float cx, float cy, float* wx, float* wy);
+
+// World-space bounding box of what the canvas shows (the view itself when
+// the camera does not rotate)
+void camera_viewBounds(const Camera* camera, const Canvas* canvas,
+                       float* minX, float* minY, float* maxX, float* maxY);
+
+// updateAndCullSIMD for triangles in world coordinates: advance the angles
+// and mark visible the triangles that can touch the canvas through the
+// camera, tested in view space against the (rotated) view rectangle
+void camera_updateAndCull(const Camera* camera, const Canvas* canvas, TriangleDataSIMD* data, float dt);
+
+// Draw the visible triangles of world (world coordinates) through the
+// camera. Centers, sizes and angles of the visible triangles only are
+// transformed, SIMD_LANES at a time, into view (canvas coordinates, grown
+// as needed; zero it or triangleDataSIMD_init it first), which is then
+// drawn with renderTrianglesLOD, or renderTrianglesSIMD when lod is NULL.
+// Zoomed out, projected sizes shrink and the LOD buckets take over.
+void renderTrianglesCamera(Canvas* canvas, const Camera* camera, const TriangleDataSIMD* world,
+                           TriangleDataSIMD* view, TriangleLOD* lod);
+
+#endif // CAMERA_H
@@ -4,33 +4,217 @@
 #include <SDL2/SDL.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <math.h>
 
 // Simple RGB color
 typedef struct {
     uint8_t r, g, b;
 } Color;
 
-// Canvas that wraps an SDL window/renderer/texture and two pixel buffers (double-buffering)
+// RGB color with alpha (0 = transparent, 255 = opaque)
 typedef struct {
-    SDL_Window*   window;
-    SDL_Renderer* renderer;
+    uint8_t r, g, b, a;
+} ColorRGBA;
+
+// Color already packed in the canvas' ARGB8888 pixel format (0xAARRGGBB).
+// Storing colors packed turns every pixel write into a single store.
+typedef uint32_t PackedColor;
+
+// Pack an r8g8b8 color into the canvas' ARGB8888 pixel format
+static inline PackedColor Canvas_PackColor(Color color) {
+    return (0xFFu << 24) | ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | color.b;
+}
+
+// Pack an r8g8b8a8 color into ARGB8888, keeping its alpha
+static inline PackedColor Canvas_PackColorRGBA(ColorRGBA color) {
+    return ((uint32_t)color.a << 24) | ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | color.b;
+}
+
+// Number of entries in the indexed-mode palette
+#define CANVAS_PALETTE_SIZE 256
+
+// Screen-space rectangle (top-left origin, buffer pixels), covering [minX, maxX) x [minY, maxY)
+typedef struct {
+    int minX, minY;
+    int maxX, maxY;
+} ClipRect;
+
+// Most separate dirty rectangles kept per frame; further regions are merged
+#define CANVAS_MAX_DIRTY_RECTS 16
+
+// Regions of a pixel buffer written during one frame. Overlapping or
+// touching rectangles are merged as they are added.
+typedef struct {
+    ClipRect rects[CANVAS_MAX_DIRTY_RECTS];
+    int      count;
+} DirtyRects;
+
+// How Canvas_Update gets a frame onto the screen
+typedef enum {
+    PRESENT_COPY,           // Draw into a heap buffer, copy it into a streaming texture
+    PRESENT_LOCK_TEXTURE,   // Draw straight into the locked streaming texture
+    PRESENT_WINDOW_SURFACE, // Draw straight into the window surface, no renderer
+    PRESENT_HEADLESS        // No window: frames stay in the back buffer (Canvas_InitHeadless)
+} PresentMode;
+
+// Receives every frame Canvas_Update finishes, at buffer resolution, with
+// rows pitch pixels apart. The pixels are only valid during the call.
+typedef void (*CanvasFrameSink)(void* data, const uint32_t* pixels, int pitch, int width, int height);
+
+// Most frame sinks one canvas feeds
+#define CANVAS_MAX_FRAME_SINKS 4
+
+// Canvas that wraps an SDL window/renderer/texture and the pixel buffer drawn into.
+// Indexed mode adds an 8-bit buffer of palette indices over the back buffer:
+// the *Indexed functions draw into it and Canvas_Update expands what they
+// drew to ARGB on top of the frame right before the upload. Index 0 is
+// transparent, so ARGB drawing still shows wherever no index was drawn.
+//
+// width/height are the logical size: drawing coordinates are center-origin
+// and span the window whatever the render scale. The back buffer is
+// bufferWidth x bufferHeight, i.e. the logical size times renderScale, and
+// is upscaled to the window size before the upload when renderScale < 1.
+// Rows of the back buffer are pitch pixels apart: in the zero-copy present
+// modes it is SDL's memory and SDL picks the pitch.
+//
+// Drawing functions record the regions they write (dirty rectangles), so
+// Canvas_BeginFrame only clears what the buffer held from the last frame
+// and Canvas_Update only uploads what changed since then.
+// Code that writes backBuffer directly must call Canvas_MarkDirty itself.
+typedef struct {
+    SDL_Window*   window;     // NULL in PRESENT_HEADLESS
+    SDL_Renderer* renderer;   // NULL in PRESENT_WINDOW_SURFACE and PRESENT_HEADLESS
     SDL_Texture*  texture;
-    uint32_t*     pixels;     // Front buffer (currently uploaded to texture)
-    uint32_t*     backBuffer; // Back buffer (current drawing target)
-    int           width;
+    uint32_t*     backBuffer; // Current drawing target
+    int           pitch;      // Pixels from one backBuffer row to the next
+    int           width;      // Logical size (window pixels)
     int           height;
+
+    int           bufferWidth;  // Size of the back buffer
+    int           bufferHeight;
+    float         renderScale;  // Buffer pixels per logical unit
+    uint32_t*     ownedBuffer;  // Heap back buffer (NULL when drawing into SDL's memory)
+    uint32_t*     scaledBuffer; // Window-size upscale target (PRESENT_COPY below scale 1)
+
+    PresentMode   presentMode;
+    uint32_t*     presentPixels; // Locked texture or window surface memory (zero-copy modes)
+    int           presentPitch;  // Its row pitch in pixels
+
+    uint8_t*      indexBuffer; // Indexed-mode drawing target (NULL when disabled)
+    PackedColor   palette[CANVAS_PALETTE_SIZE];
+    DirtyRects    indexDirty;     // Drawn into indexBuffer this frame
+    DirtyRects    prevIndexDirty; // Drawn into indexBuffer the previous frame
+
+    DirtyRects    dirty;      // Drawn into backBuffer this frame
+    DirtyRects    prevDirty;  // Drawn into backBuffer the previous frame
+    bool          uploadAll;  // Screen contents unknown: present the whole frame
+    uint64_t      frameCount; // Frames finished by Canvas_Update
+
+    CanvasFrameSink frameSinks[CANVAS_MAX_FRAME_SINKS]; // Called with each finished frame
+    void*         frameSinkData[CANVAS_MAX_FRAME_SINKS];
+    int           frameSinkCount;
 } Canvas;
 
-// Initialize SDL, create window & renderer & streaming texture, allocate pixels[]
+// Map center-origin logical coordinates to buffer pixels (top-left origin, y down)
+static inline float Canvas_ToBufferX(const Canvas* canvas, float cx) {
+    return (float)(canvas->bufferWidth / 2) + cx * canvas->renderScale;
+}
+
+static inline float Canvas_ToBufferY(const Canvas* canvas, float cy) {
+    return (float)(canvas->bufferHeight / 2) - cy * canvas->renderScale;
+}
+
+// Scale a logical length or integer coordinate to buffer pixels
+static inline int Canvas_ScaleInt(const Canvas* canvas, int v) {
+    return canvas->renderScale == 1.0f ? v : (int)lroundf((float)v * canvas->renderScale);
+}
+
+// Initialize SDL, create window & renderer & streaming texture, allocate the back buffer
 bool Canvas_Init(Canvas* canvas, int width, int height);
 
+// Allocate only the pixel buffers, without initializing SDL or opening a
+// window. Drawing, render scale and indexed mode work as usual; Canvas_Update
+// finishes the frame (palette expansion, dirty rectangles) but shows nothing.
+// The present mode stays PRESENT_HEADLESS.
+bool Canvas_InitHeadless(Canvas* canvas, int width, int height);
+
+// Render at renderScale times the window size (0 < renderScale <= 1) and
+// upscale to the window in Canvas_Update. Reallocates the pixel buffers:
+// the back buffer and, in indexed mode, the index buffer start out cleared
+// (index 0), so call it between frames and redraw everything after.
+bool Canvas_SetRenderScale(Canvas* canvas, float renderScale);
+
+// Switch how frames are presented. The zero-copy modes draw into SDL's memory
+// at scale 1 and upscale straight into it below. Returns false (keeping
+// PRESENT_COPY) when the mode is unavailable. A headless canvas cannot
+// switch, and a windowed one cannot become headless.
+//
+// Every mode uploads and presents on the thread calling Canvas_Update.
+// There is no present thread: SDL only supports its window and renderer on
+// the thread that created them (the main thread on macOS), and a thread that
+// only upscales or copies the frame for the main thread to upload adds a
+// copy without taking the upload off the frame.
+bool Canvas_SetPresentMode(Canvas* canvas, PresentMode mode);
+
+// Hand every finished frame to sink (e.g. frameCapture_attach). Returns
+// false when CANVAS_MAX_FRAME_SINKS sinks are already attached.
+bool Canvas_AddFrameSink(Canvas* canvas, CanvasFrameSink sink, void* data);
+
+// Stop handing frames to a sink added with the same data
+void Canvas_RemoveFrameSink(Canvas* canvas, CanvasFrameSink sink, void* data);
+
+// Nearest-neighbor upscale of a srcWidth x srcHeight image to dstWidth x dstHeight,
+// with dstPitch pixels between destination rows
+void Canvas_Upscale(uint32_t* dst, int dstPitch, int dstWidth, int dstHeight,
+                    const uint32_t* src, int srcWidth, int srcHeight);
+
+// Record that the buffer rectangle [x0, x1) x [y0, y1) was drawn this frame
+void Canvas_MarkDirty(Canvas* canvas, int x0, int y0, int x1, int y1);
+
+// Record the whole buffer as drawn (for code that bypasses the drawing API)
+void Canvas_MarkAllDirty(Canvas* canvas);
+
+// Record that the index buffer rectangle [x0, x1) x [y0, y1) was drawn this frame
+void Canvas_MarkIndexDirty(Canvas* canvas, int x0, int y0, int x1, int y1);
+
+// Start a frame: clear to black the regions the previous frame drew, and to
+// index 0 those it drew in the index buffer
+void Canvas_BeginFrame(Canvas* canvas);
+
 // Free pixel buffer and SDL objects
 void Canvas_Destroy(Canvas* canvas);
 
 // Put a single pixel at center-origin coords (cx, cy) with an r8g8b8 color
 void Canvas_PutPixel(Canvas* canvas, int cx, int cy, Color color);
 
-// Upload backBuffer to texture, swap buffers, and render to the screen
+// Put a single pixel at center-origin coords (cx, cy) with a packed color
+void Canvas_PutPixelPacked(Canvas* canvas, int cx, int cy, PackedColor color);
+
+// Switch indexed mode on (allocates the index buffer, cleared to index 0) or
+// off. Turning it on again keeps the current index buffer.
+bool Canvas_SetIndexed(Canvas* canvas, bool enabled);
+
+// Replace count palette entries starting at first. Takes effect at the next
+// Canvas_Update for everything drawn with those indices, so fades and color
+// cycling need no per-pixel color work. Entry 0 is never shown (transparent).
+void Canvas_SetPalette(Canvas* canvas, int first, int count, const PackedColor* colors);
+
+// Set every pixel of the index buffer to index (nonzero covers the whole frame)
+void Canvas_ClearIndexed(Canvas* canvas, uint8_t index);
+
+// Put a single palette index at center-origin coords (cx, cy)
+void Canvas_PutPixelIndexed(Canvas* canvas, int cx, int cy, uint8_t index);
+
+// Expand count palette indices to ARGB pixels, leaving dst as it is under
+// index 0 (AVX2 gathers 8 entries at once; SSE2 has no gather, so the
+// other builds look them up one by one)
+void Canvas_ExpandIndexed(uint32_t* dst, const uint8_t* src, int count, const PackedColor* palette);
+
+// Present backBuffer (see PresentMode) and render to the screen.
+// In indexed mode what the index buffer drew this frame is expanded over
+// backBuffer first (and marked dirty), and
+// below scale 1 the result is upscaled to the window size. Only the union
+// of this frame's and the previous frame's dirty rectangles is uploaded.
 void Canvas_Update(Canvas* canvas);
 
 #endif // CANVAS_H
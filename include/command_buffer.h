@@ -0,0 +1,119 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include "canvas.h"
+#include "blend.h"
+#include "triangle.h"
+#include "tile_renderer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Merged span runs at least this long are split over the workers by rows
+#define COMMAND_SPANS_PER_WORKER 64
+
+// Shorter runs of one type are drawn call by call: merging them costs more
+// than it saves
+#define COMMAND_MIN_MERGE 8
+
+// Command types, in the order they are drawn within a group when sorting by type
+typedef enum {
+    DRAW_CMD_SPAN,       // blended row span (see blendSpan)
+    DRAW_CMD_BLIT,       // blended image (see blendBlit)
+    DRAW_CMD_TRIANGLES,  // triangle outlines (see drawTriangles)
+    DRAW_CMD_LINE,       // line (see drawLinePacked)
+    DRAW_CMD_TEXT,       // text (see textDraw)
+    DRAW_CMD_TYPES
+} DrawCommandType;
+
+// One recorded draw. Variable-size payloads live in the buffer's arenas.
+typedef struct {
+    uint32_t group;      // Barriers recorded before it
+    uint8_t  type;       // DrawCommandType
+    uint8_t  mode;       // BlendMode of spans and blits
+    union {
+        struct { int x0, y0, x1, y1; PackedColor color; } line;    // canvas coords
+        struct { int y, x0, x1; PackedColor color; } span;         // screen row, x1 inclusive
+        struct { int first, count; } triangles;                    // records in the triangle arena
+        struct { const uint32_t* pixels; int x, y, width, height, pitch; } blit;  // screen coords
+        struct { int x, y; size_t offset; Color color; } text;     // string in the payload arena
+    };
+} DrawCommand;
+
+// Triangle as recorded, read back through a strided TriangleView
+typedef struct {
+    float       cx, cy, size, angle;
+    PackedColor color;
+} DrawTriangle;
+
+// Bump allocator reset once per frame; its block only ever grows, so a
+// steady frame allocates nothing. Allocations are offsets, since the
+// block moves when it grows.
+typedef struct {
+    uint8_t* data;
+    size_t   used;
+    size_t   capacity;
+} CommandArena;
+
+// Deferred draw commands. Layers record typed commands instead of drawing;
+// commandBuffer_execute then merges each run of consecutive triangles, lines
+// or spans into one batch and draws them in recording order, triangles and
+// spans on the tile renderer's workers when it gets one. The image is the
+// one drawing the commands immediately gives.
+//
+// With sortByType set, the commands of each group are drawn by type instead
+// (spans, blits, triangles, lines, text), each type in recording order, so
+// interleaved draws merge into a few long runs. Overdraw changes: a later
+// draw of one type no longer lands over an earlier one of another type in
+// the same group. Groups never mix; the engine starts one for every layer,
+// and a layer that needs, say, a line under a span calls
+// commandBuffer_barrier between them. Only worth it when the merged runs
+// save more than the sort costs (see bench/command_buffer_bench.c).
+typedef struct {
+    DrawCommand* commands;
+    int          count;
+    int          capacity;
+    uint32_t     group;
+
+    CommandArena payload;    // Text strings
+    CommandArena triangles;  // DrawTriangle records, contiguous per group
+
+    // Execution scratch, kept between frames
+    int*         order;      // Command indices in drawing order
+    int          orderCapacity;
+    int*         lines;      // Merged lines, screen space
+    PackedColor* pixels;
+    int          lineCapacity;
+    TriangleDataSIMD soa;    // Merged triangles for the tile renderer
+
+    bool         sortByType; // Draw each group by type (see above); false after init
+    int          batches;    // Draw calls the last execute issued
+} CommandBuffer;
+
+void commandBuffer_init(CommandBuffer* buffer);
+void commandBuffer_free(CommandBuffer* buffer);
+
+// Drop all commands, keeping the memory for the next frame
+void commandBuffer_reset(CommandBuffer* buffer);
+
+// Start a new group: later commands are drawn after every earlier one
+void commandBuffer_barrier(CommandBuffer* buffer);
+
+// Record a command; false when out of memory (the command is dropped).
+// Coordinates are those of the immediate call each one mirrors.
+bool commandBuffer_line(CommandBuffer* buffer, int x0, int y0, int x1, int y1, PackedColor color);
+bool commandBuffer_span(CommandBuffer* buffer, int y, int x0, int x1, PackedColor color, BlendMode mode);
+bool commandBuffer_triangle(CommandBuffer* buffer, float cx, float cy, float size, float angle,
+                            PackedColor color);
+bool commandBuffer_triangles(CommandBuffer* buffer, const TriangleView* view);
+bool commandBuffer_text(CommandBuffer* buffer, int cx, int cy, const char* text, Color color);
+
+// The image is not copied: pixels must stay valid until the buffer executes
+bool commandBuffer_blit(CommandBuffer* buffer, int x, int y, const uint32_t* pixels, int width,
+                        int height, int pitch, BlendMode mode);
+
+// Draw all recorded commands into canvas and reset the buffer. tiles
+// (NULL = this thread only) lends its workers.
+void commandBuffer_execute(CommandBuffer* buffer, Canvas* canvas, TileRenderer* tiles);
+
+#endif // COMMAND_BUFFER_H
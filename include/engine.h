@@ -2,6 +2,8 @@
 #define ENGINE_H
 
 #include "canvas.h"
+#include "command_buffer.h"
+#include "post_fx.h"
 #include "text.h"
 #include <stdbool.h>
 
@@ -14,9 +16,44 @@ void update(float dt);
 // Starts the SDL2 loop: window title, size, and target FPS
 int runEngine(const char* title, int width, int height, int fps);
 
+// Runs the same setup and layers without a display: a fixed number of frames,
+// each advanced by dt seconds, as fast as they render. Returns when done.
+int runEngineHeadless(int width, int height, int frames, float dt);
+
+// On-demand rendering (runEngine only, off by default): a frame runs only
+// when a layer asked for one, when input arrived or when a scheduled frame
+// is due; otherwise the engine sleeps in SDL_WaitEventTimeout. Layers that
+// animate call requestFrame() from update() for as long as they move. dt
+// leaves the idle time out: the first frame after a wait gets the dt of one
+// frame at the target rate, so animations resume where they stopped.
+void setOnDemandRendering(bool enabled);
+
+// Run another frame after this one (on-demand mode)
+void requestFrame(void);
+
+// Run a frame after the given number of seconds, e.g. for a clock that
+// changes once a second (on-demand mode)
+void requestFrameIn(float seconds);
+
+// Run a post-processing chain over every frame after the layers render
+// and before it is presented (NULL = none). The engine does not own it.
+void setPostProcess(PostFx* fx);
+
 // Get access to the canvas for drawing
 Canvas* getCanvas(void);
 
+// Deferred rendering (off by default): layers record their drawing into the
+// command buffer getCommandBuffer() returns instead of drawing right away.
+// The engine starts a group for every layer and draws the frame's commands,
+// in recording order with runs merged (see CommandBuffer), before the
+// post-process chain, on a tile renderer with one worker per core. Cached
+// layers are flushed into their cache when they render.
+void setDeferredRendering(bool enabled);
+
+// The buffer layers record into, or NULL to draw immediately (deferred
+// rendering is off)
+CommandBuffer* getCommandBuffer(void);
+
 typedef struct Layer {
   const char* name;
   void (*update)(float dt);
@@ -29,4 +66,16 @@ void registerLayer(Layer* layer);
 void unregisterLayer(const char* name);
 void setLayerEnabled(const char* name, bool enabled);
 
+// Cache a layer: render it once into an offscreen buffer and composite that
+// every frame until invalidateLayer(). Pixels the layer leaves untouched (or
+// draws with alpha 0) stay transparent; blending inside the layer blends with
+// that transparent black, not the layers below. Only ARGB drawing is
+// cached: what the layer draws in indexed mode shows on the frame it
+// renders only. Pays off when drawing the layer costs more than copying
+// the area it covers.
+void setLayerCached(const char* name, bool cached);
+
+// Make a cached layer render again on the next frame
+void invalidateLayer(const char* name);
+
 #endif // ENGINE_H
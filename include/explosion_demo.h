@@ -17,16 +17,23 @@
 #define PARTICLE_MIN_LIFETIME 0.5f
 #define PARTICLE_MAX_LIFETIME 2.0f
 
+// Indexed-mode palette layout: each explosion owns a run of entries, which
+// renderExplosionIndexed fades; its particles keep their indices for life
+#define EXPLOSION_PALETTE_FIRST 1  // Index 0 is transparent
+#define EXPLOSION_COLORS 16        // Palette entries per explosion
+#define EXPLOSION_SLOTS 15         // Explosions fading independently, reused oldest first
+
 // Particle structure for explosion effect
 typedef struct {
     float cx, cy;         // Position in canvas coordinates
     float dx, dy;         // Velocity components
     float size;           // Size of the triangle
-    Color color;          // RGB color
+    PackedColor color;    // ARGB color, alpha set per frame from the age
     float angle;          // Current rotation angle
     float rotation_speed; // Speed of rotation in radians/second
     float age;            // Current age in seconds
     float max_age;        // Maximum lifetime in seconds
+    uint8_t index;        // Palette index in indexed mode (its explosion's run)
     bool active;          // Whether the particle is currently active
 } Particle;
 
@@ -45,4 +52,13 @@ void updateExplosion(float dt);
 // Render all active particles
 void renderExplosion(Canvas* canvas);
 
+// Render all active particles as outlines into the index buffer (see
+// Canvas_SetIndexed). Fading costs no per-particle work: every explosion's
+// palette entries are darkened with its age, overwriting palette entries
+// EXPLOSION_PALETTE_FIRST to EXPLOSION_PALETTE_FIRST + EXPLOSION_SLOTS * EXPLOSION_COLORS - 1.
+void renderExplosionIndexed(Canvas* canvas);
+
+// Whether any particle is still alive (the demo needs frames until none is)
+bool isExplosionActive(void);
+
 #endif // EXPLOSION_DEMO_H
@@ -0,0 +1,77 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include "canvas.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Output formats
+typedef enum {
+    CAPTURE_RAW, // Concatenated frames of little-endian ARGB8888 (bytes B, G, R, A)
+    CAPTURE_Y4M, // YUV4MPEG2 4:2:0, full range, e.g. for piping into an encoder
+    CAPTURE_PNG  // One uncompressed PNG per frame (see frameCapture_start for the names)
+} CaptureFormat;
+
+// Records the frames Canvas_Update finishes. The canvas copies each frame
+// into a preallocated ring and a writer thread streams the ring to disk.
+// When the ring is full the frame is dropped and counted, so a slow disk
+// never stalls drawing.
+typedef struct {
+    pthread_t       thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t  wake;       // signalled when a frame is queued or on stop
+    bool            stop;
+
+    uint32_t*       frames;     // ringFrames frames of width x height pixels
+    int             ringFrames;
+    int             head;       // Oldest queued frame
+    int             count;      // Queued frames
+
+    int             width;      // Frame size (the canvas' buffer size)
+    int             height;
+    int             fps;        // Frame rate written to the Y4M header
+    CaptureFormat   format;
+    char*           path;
+    FILE*           file;       // Output stream (RAW and Y4M)
+    uint8_t*        scratch;    // Writer-side conversion buffer (Y4M planes, PNG image)
+
+    long long       written;
+    long long       dropped;    // Ring full, wrong frame size or write error
+    bool            failed;     // A write failed; later frames are dropped
+} FrameCapture;
+
+// Pick the format from the path's extension (.png, .y4m, anything else raw)
+CaptureFormat frameCapture_formatForPath(const char* path);
+
+// Open the output and start the writer thread. Frames are width x height
+// (for a canvas: its bufferWidth x bufferHeight), ringFrames is the number
+// of frames that can be waiting for the disk.
+// PNG frames are named after path, which may hold the frame number as one
+// %d or %0Nd (e.g. frame_%05d.png) and no other '%'. Any other path is
+// taken literally, with "_%05d" inserted before its extension. A frame
+// whose name does not fit in 1023 characters fails to write.
+bool frameCapture_start(FrameCapture* capture, const char* path, CaptureFormat format,
+                        int width, int height, int fps, int ringFrames);
+
+// Queue a frame, or count it as dropped if the ring is full. Called from
+// the drawing thread; only copies the pixels.
+void frameCapture_submit(FrameCapture* capture, const uint32_t* pixels, int pitch,
+                         int width, int height);
+
+// Have Canvas_Update submit every finished frame of canvas
+bool frameCapture_attach(FrameCapture* capture, Canvas* canvas);
+
+// Stop submitting frames of canvas (needed before frameCapture_stop while
+// the canvas is still drawn)
+void frameCapture_detach(FrameCapture* capture, Canvas* canvas);
+
+// Write the queued frames, stop the thread and close the output.
+// Reports the written and dropped frame counts on stdout.
+void frameCapture_stop(FrameCapture* capture);
+
+// Frames dropped so far
+long long frameCapture_dropped(FrameCapture* capture);
+
+#endif // FRAME_CAPTURE_H
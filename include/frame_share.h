@@ -0,0 +1,92 @@
+#ifndef FRAME_SHARE_H
+#define FRAME_SHARE_H
+
+#include "canvas.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Publishes finished frames into a POSIX shared-memory ring that other local
+// processes map and read in place. The segment is a FrameShareHeader
+// followed by slotCount slots, each a FrameShareSlot followed by the pixels.
+//
+// Every slot is a seqlock: the writer makes its sequence odd, writes the
+// frame, then stores 2 * frame number. A reader takes the sequence, reads
+// the pixels and checks the sequence is unchanged; if not, the writer
+// reused the slot meanwhile and the read is discarded. The writer never
+// waits for readers, so a slow reader only misses frames.
+
+#define FRAME_SHARE_MAGIC   0x464C4354u // "TCLF"
+#define FRAME_SHARE_VERSION 1
+
+typedef struct {
+    uint32_t         magic;
+    uint32_t         version;
+    uint32_t         slotCount;
+    uint32_t         slotBytes;  // Distance between slots, header included
+    uint32_t         width;      // Largest frame the slots hold
+    uint32_t         height;
+    _Atomic uint64_t latest;     // Number of the newest complete frame (0 = none yet)
+} FrameShareHeader;
+
+typedef struct {
+    _Atomic uint64_t sequence;   // Odd while written, else 2 * frame
+    uint64_t         frame;      // Frame number, counting from 1
+    uint64_t         timestamp;  // CLOCK_MONOTONIC nanoseconds when published
+    uint32_t         width;
+    uint32_t         height;
+    uint32_t         pitch;      // Pixels between rows
+    uint32_t         reserved[7]; // Pads the slot header to 64 bytes
+} FrameShareSlot;
+
+// ARGB8888 pixels of a slot
+static inline const uint32_t* frameShare_pixels(const FrameShareSlot* slot) {
+    return (const uint32_t*)(slot + 1);
+}
+
+// Writer side
+typedef struct {
+    char*             name;
+    void*             base;
+    size_t            size;
+    FrameShareHeader* header;
+    uint64_t          frame;   // Frames published
+} FrameShare;
+
+// Create the segment name ("/tlacuilolli", say) for frames up to width x height,
+// replacing any stale segment of that name
+bool frameShare_create(FrameShare* share, const char* name, int width, int height, int slotCount);
+
+// Copy a frame into the next slot and make it the latest. Frames larger
+// than the segment's size are skipped.
+void frameShare_publish(FrameShare* share, const uint32_t* pixels, int pitch, int width, int height);
+
+// Have Canvas_Update publish every finished frame of canvas
+bool frameShare_attach(FrameShare* share, Canvas* canvas);
+void frameShare_detach(FrameShare* share, Canvas* canvas);
+
+// Unmap and remove the segment; readers keep their mapping until they close it
+void frameShare_destroy(FrameShare* share);
+
+// Reader side
+typedef struct {
+    const void*             base;
+    size_t                  size;
+    const FrameShareHeader* header;
+} FrameShareReader;
+
+// Map an existing segment read-only
+bool frameShare_openReader(FrameShareReader* reader, const char* name);
+
+// Newest complete frame and the sequence to validate it with, or NULL
+// when nothing was published yet (or the writer keeps overtaking the read)
+const FrameShareSlot* frameShare_latest(const FrameShareReader* reader, uint64_t* sequence);
+
+// True when the slot still holds the frame sequence was taken for, i.e.
+// everything read from it since frameShare_latest is consistent
+bool frameShare_valid(const FrameShareSlot* slot, uint64_t sequence);
+
+void frameShare_closeReader(FrameShareReader* reader);
+
+#endif // FRAME_SHARE_H
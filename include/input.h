@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 
+struct Camera;
+
 // Initialize input system with screen dimensions
 void inputInit(int width, int height);
 
@@ -21,4 +23,7 @@ bool isRightMousePressed(void);
 int  getMouseX(void);                 // canvas coords
 int  getMouseY(void);
 
+// Mouse position in world coordinates as seen through a camera (see camera.h)
+void getMouseWorld(const struct Camera* camera, float* x, float* y);
+
 #endif // INPUT_H
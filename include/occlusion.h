@@ -0,0 +1,80 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "canvas.h"
+#include "simd.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Edge of a coverage block in pixels: 8x8 pixels, one bit each (bit y*8 + x)
+#define COVERAGE_BLOCK_SIZE 8
+
+// Edge of a coverage tile in pixels: 8x8 blocks, one bit per full block
+#define COVERAGE_TILE_SIZE 64
+
+// Sort key of a primitive for coverage_sortFrontToBack. Like painter's
+// order, higher layers are over lower ones and, within a layer, higher
+// depths over lower ones (depth keeps its low 24 bits).
+#define COVERAGE_SORT_KEY(layer, depth) (((uint32_t)(layer) << 24) | ((uint32_t)(depth) & 0xFFFFFFu))
+
+// Hierarchical coverage buffer for drawing opaque shapes front to back.
+// Every pixel written this frame sets its bit, so a shape drawn later
+// only fills the pixels still uncovered, and a shape whose screen bounds
+// are covered already is rejected before it is rasterized. The tile masks
+// answer that test for large covered regions with one AND per tile.
+// Pixels outside the buffer count as covered.
+typedef struct {
+    uint64_t* blocks;          // Per 8x8 block, covered pixels
+    int       blocksX, blocksY;
+    uint64_t* tiles;           // Per 64x64 tile, full blocks (bit by*8 + bx)
+    int       tilesX, tilesY;
+    int       width, height;   // Buffer size the grid was built for
+
+    // Drawing order from coverage_sortFrontToBack, nearest first
+    int*      order;
+    int       orderCount;
+    int*      sortScratch;
+    uint32_t* keyScratch;      // 2 keys per primitive
+    int       capacity;
+
+    // Primitives rejected since coverage_begin
+    int       occluded;
+} CoverageBuffer;
+
+void coverage_init(CoverageBuffer* coverage);
+void coverage_free(CoverageBuffer* coverage);
+
+// Start a frame for a width x height buffer: nothing is covered yet.
+// False when out of memory.
+bool coverage_begin(CoverageBuffer* coverage, int width, int height);
+
+// Fill order with the visible primitives, nearest first: by key, highest
+// first, then by index, highest first. keys may be NULL to use index order
+// alone. False when out of memory.
+bool coverage_sortFrontToBack(CoverageBuffer* coverage, const bool* visible, const uint32_t* keys,
+                              int count);
+
+// True when every pixel of the inclusive screen rectangle is covered
+bool coverage_isOccluded(const CoverageBuffer* coverage, int minX, int minY, int maxX, int maxY);
+
+// Test count (up to SIMD_LANES) triangles given as center-origin vertices
+// one per lane, the bounds computed 4 or 8 at a time. Returns a bit per
+// lane whose triangle is covered or entirely off the buffer.
+unsigned coverage_testTriangles(CoverageBuffer* coverage, const int vx[3][SIMD_LANES],
+                                const int vy[3][SIMD_LANES], int count);
+
+// Covered pixels of one block row: bit i is pixel (bx*8 + i, y)
+static inline unsigned coverage_row(const CoverageBuffer* coverage, int bx, int y) {
+    return (unsigned)(coverage->blocks[(size_t)(y >> 3) * coverage->blocksX + bx] >> ((y & 7) * 8)) & 0xFFu;
+}
+
+// Mark pixels of one block row covered (bits as in coverage_row)
+static inline void coverage_addRow(CoverageBuffer* coverage, int bx, int y, unsigned bits) {
+    uint64_t* block = &coverage->blocks[(size_t)(y >> 3) * coverage->blocksX + bx];
+    *block |= (uint64_t)bits << ((y & 7) * 8);
+    if (*block == ~0ull) {
+        coverage->tiles[(size_t)(y >> 6) * coverage->tilesX + (bx >> 3)] |= 1ull << (((y >> 3) & 7) * 8 + (bx & 7));
+    }
+}
+
+#endif // OCCLUSION_H
@@ -29,7 +29,7 @@ typedef struct {
     float size;                // Size of the triangle
     float angle;               // Current rotation angle
     float angularVelocity;     // Rotation speed
-    Color color;               // Object color
+    PackedColor color;         // Object color (packed ARGB)
     bool active;               // Whether the object is currently active
 } PhysicsObject;
 
@@ -38,7 +38,7 @@ typedef struct {
     float cx, cy;         // Center position
     float width, height;   // Dimensions of the square
     float angle;          // Rotation angle (in radians)
-    Color color;          // Color of the square
+    PackedColor color;    // Color of the square (packed ARGB)
     bool active;          // Whether the obstacle is active
 } Obstacle;
 
@@ -54,9 +54,15 @@ void spawnProjectile(float x, float y, float targetX, float targetY);
 // Update all physics objects
 void updatePhysics(float dt);
 
-// Render all physics objects
+// Render all physics objects (obstacles, then the objects)
 void renderPhysics(Canvas* canvas);
 
+// Render only the obstacles. They never move, so a cached layer can draw them.
+void renderObstacles(Canvas* canvas);
+
+// Render only the moving physics objects
+void renderPhysicsObjects(Canvas* canvas);
+
 // Set the gravity scale factor (0.0 = no gravity, 1.0 = normal gravity)
 void setGravityScale(float scale);
 
@@ -0,0 +1,70 @@
+#ifndef POST_FX_H
+#define POST_FX_H
+
+#include "canvas.h"
+#include "worker_pool.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Most passes one chain holds
+#define POSTFX_MAX_PASSES 8
+
+// Largest blur radius (the 16-bit running sums hold up to 257 pixels)
+#define POSTFX_MAX_RADIUS 127
+
+typedef enum {
+    POSTFX_DECAY,  // Trails: keep the brighter of the frame and the faded last output
+    POSTFX_BLUR,   // Separable box blur, repeated (3 passes approximate a Gaussian)
+    POSTFX_BLOOM,  // Blur what lies above a threshold and add it back
+    POSTFX_GRADE   // Per-channel lookup tables
+} PostFxPassType;
+
+typedef struct {
+    PostFxPassType type;
+    int            keep;       // DECAY: 0..256 of the last output kept per frame
+    int            radius;     // BLUR, BLOOM: box radius in pixels
+    int            iterations; // BLUR, BLOOM: box blurs applied
+    int            threshold;  // BLOOM: channel level where the glow starts
+    int            strength;   // BLOOM: 0..256 of the glow added
+    uint32_t       lut[3][256]; // GRADE: red, green and blue outputs, already in place
+} PostFxPass;
+
+// Chain of full-screen passes run over the finished frame, before it is
+// presented. Every pass is split into row bands run by the workers, with
+// a barrier between passes (and between the halves of a blur).
+// The SSE2/AVX2 kernels give the same results as the scalar ones.
+typedef struct {
+    WorkerPool  pool;
+    PostFxPass  passes[POSTFX_MAX_PASSES];
+    int         passCount;
+
+    int         width, height; // Frame size the buffers are sized for
+    uint32_t*   history;       // DECAY: last output
+    uint32_t*   scratch[2];    // Blur intermediate and bloom glow
+    uint16_t*   columnSums;    // Vertical blur running sums, one row per worker
+
+    // Frame being processed
+    uint32_t*   pixels;
+    int         pitch;
+} PostFx;
+
+// Start the workers (0 = one per core). The chain must not be moved afterwards.
+bool postFx_init(PostFx* fx, int workerCount);
+
+// Stop the workers and free the buffers
+void postFx_free(PostFx* fx);
+
+// Append a pass; false when the chain is full
+bool postFx_addDecay(PostFx* fx, float keep);                  // keep: 0..1 per frame
+bool postFx_addBlur(PostFx* fx, int radius, int iterations);
+bool postFx_addBloom(PostFx* fx, int threshold, int radius, int iterations, float strength);
+bool postFx_addGrade(PostFx* fx, const uint8_t* red, const uint8_t* green, const uint8_t* blue); // 256 levels each
+
+// Remove every pass and forget the trail history
+void postFx_clear(PostFx* fx);
+
+// Run the chain over the canvas' back buffer and mark all of it dirty.
+// In indexed mode the index buffer is drawn over the result afterwards.
+void postFx_apply(PostFx* fx, Canvas* canvas);
+
+#endif // POST_FX_H
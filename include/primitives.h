@@ -0,0 +1,59 @@
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include "canvas.h"
+#include "blend.h"
+#include <stdint.h>
+
+// Span-based filled primitives.
+// Every shape is turned into one horizontal span per row and each span is
+// written with a vectorized row fill. Shapes take center-origin coordinates
+// (y up) like the rest of the drawing API and are clipped to the canvas.
+// A pixel is covered when its center lies inside the shape, so shapes that
+// share an edge neither overlap nor leave gaps. The *Blend variants take an
+// RGBA color and combine each span with the back buffer (see blend.h). The
+// *Packed variants take a ready ARGB8888 color (alpha included) and are what
+// the other entry points call after packing.
+
+// Write count copies of pixel starting at dst (SSE2/AVX2 when available)
+void fillRow(uint32_t* dst, int count, uint32_t pixel);
+
+// Fill pixels x0..x1 (inclusive) of screen row y (top-left origin), clipped to the canvas
+void fillSpan(Canvas* canvas, int y, int x0, int x1, uint32_t pixel);
+
+// Fill an axis-aligned rectangle centered at (cx, cy)
+void fillRect(Canvas* canvas, float cx, float cy, float width, float height, Color color);
+
+// Fill a disk centered at (cx, cy)
+void fillCircle(Canvas* canvas, float cx, float cy, float radius, Color color);
+
+// Fill a rectangle centered at (cx, cy) and rotated by angle radians
+void fillRotatedRect(Canvas* canvas, float cx, float cy, float width, float height,
+                     float angle, Color color);
+
+// Fill a convex polygon with count vertices given in order (either winding).
+// Any count works; past 64 vertices each call allocates scratch, and the
+// polygon is skipped if that fails.
+void fillConvexPolygon(Canvas* canvas, const float* xs, const float* ys, int count, Color color);
+
+// Translucent versions of the shapes above
+void fillRectBlend(Canvas* canvas, float cx, float cy, float width, float height,
+                   ColorRGBA color, BlendMode mode);
+void fillCircleBlend(Canvas* canvas, float cx, float cy, float radius,
+                     ColorRGBA color, BlendMode mode);
+void fillRotatedRectBlend(Canvas* canvas, float cx, float cy, float width, float height,
+                          float angle, ColorRGBA color, BlendMode mode);
+void fillConvexPolygonBlend(Canvas* canvas, const float* xs, const float* ys, int count,
+                            ColorRGBA color, BlendMode mode);
+
+// Packed-color versions, blended with mode (BLEND_REPLACE for opaque shapes)
+void fillRectPacked(Canvas* canvas, float cx, float cy, float width, float height,
+                    PackedColor color, BlendMode mode);
+void fillCirclePacked(Canvas* canvas, float cx, float cy, float radius,
+                      PackedColor color, BlendMode mode);
+void fillRotatedRectPacked(Canvas* canvas, float cx, float cy, float width, float height,
+                           float angle, PackedColor color, BlendMode mode);
+void fillConvexPolygonPacked(Canvas* canvas, const float* xs, const float* ys, int count,
+                             PackedColor color, BlendMode mode);
+
+#endif // PRIMITIVES_H
@@ -0,0 +1,88 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "canvas.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Edge length of a square scene tile in buffer pixels
+#define SCENE_TILE_SIZE 16
+
+// Handle of a primitive in a scene (-1 = none)
+typedef int SceneHandle;
+
+// Primitives of one tile, in handle order
+typedef struct {
+    int* items;
+    int  count;
+    int  capacity;
+} SceneBin;
+
+// Retained-mode triangle outlines. Primitives are added once and then
+// changed through their handles; the scene keeps their screen vertices and
+// the image they make, so a frame only redraws the tiles whose primitives
+// changed. Everything else is copied from the retained image.
+//
+// The output is what drawTrianglePacked draws for every primitive, in
+// handle order, over the background color.
+typedef struct {
+    // Per primitive, indexed by handle
+    float*       cx;        // center in canvas coords
+    float*       cy;
+    float*       size;      // half-height
+    float*       angle;     // radians
+    PackedColor* color;
+    int*         verts;     // 6 ints: buffer-space x0,y0,x1,y1,x2,y2
+    ClipRect*    bounds;    // Tiles the primitive is binned in (empty when in none)
+    uint8_t*     flags;     // SCENE_ALIVE, SCENE_CHANGED
+    int          count;     // Handles in use or freed
+    int          capacity;
+
+    int*         changed;   // Handles changed since the last scene_draw
+    int          changedCount;
+    int*         freeHandles; // Removed handles to reuse
+    int          freeCount;
+
+    // Tile grid over the buffer
+    int          tilesX, tilesY;
+    SceneBin*    bins;
+    uint8_t*     tileDirty;
+    int*         dirtyTiles; // Tiles to redraw in the next scene_draw
+    int          dirtyCount;
+
+    // Retained image, bufferWidth x bufferHeight of the canvas drawn last
+    uint32_t*    pixels;
+    int          width, height;
+    float        renderScale;
+    PackedColor  background;
+
+    // Where the image was copied last, to tell if that copy is still there
+    const uint32_t* target;
+    int          targetPitch;
+    uint64_t     targetFrame;
+} Scene;
+
+void scene_init(Scene* scene);
+void scene_free(Scene* scene);
+
+// Add a triangle outline (see drawTrianglePacked); -1 when out of memory
+SceneHandle scene_addTriangle(Scene* scene, float cx, float cy, float size, float angle,
+                              PackedColor color);
+
+// Move, resize or turn a triangle. Unchanged values cost nothing.
+void scene_setTriangle(Scene* scene, SceneHandle handle, float cx, float cy, float size, float angle);
+void scene_setColor(Scene* scene, SceneHandle handle, PackedColor color);
+
+// Remove a triangle; its handle may be handed out again
+void scene_remove(Scene* scene, SceneHandle handle);
+
+// Color of the pixels no primitive covers (default 0, what Canvas_BeginFrame clears to)
+void scene_setBackground(Scene* scene, PackedColor background);
+
+// Draw the scene over the whole canvas. Only tiles with changed primitives
+// are redrawn; when the canvas still holds the previous frame's copy, only
+// those tiles and the regions cleared or drawn over since are copied.
+// Anything drawn before this call is covered (the index buffer excepted).
+void scene_draw(Scene* scene, Canvas* canvas);
+
+#endif // SCENE_H
@@ -0,0 +1,40 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// SIMD capabilities detection
+#if defined(__AVX2__)
+  #define USE_AVX2 1
+  #include <immintrin.h>
+  #define SIMD_LANES 8
+  typedef __m256 simd_float;
+  typedef __m256i simd_int;
+#elif defined(__SSE2__)
+  #define USE_SSE2 1
+  #include <emmintrin.h>
+  #define SIMD_LANES 4
+  typedef __m128 simd_float;
+  typedef __m128i simd_int;
+#else
+  #define SIMD_LANES 1
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Bits of SIMD_LANES bool flags (lane l in bit l), e.g. of the visible
+// flags of triangles i to i + SIMD_LANES - 1
+static inline unsigned simd_boolBits(const bool* flags) {
+#if defined(__AVX2__)
+    uint64_t bytes;
+    memcpy(&bytes, flags, sizeof(bytes));
+    __m256i lanes = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long)bytes));
+    return (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(lanes, _mm256_setzero_si256())));
+#else
+    unsigned bits = 0;
+    for (int l = 0; l < SIMD_LANES; l++) bits |= (unsigned)flags[l] << l;
+    return bits;
+#endif
+}
+
+#endif // SIMD_H
@@ -0,0 +1,56 @@
+#ifndef STAMP_CACHE_H
+#define STAMP_CACHE_H
+
+#include "canvas.h"
+#include "triangle_simd.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Largest size cutoff: the outline of a triangle this big fits 64-bit rows
+#define STAMP_CACHE_MAX_SIZE 22
+
+// Size classes per pixel of half-height
+#define STAMP_SIZE_STEPS 4
+
+// Defaults for stampCache_init, tuned on the triangle demo (sizes 1 to 11)
+#define STAMP_CACHE_DEFAULT_SIZE  12
+#define STAMP_CACHE_DEFAULT_STEPS 64
+
+// Outline of one size class at one angle, as rows of pixel bits
+typedef struct {
+    int8_t   x, y;          // top-left pixel relative to the anchor pixel
+    uint8_t  width, height;
+    int      firstRow;      // index of its first row in the cache's rows
+} Stamp;
+
+// Pre-rasterized outlines of small triangles. Every size up to maxSize (in
+// steps of 1/STAMP_SIZE_STEPS px) at angleSteps angles is drawn once into
+// a bitmask, so a small triangle is drawn by stamping its pattern with
+// masked stores instead of computing sin/cos and walking three lines.
+// The pattern is the exact outline of the rounded size and angle around
+// the pixel holding the center, so pixels can differ from the exact path
+// by about a pixel (see bench/stamp_bench.c for the error).
+typedef struct {
+    int       maxSize;      // Largest stamped half-height, buffer pixels
+    int       angleSteps;   // Angles per full turn
+    int       sizeClasses;
+    Stamp*    stamps;       // sizeClasses x angleSteps
+    uint64_t* rows;         // Bit i of a row is pixel x + i of the stamp
+
+    // Visible flags left to the exact path by the last render
+    bool*     exact;
+    int       exactCapacity;
+    int       stamped;      // Triangles stamped by the last render
+} StampCache;
+
+// Rasterize the stamps: sizes up to maxSize (at most STAMP_CACHE_MAX_SIZE)
+// at angleSteps angles. False when out of memory or out of range.
+bool stampCache_init(StampCache* cache, int maxSize, int angleSteps);
+void stampCache_free(StampCache* cache);
+
+// Draw all visible triangles of data like renderTrianglesSIMD, stamping
+// those up to the cache's size (after the render scale) that lie fully on
+// the canvas and drawing the others exactly
+void renderTrianglesStamped(Canvas* canvas, TriangleDataSIMD* data, StampCache* cache);
+
+#endif // STAMP_CACHE_H
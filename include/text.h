@@ -7,7 +7,9 @@
 // Initialize text subsystem with the given font filename (from assets/fonts) and point size
 bool textInit(const char* fontFilename, int fontSize);
 
-// Draw a UTF-8 string centered at (cx, cy) on the canvas
+// Draw a UTF-8 string centered at (cx, cy) on the canvas. Below render
+// scale 1 the glyphs are shrunk with the buffer, so text keeps its size on
+// screen.
 void textDraw(Canvas* canvas, int cx, int cy, const char* text, Color color);
 
 // Shutdown and free text resources
@@ -0,0 +1,50 @@
+#ifndef TILE_RENDERER_H
+#define TILE_RENDERER_H
+
+#include "canvas.h"
+#include "triangle_simd.h"
+#include "worker_pool.h"
+#include <stdatomic.h>
+
+// Edge length of a square screen tile in pixels
+#define TILE_SIZE 64
+
+// Tile-binned multithreaded triangle rasterizer.
+// Triangles are transformed and binned into the screen tiles they overlap,
+// then the workers claim whole tiles and draw only the pixels inside them.
+// Tiles never overlap, so the framebuffer needs no locking, and triangles
+// keep their submission order inside every tile.
+typedef struct {
+    WorkerPool pool;
+
+    int tilesX, tilesY, tileCount;
+    int width, height;           // canvas size the tile grid was built for
+
+    // Per-triangle setup, screen space (capacity = triangleCapacity)
+    int*      verts;             // 6 ints per triangle: x0,y0,x1,y1,x2,y2
+    int*      tileRect;          // 4 ints per triangle: tx0,ty0,tx1,ty1 (tx0 > tx1 when skipped)
+    int       triangleCapacity;
+
+    // Binning
+    int*      binCounts;         // workerCount x tileCount counters
+    int*      binStart;          // tileCount + 1 offsets into binItems
+    int*      binItems;          // triangle indices grouped by tile
+    int       binCapacity;
+
+    atomic_int nextTile;         // work queue for the raster phase
+
+    // Inputs of the frame being rendered
+    Canvas*                 canvas;
+    const TriangleDataSIMD* data;
+} TileRenderer;
+
+// Start the worker threads (0 = one per core). The renderer must not be moved afterwards.
+bool tileRenderer_init(TileRenderer* renderer, int workerCount);
+
+// Stop the worker threads and free all bins
+void tileRenderer_free(TileRenderer* renderer);
+
+// Render all visible triangles of data using the tile workers
+void renderTrianglesTiled(TileRenderer* renderer, Canvas* canvas, const TriangleDataSIMD* data);
+
+#endif // TILE_RENDERER_H
@@ -2,6 +2,7 @@
 #define TRIANGLE_H
 
 #include "canvas.h"
+#include <stddef.h>
 
 // One triangle instance
 typedef struct {
@@ -15,7 +16,60 @@ typedef struct {
 // Draw a triangle wireframe outline to the canvas
 void drawTriangle(Canvas* canvas, const Triangle* t);
 
-// Draw a line between two points
+// Strided view of the triangles to draw: element i of a field is read from
+// (const char*)field + i * stride. Point the fields into an array of
+// structs (stride = sizeof(struct)) or at parallel arrays (sizeof(float)).
+typedef struct {
+    const float*       cx;           // center in canvas coords
+    const float*       cy;
+    const float*       size;         // half-height
+    const float*       angle;        // rotation (radians)
+    size_t             stride;       // bytes between two elements of cx, cy, size, angle
+    const PackedColor* color;
+    size_t             colorStride;  // 0 = stride
+    const bool*        active;       // NULL = draw every element
+    size_t             activeStride; // 0 = stride
+    int                count;
+} TriangleView;
+
+// Element i of a strided view field, e.g. TRIANGLE_VIEW_AT(float, view->cx, view->stride, i)
+#define TRIANGLE_VIEW_AT(type, field, stride, i) \
+    (*(const type*)((const char*)(field) + (size_t)(i) * (stride)))
+
+// Draw the outlines of all active triangles of a view. Triangles are culled
+// against the canvas and drawn in batches through the SIMD vertex transform,
+// covering the pixels renderTrianglesSIMD covers. The edge writes dominate,
+// so this is about as fast as a drawTrianglePacked call per triangle, not
+// faster (see bench/draw_triangles_bench.c); the demos draw per call.
+void drawTriangles(Canvas* canvas, const TriangleView* view);
+
+// Draw the outline of a triangle given by center, half-height and angle with a packed color
+void drawTrianglePacked(Canvas* canvas, float cx, float cy, float size, float angle, PackedColor color);
+
+// Buffer-space vertices of the outline drawTrianglePacked draws
+void triangleOutlineVertices(const Canvas* canvas, float cx, float cy, float size, float angle,
+                             int vx[3], int vy[3]);
+
+// Same outline written as a palette index into the canvas' indexed buffer
+void drawTriangleIndexed(Canvas* canvas, float cx, float cy, float size, float angle, uint8_t index);
+
+// Draw a line between two points (center-origin), clipped to the canvas
 void drawLine(Canvas* canvas, int x0, int y0, int x1, int y1, Color color);
 
+// Draw a line between two points (center-origin), clipped to a screen-space rect
+void drawLineClipped(Canvas* canvas, int x0, int y0, int x1, int y1, Color color, const ClipRect* clip);
+
+// Draw a line between two points (center-origin) with a packed color, clipped to the canvas
+void drawLinePacked(Canvas* canvas, int x0, int y0, int x1, int y1, PackedColor color);
+
+// Draw a line given in screen space with a packed ARGB pixel.
+// The clip rect must lie inside the canvas. Like the other screen-space
+// kernels this leaves dirty tracking to the caller (see Canvas_MarkDirty).
+void drawLineScreen(Canvas* canvas, int x0, int y0, int x1, int y1, PackedColor pixel, const ClipRect* clip);
+
+// Indexed-mode lines: write a palette index into canvas->indexBuffer (see Canvas_SetIndexed).
+// The screen-space kernel leaves dirty tracking to the caller (see Canvas_MarkIndexDirty).
+void drawLineIndexed(Canvas* canvas, int x0, int y0, int x1, int y1, uint8_t index);
+void drawLineScreenIndexed(Canvas* canvas, int x0, int y0, int x1, int y1, uint8_t index, const ClipRect* clip);
+
 #endif // TRIANGLE_H
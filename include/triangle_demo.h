@@ -10,14 +10,28 @@
 #define MOUSE_INFLUENCE_RADIUS 100.0f  // How far the mouse affects triangles
 #define MOUSE_FORCE_FACTOR    20.0f    // How strongly the mouse pushes triangles
 
+// How the triangle demo rasterizes its triangles
+typedef enum {
+    TRIANGLE_RENDER_DEFAULT,  // single-threaded SIMD path (or scalar in non-SIMD builds)
+    TRIANGLE_RENDER_TILED,    // tile-binned multithreaded path, one worker per core
+    TRIANGLE_RENDER_OCCLUDED, // filled, front to back, hidden triangles rejected (coverage buffer)
+    TRIANGLE_RENDER_STAMPED,  // small outlines stamped from pre-rasterized patterns (stamp cache)
+    TRIANGLE_RENDER_LOD,      // size buckets: points, 3x3 patterns, full outlines (triangle_lod.h)
+    TRIANGLE_RENDER_CAMERA    // LOD buckets seen through a turning, zooming camera (camera.h)
+} TriangleRenderMode;
+
 // Initialize the triangle demo with random triangles
 void initRandomTriangles(int canvasW, int canvasH);
 
 // Render all triangles in the demo, with optional frustum culling
 void renderRandomTriangles(Canvas* canvas, float dt);
 
+// Select the render path used by renderRandomTriangles
+void setTriangleRenderMode(TriangleRenderMode mode);
+
 // Update triangles based on mouse position
-// mouseX, mouseY: Mouse coordinates in window space
+// mouseX, mouseY: Mouse coordinates in window space (in the camera mode the
+// cursor is mapped through the camera with getMouseWorld instead)
 // canvasWidth, canvasHeight: Dimensions of the canvas
 // isPressed: Whether mouse button is being pressed
 void updateTrianglesWithMouse(int mouseX, int mouseY, int canvasWidth, int canvasHeight, int isPressed);
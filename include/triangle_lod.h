@@ -0,0 +1,45 @@
+#ifndef TRIANGLE_LOD_H
+#define TRIANGLE_LOD_H
+
+#include "canvas.h"
+#include "triangle_simd.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Default thresholds, in buffer pixels of projected height (2 * size * renderScale)
+#define LOD_POINT_BELOW   2.0f
+#define LOD_PATTERN_BELOW 4.0f
+
+// Orientations of the 3x3 pattern (a power of two)
+#define LOD_PATTERN_STEPS 16
+
+// Size-bucketed level of detail for triangle outlines. Each frame the
+// visible triangles are sorted by projected height into three buckets,
+// each drawn by its own kernel:
+// - points:   below pointBelow, the pixel holding the center (one store)
+// - patterns: below patternBelow, a 3x3 outline picked by angle
+// - full:     the rest, through renderTrianglesSIMD
+// Centers and pattern angles are computed 4 or 8 at a time (SSE2/AVX2).
+typedef struct {
+    float     pointBelow;    // Projected heights below this are points
+    float     patternBelow;  // Projected heights below this are patterns
+
+    uint16_t  patterns[LOD_PATTERN_STEPS]; // 3x3 outlines, bit row*3 + column
+
+    // Buckets of the last render: triangle indices, in submission order
+    int*      points;
+    int*      tiny;
+    bool*     full;          // Visible flags of the full bucket
+    int       capacity;
+    int       pointCount, tinyCount, fullCount;
+} TriangleLOD;
+
+// Set the thresholds (see LOD_POINT_BELOW) and build the patterns
+void triangleLOD_init(TriangleLOD* lod, float pointBelow, float patternBelow);
+void triangleLOD_free(TriangleLOD* lod);
+
+// Draw all visible triangles of data with the bucket each one falls in.
+// Points and patterns are drawn before the full triangles.
+void renderTrianglesLOD(Canvas* canvas, TriangleDataSIMD* data, TriangleLOD* lod);
+
+#endif // TRIANGLE_LOD_H
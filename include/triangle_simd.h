@@ -3,25 +3,10 @@
 
 #include "canvas.h"
 #include "triangle.h"
+#include "simd.h"
+#include "occlusion.h"
 #include <stdbool.h>
 
-// SIMD capabilities detection
-#if defined(__AVX2__)
-  #define USE_AVX2 1
-  #include <immintrin.h>
-  #define SIMD_LANES 8
-  typedef __m256 simd_float;
-  typedef __m256i simd_int;
-#elif defined(__SSE2__)
-  #define USE_SSE2 1
-  #include <emmintrin.h>
-  #define SIMD_LANES 4
-  typedef __m128 simd_float;
-  typedef __m128i simd_int;
-#else
-  #define SIMD_LANES 1
-#endif
-
 // Structure of Arrays (SoA) for SIMD-friendly triangle data
 typedef struct {
     // Aligned arrays for SIMD processing
@@ -30,7 +15,7 @@ typedef struct {
     float* size;       // sizes
     float* angle;      // current angles
     float* speed;      // rotation speeds
-    Color* color;      // colors
+    PackedColor* color; // colors, packed ARGB8888
     bool* visible;     // culling result
     int capacity;      // allocated size
     int count;         // actual count
@@ -48,12 +33,40 @@ void triangleDataSIMD_fromTriangles(TriangleDataSIMD* data, const Triangle* tria
 // Update triangle angles and perform culling using SIMD
 void updateAndCullSIMD(TriangleDataSIMD* data, float dt, int canvasWidth, int canvasHeight);
 
+// Compute the three integer vertices (canvas coords) of a triangle.
+// Below render scale 1, pass the center and size multiplied by canvas->renderScale.
+void calcTriangleVertices(float cx, float cy, float size, float angle, int vx[3], int vy[3]);
+
 // Render all visible triangles using SIMD-accelerated processing
 void renderTrianglesSIMD(Canvas* canvas, TriangleDataSIMD* data);
 
 // Draw a batch of 4 or 8 triangles (depending on SSE or AVX)
 void drawTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy, 
-                          const float* size, const float* angle, const Color* color,
+                          const float* size, const float* angle, const PackedColor* color,
                           int batchSize);
 
+// Draw count lines given in screen space as x0,y0,x1,y1 quadruples, clipped
+// to the canvas, in order with drawLineScreen and one dirty rectangle for
+// the whole set.
+void drawLinesBatchSIMD(Canvas* canvas, const int* lines, const PackedColor* pixel, int count);
+
+// Fill a single triangle using the SIMD edge-function rasterizer
+void fillTriangleSIMD(Canvas* canvas, const Triangle* t);
+
+// Fill count triangles given as SoA arrays (no culling)
+void fillTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy,
+                            const float* size, const float* angle, const PackedColor* color,
+                            int count);
+
+// Fill all visible triangles of the SoA data
+void renderFilledTrianglesSIMD(Canvas* canvas, TriangleDataSIMD* data);
+
+// Fill all visible triangles of the SoA data front to back, rejecting the
+// ones coverage shows hidden before they are rasterized. keys gives each
+// triangle's COVERAGE_SORT_KEY (NULL = submission order); the image is the
+// one filling them in key order gives. Falls back to
+// renderFilledTrianglesSIMD when coverage cannot get its buffers.
+void renderFilledTrianglesOccluded(Canvas* canvas, TriangleDataSIMD* data, CoverageBuffer* coverage,
+                                   const uint32_t* keys);
+
 #endif // TRIANGLE_SIMD_H
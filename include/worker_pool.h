@@ -0,0 +1,51 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+// Job run by every worker; workerIndex is in [0, workerCount)
+typedef void (*WorkerJob)(void* ctx, int workerIndex, int workerCount);
+
+struct WorkerThreadArg;
+
+// Persistent pool of worker threads. The thread calling workerPool_run()
+// takes part as worker 0, so a pool of N workers owns N-1 threads.
+typedef struct {
+    pthread_t*      threads;
+    struct WorkerThreadArg* args;
+    int             workerCount;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  wake;        // signalled when a new job is posted
+    pthread_cond_t  finished;    // signalled when the last worker is done
+    WorkerJob       job;
+    void*           ctx;
+    unsigned        generation;  // incremented for every posted job
+    int             busy;        // workers still running the current job
+    bool            shutdown;
+
+    // Reusable barrier for multi-phase jobs
+    pthread_mutex_t barrierMutex;
+    pthread_cond_t  barrierCond;
+    int             barrierWaiting;
+    unsigned        barrierPhase;
+} WorkerPool;
+
+// Start a pool with workerCount workers (0 = one per online CPU core)
+bool workerPool_init(WorkerPool* pool, int workerCount);
+
+// Stop and join all threads
+void workerPool_free(WorkerPool* pool);
+
+// Run job on every worker and return once all of them have finished
+void workerPool_run(WorkerPool* pool, WorkerJob job, void* ctx);
+
+// Block until every worker of the running job has reached the barrier.
+// Only valid from inside a job, and every worker must call it.
+void workerPool_barrier(WorkerPool* pool);
+
+// Number of online CPU cores (at least 1)
+int workerPool_cpuCount(void);
+
+#endif // WORKER_POOL_H
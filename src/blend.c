@@ -0,0 +1,251 @@
+#include "../include/blend.h"
+#include "../include/primitives.h"
+#include "../include/simd.h"
+
+// Exact round(x / 255) for x in [0, 255 * 255]
+static inline uint32_t div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// div255 on the two 16-bit fields of x (red/blue or green/alpha pairs)
+static inline uint32_t div255x2(uint32_t x) {
+    x += 0x00800080u;
+    return ((x + ((x >> 8) & 0x00FF00FFu)) >> 8) & 0x00FF00FFu;
+}
+
+// Scalar blend. Red and blue share one 32-bit word as two 16-bit fields, so
+// source-over and additive blending need two multiplies per channel pair.
+static inline uint32_t blendPixelInline(uint32_t dst, uint32_t src, BlendMode mode) {
+    uint32_t a = src >> 24;
+    uint32_t sRB = src & 0x00FF00FFu, sG = (src >> 8) & 0xFF;
+    uint32_t dRB = dst & 0x00FF00FFu, dG = (dst >> 8) & 0xFF;
+    uint32_t rb, g;
+    switch (mode) {
+        case BLEND_REPLACE:
+            return src | 0xFF000000u;
+        case BLEND_ALPHA:
+            rb = div255x2(sRB * a + dRB * (255 - a));
+            g = div255(sG * a + dG * (255 - a));
+            break;
+        case BLEND_ADD:
+            rb = dRB + div255x2(sRB * a);
+            rb = (rb | ((rb & 0x01000100u) - ((rb & 0x01000100u) >> 8))) & 0x00FF00FFu; // saturate
+            g = dG + div255(sG * a);
+            if (g > 255) g = 255;
+            break;
+        case BLEND_MULTIPLY:
+        default: {
+            uint32_t mR = div255(((src >> 16) & 0xFF) * a) + 255 - a;
+            uint32_t mB = div255((src & 0xFF) * a) + 255 - a;
+            uint32_t mG = div255(sG * a) + 255 - a;
+            rb = (div255(((dst >> 16) & 0xFF) * mR) << 16) | div255((dst & 0xFF) * mB);
+            g = div255(dG * mG);
+            break;
+        }
+    }
+    return 0xFF000000u | rb | (g << 8);
+}
+
+uint32_t blendPixel(uint32_t dst, uint32_t src, BlendMode mode) {
+    return blendPixelInline(dst, src, mode);
+}
+
+// The vector kernels widen each 8-bit channel to 16 bits, so one register
+// half holds two (SSE2) or four (AVX2) pixels as b,g,r,a words. The source
+// alpha word is broadcast to all four words of its pixel, the channel math
+// runs in 16 bits and the halves are packed back with unsigned saturation.
+#if defined(__AVX2__)
+static inline __m256i div255_256(__m256i x) {
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+static inline __m256i blendHalf256(__m256i d, __m256i s, __m256i a, BlendMode mode) {
+    const __m256i full = _mm256_set1_epi16(255);
+    switch (mode) {
+        case BLEND_ALPHA:
+            return div255_256(_mm256_add_epi16(_mm256_mullo_epi16(s, a),
+                                               _mm256_mullo_epi16(d, _mm256_sub_epi16(full, a))));
+        case BLEND_ADD:
+            return _mm256_add_epi16(d, div255_256(_mm256_mullo_epi16(s, a)));
+        case BLEND_MULTIPLY:
+        default: {
+            __m256i m = _mm256_add_epi16(div255_256(_mm256_mullo_epi16(s, a)), _mm256_sub_epi16(full, a));
+            return div255_256(_mm256_mullo_epi16(d, m));
+        }
+    }
+}
+
+// Blend 8 source pixels onto 8 destination pixels
+static inline __m256i blend8(__m256i d, __m256i s, BlendMode mode) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sLo = _mm256_unpacklo_epi8(s, zero);
+    __m256i sHi = _mm256_unpackhi_epi8(s, zero);
+    __m256i aLo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sLo, 0xFF), 0xFF);
+    __m256i aHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sHi, 0xFF), 0xFF);
+    __m256i lo = blendHalf256(_mm256_unpacklo_epi8(d, zero), sLo, aLo, mode);
+    __m256i hi = blendHalf256(_mm256_unpackhi_epi8(d, zero), sHi, aHi, mode);
+    return _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32((int)0xFF000000u));
+}
+
+#elif defined(__SSE2__)
+static inline __m128i div255_128(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+static inline __m128i blendHalf128(__m128i d, __m128i s, __m128i a, BlendMode mode) {
+    const __m128i full = _mm_set1_epi16(255);
+    switch (mode) {
+        case BLEND_ALPHA:
+            return div255_128(_mm_add_epi16(_mm_mullo_epi16(s, a),
+                                            _mm_mullo_epi16(d, _mm_sub_epi16(full, a))));
+        case BLEND_ADD:
+            return _mm_add_epi16(d, div255_128(_mm_mullo_epi16(s, a)));
+        case BLEND_MULTIPLY:
+        default: {
+            __m128i m = _mm_add_epi16(div255_128(_mm_mullo_epi16(s, a)), _mm_sub_epi16(full, a));
+            return div255_128(_mm_mullo_epi16(d, m));
+        }
+    }
+}
+
+// Blend 4 source pixels onto 4 destination pixels
+static inline __m128i blend4(__m128i d, __m128i s, BlendMode mode) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sLo = _mm_unpacklo_epi8(s, zero);
+    __m128i sHi = _mm_unpackhi_epi8(s, zero);
+    __m128i aLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sLo, 0xFF), 0xFF);
+    __m128i aHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sHi, 0xFF), 0xFF);
+    __m128i lo = blendHalf128(_mm_unpacklo_epi8(d, zero), sLo, aLo, mode);
+    __m128i hi = blendHalf128(_mm_unpackhi_epi8(d, zero), sHi, aHi, mode);
+    return _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32((int)0xFF000000u));
+}
+#endif
+
+void blendFillRow(uint32_t* dst, int count, uint32_t src, BlendMode mode) {
+    uint32_t a = src >> 24;
+    if (mode == BLEND_REPLACE || (mode == BLEND_ALPHA && a == 255)) {
+        fillRow(dst, count, src | 0xFF000000u);
+        return;
+    }
+    if (a == 0) return; // fully transparent: nothing changes in any mode
+
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i s = _mm256_set1_epi32((int)src);
+    for (; i + 8 <= count; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), blend8(d, s, mode));
+    }
+#elif defined(__SSE2__)
+    __m128i s = _mm_set1_epi32((int)src);
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        _mm_storeu_si128((__m128i*)(dst + i), blend4(d, s, mode));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = blendPixelInline(dst[i], src, mode);
+    }
+}
+
+void blendRow(uint32_t* dst, const uint32_t* src, int count, BlendMode mode) {
+    if (mode == BLEND_REPLACE) {
+        for (int i = 0; i < count; i++) dst[i] = src[i] | 0xFF000000u;
+        return;
+    }
+
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        // Skip groups that are fully transparent (the empty parts of glyph images)
+        if (_mm256_testz_si256(s, _mm256_set1_epi32((int)0xFF000000u))) continue;
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), blend8(d, s, mode));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        // Skip groups that are fully transparent (the empty parts of glyph images)
+        __m128i alpha = _mm_and_si128(s, _mm_set1_epi32((int)0xFF000000u));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) == 0xFFFF) continue;
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        _mm_storeu_si128((__m128i*)(dst + i), blend4(d, s, mode));
+    }
+#endif
+    for (; i < count; i++) {
+        if (src[i] >> 24) dst[i] = blendPixelInline(dst[i], src[i], mode);
+    }
+}
+
+void compositeRow(uint32_t* dst, const uint32_t* src, int count) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i a = _mm256_and_si256(s, alpha);
+        __m256i clear = _mm256_cmpeq_epi32(a, _mm256_setzero_si256());
+        int clearMask = _mm256_movemask_ps(_mm256_castsi256_ps(clear));
+        if (clearMask == 0xFF) continue;
+        int opaqueMask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, alpha)));
+        if (opaqueMask == 0xFF) {
+            _mm256_storeu_si256((__m256i*)(dst + i), s);
+            continue;
+        }
+        // Opaque pixels blend to exactly src; keep dst where src is transparent
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(blend8(d, s, BLEND_ALPHA), d, clear));
+    }
+#elif defined(__SSE2__)
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i a = _mm_and_si128(s, alpha);
+        __m128i clear = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+        if (_mm_movemask_epi8(clear) == 0xFFFF) continue;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, alpha)) == 0xFFFF) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+        // Opaque pixels blend to exactly src; keep dst where src is transparent
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i blended = blend4(d, s, BLEND_ALPHA);
+        _mm_storeu_si128((__m128i*)(dst + i),
+                         _mm_or_si128(_mm_and_si128(clear, d), _mm_andnot_si128(clear, blended)));
+    }
+#endif
+    for (; i < count; i++) {
+        uint32_t a = src[i] >> 24;
+        if (a == 255) dst[i] = src[i];
+        else if (a) dst[i] = blendPixelInline(dst[i], src[i], BLEND_ALPHA);
+    }
+}
+
+void blendSpan(Canvas* canvas, int y, int x0, int x1, uint32_t src, BlendMode mode) {
+    if (y < 0 || y >= canvas->bufferHeight) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 > canvas->bufferWidth - 1) x1 = canvas->bufferWidth - 1;
+    if (x0 > x1) return;
+    blendFillRow(canvas->backBuffer + (size_t)y * canvas->pitch + x0, x1 - x0 + 1, src, mode);
+    Canvas_MarkDirty(canvas, x0, y, x1 + 1, y + 1);
+}
+
+void blendBlit(Canvas* canvas, int x, int y, const uint32_t* src, int width, int height,
+               int srcPitch, BlendMode mode) {
+    // Clip the image rectangle to the canvas
+    int sx0 = x < 0 ? -x : 0;
+    int sy0 = y < 0 ? -y : 0;
+    int sx1 = x + width > canvas->bufferWidth ? canvas->bufferWidth - x : width;
+    int sy1 = y + height > canvas->bufferHeight ? canvas->bufferHeight - y : height;
+    if (sx0 >= sx1 || sy0 >= sy1) return;
+    Canvas_MarkDirty(canvas, x + sx0, y + sy0, x + sx1, y + sy1);
+
+    for (int sy = sy0; sy < sy1; sy++) {
+        uint32_t* dst = canvas->backBuffer + (size_t)(y + sy) * canvas->pitch + x + sx0;
+        blendRow(dst, src + (size_t)sy * srcPitch + sx0, sx1 - sx0, mode);
+    }
+}
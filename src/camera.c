@@ -0,0 +1,204 @@
+#include "../include/camera.h"
+#include <math.h>
+
+// Half-heights around the center that hold the whole outline at any angle
+#define CAMERA_EXTENT 1.5f
+
+// World to view space, zoom folded into the rotation; half the canvas in
+// canvas units, with the cull margin drawTriangles uses
+typedef struct {
+    float x, y;          // Camera position
+    float c, s;          // zoom * cos(rotation), zoom * sin(rotation)
+    float zoom, rotation;
+    float halfW, halfH;
+} ViewTransform;
+
+static ViewTransform viewTransform(const Camera* camera, const Canvas* canvas) {
+    ViewTransform t;
+    t.x = camera->x;
+    t.y = camera->y;
+    t.c = cosf(camera->rotation) * camera->zoom;
+    t.s = sinf(camera->rotation) * camera->zoom;
+    t.zoom = camera->zoom;
+    t.rotation = camera->rotation;
+    t.halfW = (canvas->bufferWidth * 0.5f + 2.0f) / canvas->renderScale;
+    t.halfH = (canvas->bufferHeight * 0.5f + 2.0f) / canvas->renderScale;
+    return t;
+}
+
+void camera_init(Camera* camera) {
+    camera->x = 0.0f;
+    camera->y = 0.0f;
+    camera->zoom = 1.0f;
+    camera->rotation = 0.0f;
+}
+
+bool camera_setZoom(Camera* camera, float zoom) {
+    if (!(zoom > 0.0f) || isinf(zoom)) return false;
+    camera->zoom = zoom;
+    return true;
+}
+
+// Same arithmetic as the SIMD transform, so a mapped point lands exactly
+// where renderTrianglesCamera draws a center
+void camera_worldToCanvas(const Camera* camera, float wx, float wy, float* cx, float* cy) {
+    float c = cosf(camera->rotation) * camera->zoom, s = sinf(camera->rotation) * camera->zoom;
+    float dx = wx - camera->x, dy = wy - camera->y;
+    *cx = dx * c + dy * s;
+    *cy = dy * c - dx * s;
+}
+
+void camera_canvasToWorld(const Camera* camera, float cx, float cy, float* wx, float* wy) {
+    float c = cosf(camera->rotation), s = sinf(camera->rotation);
+    float dx = cx / camera->zoom, dy = cy / camera->zoom;
+    *wx = camera->x + dx * c - dy * s;
+    *wy = camera->y + dx * s + dy * c;
+}
+
+void camera_viewBounds(const Camera* camera, const Canvas* canvas,
+                       float* minX, float* minY, float* maxX, float* maxY) {
+    float c = fabsf(cosf(camera->rotation)), s = fabsf(sinf(camera->rotation));
+    float halfW = canvas->width * 0.5f, halfH = canvas->height * 0.5f;
+    float extentX = (halfW * c + halfH * s) / camera->zoom;
+    float extentY = (halfW * s + halfH * c) / camera->zoom;
+    *minX = camera->x - extentX;
+    *maxX = camera->x + extentX;
+    *minY = camera->y - extentY;
+    *maxY = camera->y + extentY;
+}
+
+void camera_updateAndCull(const Camera* camera, const Canvas* canvas, TriangleDataSIMD* data, float dt) {
+    const ViewTransform t = viewTransform(camera, canvas);
+    const float extentScale = CAMERA_EXTENT * t.zoom;
+#if defined(__AVX2__)
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 dt_vec = _mm256_set1_ps(dt);
+    const __m256 camX = _mm256_set1_ps(t.x), camY = _mm256_set1_ps(t.y);
+    const __m256 c = _mm256_set1_ps(t.c), s = _mm256_set1_ps(t.s);
+    const __m256 extent = _mm256_set1_ps(extentScale);
+    const __m256 halfW = _mm256_set1_ps(t.halfW), halfH = _mm256_set1_ps(t.halfH);
+#elif defined(__SSE2__)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 dt_vec = _mm_set1_ps(dt);
+    const __m128 camX = _mm_set1_ps(t.x), camY = _mm_set1_ps(t.y);
+    const __m128 c = _mm_set1_ps(t.c), s = _mm_set1_ps(t.s);
+    const __m128 extent = _mm_set1_ps(extentScale);
+    const __m128 halfW = _mm_set1_ps(t.halfW), halfH = _mm_set1_ps(t.halfH);
+#endif
+
+    for (int i = 0; i < data->count; i += SIMD_LANES) {
+#if defined(__AVX2__)
+        __m256 angle = _mm256_add_ps(_mm256_load_ps(data->angle + i),
+                                     _mm256_mul_ps(_mm256_load_ps(data->speed + i), dt_vec));
+        _mm256_store_ps(data->angle + i, angle);
+
+        // Center in view space against the view rectangle, grown by the extent
+        __m256 dx = _mm256_sub_ps(_mm256_load_ps(data->cx + i), camX);
+        __m256 dy = _mm256_sub_ps(_mm256_load_ps(data->cy + i), camY);
+        __m256 vx = _mm256_add_ps(_mm256_mul_ps(dx, c), _mm256_mul_ps(dy, s));
+        __m256 vy = _mm256_sub_ps(_mm256_mul_ps(dy, c), _mm256_mul_ps(dx, s));
+        __m256 ext = _mm256_mul_ps(_mm256_and_ps(_mm256_load_ps(data->size + i), absMask), extent);
+        __m256 outside = _mm256_or_ps(
+            _mm256_cmp_ps(_mm256_sub_ps(_mm256_and_ps(vx, absMask), ext), halfW, _CMP_GT_OQ),
+            _mm256_cmp_ps(_mm256_sub_ps(_mm256_and_ps(vy, absMask), ext), halfH, _CMP_GT_OQ));
+        unsigned outsideMask = (unsigned)_mm256_movemask_ps(outside);
+#elif defined(__SSE2__)
+        __m128 angle = _mm_add_ps(_mm_load_ps(data->angle + i),
+                                  _mm_mul_ps(_mm_load_ps(data->speed + i), dt_vec));
+        _mm_store_ps(data->angle + i, angle);
+
+        __m128 dx = _mm_sub_ps(_mm_load_ps(data->cx + i), camX);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(data->cy + i), camY);
+        __m128 vx = _mm_add_ps(_mm_mul_ps(dx, c), _mm_mul_ps(dy, s));
+        __m128 vy = _mm_sub_ps(_mm_mul_ps(dy, c), _mm_mul_ps(dx, s));
+        __m128 ext = _mm_mul_ps(_mm_and_ps(_mm_load_ps(data->size + i), absMask), extent);
+        __m128 outside = _mm_or_ps(_mm_cmpgt_ps(_mm_sub_ps(_mm_and_ps(vx, absMask), ext), halfW),
+                                   _mm_cmpgt_ps(_mm_sub_ps(_mm_and_ps(vy, absMask), ext), halfH));
+        unsigned outsideMask = (unsigned)_mm_movemask_ps(outside);
+#else
+        data->angle[i] += data->speed[i] * dt;
+
+        float dx = data->cx[i] - t.x, dy = data->cy[i] - t.y;
+        float vx = dx * t.c + dy * t.s;
+        float vy = dy * t.c - dx * t.s;
+        float ext = fabsf(data->size[i]) * extentScale;
+        unsigned outsideMask = fabsf(vx) - ext > t.halfW || fabsf(vy) - ext > t.halfH;
+#endif
+        for (int l = 0; l < SIMD_LANES && i + l < data->count; l++) {
+            data->visible[i + l] = !((outsideMask >> l) & 1);
+        }
+    }
+}
+
+void renderTrianglesCamera(Canvas* canvas, const Camera* camera, const TriangleDataSIMD* world,
+                           TriangleDataSIMD* view, TriangleLOD* lod) {
+    if (view->capacity < world->count) {
+        if (view->capacity) triangleDataSIMD_free(view);
+        triangleDataSIMD_init(view, world->count);
+        if (!view->cx || !view->cy || !view->size || !view->angle || !view->color || !view->visible) {
+            view->count = 0;
+            return;
+        }
+    }
+
+    const ViewTransform t = viewTransform(camera, canvas);
+#if defined(__AVX2__)
+    const __m256 camX = _mm256_set1_ps(t.x), camY = _mm256_set1_ps(t.y);
+    const __m256 c = _mm256_set1_ps(t.c), s = _mm256_set1_ps(t.s);
+    const __m256 zoom = _mm256_set1_ps(t.zoom), rotation = _mm256_set1_ps(t.rotation);
+#elif defined(__SSE2__)
+    const __m128 camX = _mm_set1_ps(t.x), camY = _mm_set1_ps(t.y);
+    const __m128 c = _mm_set1_ps(t.c), s = _mm_set1_ps(t.s);
+    const __m128 zoom = _mm_set1_ps(t.zoom), rotation = _mm_set1_ps(t.rotation);
+#endif
+
+    // Batches without a visible triangle cost one test; the others are
+    // transformed whole and their visible lanes packed into view
+    int count = 0;
+    for (int i = 0; i < world->count; i += SIMD_LANES) {
+        int left = world->count - i;
+        unsigned live = left >= SIMD_LANES ? (1u << SIMD_LANES) - 1 : (1u << left) - 1;
+        unsigned visible = simd_boolBits(world->visible + i) & live;
+        if (!visible) continue;
+
+        float vx[SIMD_LANES], vy[SIMD_LANES], vsize[SIMD_LANES], vangle[SIMD_LANES];
+#if defined(__AVX2__)
+        __m256 dx = _mm256_sub_ps(_mm256_load_ps(world->cx + i), camX);
+        __m256 dy = _mm256_sub_ps(_mm256_load_ps(world->cy + i), camY);
+        _mm256_storeu_ps(vx, _mm256_add_ps(_mm256_mul_ps(dx, c), _mm256_mul_ps(dy, s)));
+        _mm256_storeu_ps(vy, _mm256_sub_ps(_mm256_mul_ps(dy, c), _mm256_mul_ps(dx, s)));
+        _mm256_storeu_ps(vsize, _mm256_mul_ps(_mm256_load_ps(world->size + i), zoom));
+        _mm256_storeu_ps(vangle, _mm256_sub_ps(_mm256_load_ps(world->angle + i), rotation));
+#elif defined(__SSE2__)
+        __m128 dx = _mm_sub_ps(_mm_load_ps(world->cx + i), camX);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(world->cy + i), camY);
+        _mm_storeu_ps(vx, _mm_add_ps(_mm_mul_ps(dx, c), _mm_mul_ps(dy, s)));
+        _mm_storeu_ps(vy, _mm_sub_ps(_mm_mul_ps(dy, c), _mm_mul_ps(dx, s)));
+        _mm_storeu_ps(vsize, _mm_mul_ps(_mm_load_ps(world->size + i), zoom));
+        _mm_storeu_ps(vangle, _mm_sub_ps(_mm_load_ps(world->angle + i), rotation));
+#else
+        float dx = world->cx[i] - t.x, dy = world->cy[i] - t.y;
+        vx[0] = dx * t.c + dy * t.s;
+        vy[0] = dy * t.c - dx * t.s;
+        vsize[0] = world->size[i] * t.zoom;
+        vangle[0] = world->angle[i] - t.rotation;
+#endif
+        for (; visible; visible &= visible - 1) {
+            int l = __builtin_ctz(visible);
+            view->cx[count] = vx[l];
+            view->cy[count] = vy[l];
+            view->size[count] = vsize[l];
+            view->angle[count] = vangle[l];
+            view->color[count] = world->color[i + l];
+            view->visible[count] = true;
+            count++;
+        }
+    }
+    view->count = count;
+
+    if (lod) {
+        renderTrianglesLOD(canvas, view, lod);
+    } else {
+        renderTrianglesSIMD(canvas, view);
+    }
+}
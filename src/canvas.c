@@ -1,5 +1,24 @@
 #include "../include/canvas.h"
+#include "../include/simd.h"
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Create the renderer and the streaming texture frames are presented through
+static bool createRenderer(Canvas* canvas) {
+    canvas->renderer = SDL_CreateRenderer(
+        canvas->window, -1, SDL_RENDERER_ACCELERATED
+    );
+    if (!canvas->renderer) return false;
+
+    canvas->texture = SDL_CreateTexture(
+        canvas->renderer,
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STREAMING,
+        canvas->width, canvas->height
+    );
+    return canvas->texture != NULL;
+}
 
 bool Canvas_Init(Canvas* canvas, int width, int height) {
     if (SDL_Init(SDL_INIT_VIDEO) != 0) return false;
@@ -12,69 +31,542 @@ bool Canvas_Init(Canvas* canvas, int width, int height) {
     );
     if (!canvas->window) return false;
 
-    canvas->renderer = SDL_CreateRenderer(
-        canvas->window, -1, SDL_RENDERER_ACCELERATED
-    );
-    if (!canvas->renderer) return false;
+    canvas->renderer = NULL;
+    canvas->texture = NULL;
+    if (!createRenderer(canvas)) return false;
 
-    canvas->texture = SDL_CreateTexture(
-        canvas->renderer,
-        SDL_PIXELFORMAT_ARGB8888,
-        SDL_TEXTUREACCESS_STREAMING,
-        width, height
-    );
-    if (!canvas->texture) return false;
+    // The back buffer starts at full resolution, copied into the texture
+    canvas->presentMode = PRESENT_COPY;
+    canvas->presentPixels = NULL;
+    canvas->backBuffer = NULL;
+    canvas->ownedBuffer = NULL;
+    canvas->scaledBuffer = NULL;
+    canvas->indexBuffer = NULL;
+    canvas->frameSinkCount = 0;
+    canvas->frameCount = 0;
+    if (!Canvas_SetRenderScale(canvas, 1.0f)) return false;
 
-    // Allocate front buffer
-    canvas->pixels = calloc((size_t)width * height, sizeof(uint32_t));
-    if (!canvas->pixels) return false;
+    // Indexed mode starts disabled, with an all-black palette
+    for (int i = 0; i < CANVAS_PALETTE_SIZE; i++) {
+        canvas->palette[i] = 0xFF000000u;
+    }
     
-    // Allocate back buffer
-    canvas->backBuffer = calloc((size_t)width * height, sizeof(uint32_t));
-    if (!canvas->backBuffer) {
-        free(canvas->pixels);
+    return true;
+}
+
+bool Canvas_InitHeadless(Canvas* canvas, int width, int height) {
+    memset(canvas, 0, sizeof(*canvas));
+    canvas->width  = width;
+    canvas->height = height;
+    canvas->presentMode = PRESENT_HEADLESS;
+    if (!Canvas_SetRenderScale(canvas, 1.0f)) {
+        Canvas_Destroy(canvas);
         return false;
     }
-    
+    for (int i = 0; i < CANVAS_PALETTE_SIZE; i++) {
+        canvas->palette[i] = 0xFF000000u;
+    }
+    return true;
+}
+
+bool Canvas_AddFrameSink(Canvas* canvas, CanvasFrameSink sink, void* data) {
+    if (canvas->frameSinkCount == CANVAS_MAX_FRAME_SINKS) return false;
+    canvas->frameSinks[canvas->frameSinkCount] = sink;
+    canvas->frameSinkData[canvas->frameSinkCount] = data;
+    canvas->frameSinkCount++;
+    return true;
+}
+
+void Canvas_RemoveFrameSink(Canvas* canvas, CanvasFrameSink sink, void* data) {
+    for (int i = 0; i < canvas->frameSinkCount; i++) {
+        if (canvas->frameSinks[i] == sink && canvas->frameSinkData[i] == data) {
+            for (int j = i + 1; j < canvas->frameSinkCount; j++) {
+                canvas->frameSinks[j - 1] = canvas->frameSinks[j];
+                canvas->frameSinkData[j - 1] = canvas->frameSinkData[j];
+            }
+            canvas->frameSinkCount--;
+            return;
+        }
+    }
+}
+
+static void setFullRect(const Canvas* canvas, DirtyRects* d) {
+    d->rects[0] = (ClipRect){ 0, 0, canvas->bufferWidth, canvas->bufferHeight };
+    d->count = 1;
+}
+
+// Point the back buffer at the heap buffer or, when drawing in place, at
+// SDL's memory. SDL's memory holds whatever it held, so unless keep is set
+// the next Canvas_BeginFrame clears all of it.
+static void bindBackBuffer(Canvas* canvas, bool keep) {
+    if (canvas->ownedBuffer) {
+        canvas->backBuffer = canvas->ownedBuffer;
+        canvas->pitch = canvas->bufferWidth;
+        return;
+    }
+    canvas->backBuffer = canvas->presentPixels;
+    canvas->pitch = canvas->presentPitch;
+    if (!keep) setFullRect(canvas, &canvas->prevDirty);
+}
+
+static void renderTexture(Canvas* canvas) {
+    SDL_RenderClear(canvas->renderer);
+    SDL_RenderCopy(canvas->renderer, canvas->texture, NULL, NULL);
+    SDL_RenderPresent(canvas->renderer);
+}
+
+// Lock the texture or the window surface for drawing (zero-copy modes)
+static bool acquirePresentPixels(Canvas* canvas) {
+    if (canvas->presentMode == PRESENT_LOCK_TEXTURE) {
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(canvas->texture, NULL, &pixels, &pitch) != 0) return false;
+        canvas->presentPixels = pixels;
+        canvas->presentPitch = pitch / (int)sizeof(uint32_t);
+    } else if (canvas->presentMode == PRESENT_WINDOW_SURFACE) {
+        SDL_Surface* surface = SDL_GetWindowSurface(canvas->window);
+        if (!surface) return false;
+        if (SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0) return false;
+        canvas->presentPixels = surface->pixels;
+        canvas->presentPitch = surface->pitch / (int)sizeof(uint32_t);
+    }
     return true;
 }
 
+static void releasePresentPixels(Canvas* canvas) {
+    if (!canvas->presentPixels) return;
+    if (canvas->presentMode == PRESENT_LOCK_TEXTURE) {
+        SDL_UnlockTexture(canvas->texture);
+    } else if (canvas->presentMode == PRESENT_WINDOW_SURFACE) {
+        SDL_Surface* surface = SDL_GetWindowSurface(canvas->window);
+        if (surface && SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+    }
+    canvas->presentPixels = NULL;
+}
+
+bool Canvas_SetPresentMode(Canvas* canvas, PresentMode mode) {
+    if (mode == canvas->presentMode) return true;
+    if (!canvas->window || mode == PRESENT_HEADLESS) return false;
+    releasePresentPixels(canvas);
+
+    bool ok = true;
+    if (mode == PRESENT_WINDOW_SURFACE) {
+        // A window cannot have both a renderer and a surface
+        SDL_DestroyTexture(canvas->texture);
+        SDL_DestroyRenderer(canvas->renderer);
+        canvas->texture = NULL;
+        canvas->renderer = NULL;
+        SDL_Surface* surface = SDL_GetWindowSurface(canvas->window);
+        ok = surface && (surface->format->format == SDL_PIXELFORMAT_ARGB8888 ||
+                         surface->format->format == SDL_PIXELFORMAT_RGB888);
+    } else if (!canvas->renderer) {
+        ok = createRenderer(canvas);
+    }
+    canvas->presentMode = mode;
+    if (ok) ok = acquirePresentPixels(canvas);
+
+    if (!ok) {
+        fprintf(stderr, "Error: Present mode %d unavailable, copying frames instead\n", (int)mode);
+        releasePresentPixels(canvas);
+        canvas->presentMode = PRESENT_COPY;
+        if (!canvas->renderer && !createRenderer(canvas)) return false;
+    }
+
+    // Drop or allocate the buffers the new mode needs
+    return Canvas_SetRenderScale(canvas, canvas->renderScale) && ok;
+}
+
+bool Canvas_SetRenderScale(Canvas* canvas, float renderScale) {
+    if (!(renderScale > 0.0f) || renderScale > 1.0f) renderScale = 1.0f;
+    int bufferWidth = (int)lroundf(canvas->width * renderScale);
+    int bufferHeight = (int)lroundf(canvas->height * renderScale);
+    if (bufferWidth < 1) bufferWidth = 1;
+    if (bufferHeight < 1) bufferHeight = 1;
+    size_t size = (size_t)bufferWidth * bufferHeight;
+    bool indexed = canvas->indexBuffer != NULL;
+
+    // At full resolution the zero-copy modes draw straight into SDL's memory,
+    // below it they upscale into it
+    bool zeroCopy = canvas->presentMode == PRESENT_LOCK_TEXTURE ||
+                    canvas->presentMode == PRESENT_WINDOW_SURFACE;
+    bool inPlace = zeroCopy && renderScale == 1.0f;
+    bool copyScaled = canvas->presentMode == PRESENT_COPY && renderScale < 1.0f;
+
+    free(canvas->ownedBuffer);
+    free(canvas->scaledBuffer);
+    free(canvas->indexBuffer);
+    canvas->ownedBuffer = inPlace ? NULL : calloc(size, sizeof(uint32_t));
+    canvas->indexBuffer = indexed ? calloc(size, sizeof(uint8_t)) : NULL;
+    canvas->scaledBuffer = copyScaled
+        ? calloc((size_t)canvas->width * canvas->height, sizeof(uint32_t)) : NULL;
+    canvas->bufferWidth = bufferWidth;
+    canvas->bufferHeight = bufferHeight;
+    canvas->renderScale = renderScale;
+
+    // Fresh heap buffers are black and the screen has to be refilled at the new size
+    canvas->dirty.count = 0;
+    canvas->prevDirty.count = 0;
+    canvas->indexDirty.count = 0;
+    canvas->prevIndexDirty.count = 0;
+    canvas->uploadAll = true;
+    bindBackBuffer(canvas, false);
+
+    if (!canvas->backBuffer || (indexed && !canvas->indexBuffer) ||
+        (copyScaled && !canvas->scaledBuffer)) {
+        return false;
+    }
+    return true;
+}
+
+// Add r to a dirty list, merging it into the first rectangle it overlaps or
+// touches. A full list absorbs r into the rectangle that grows the least.
+static void addDirtyRect(DirtyRects* d, ClipRect r) {
+    for (int i = 0; i < d->count; i++) {
+        ClipRect* e = &d->rects[i];
+        if (r.minX <= e->maxX && r.maxX >= e->minX && r.minY <= e->maxY && r.maxY >= e->minY) {
+            if (r.minX < e->minX) e->minX = r.minX;
+            if (r.minY < e->minY) e->minY = r.minY;
+            if (r.maxX > e->maxX) e->maxX = r.maxX;
+            if (r.maxY > e->maxY) e->maxY = r.maxY;
+            return;
+        }
+    }
+    if (d->count < CANVAS_MAX_DIRTY_RECTS) {
+        d->rects[d->count++] = r;
+        return;
+    }
+
+    int best = 0;
+    long long bestGrowth = -1;
+    for (int i = 0; i < d->count; i++) {
+        const ClipRect* e = &d->rects[i];
+        int minX = r.minX < e->minX ? r.minX : e->minX;
+        int minY = r.minY < e->minY ? r.minY : e->minY;
+        int maxX = r.maxX > e->maxX ? r.maxX : e->maxX;
+        int maxY = r.maxY > e->maxY ? r.maxY : e->maxY;
+        long long growth = (long long)(maxX - minX) * (maxY - minY) -
+                           (long long)(e->maxX - e->minX) * (e->maxY - e->minY);
+        if (bestGrowth < 0 || growth < bestGrowth) {
+            best = i;
+            bestGrowth = growth;
+        }
+    }
+    ClipRect* e = &d->rects[best];
+    if (r.minX < e->minX) e->minX = r.minX;
+    if (r.minY < e->minY) e->minY = r.minY;
+    if (r.maxX > e->maxX) e->maxX = r.maxX;
+    if (r.maxY > e->maxY) e->maxY = r.maxY;
+}
+
+void Canvas_MarkDirty(Canvas* canvas, int x0, int y0, int x1, int y1) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > canvas->bufferWidth) x1 = canvas->bufferWidth;
+    if (y1 > canvas->bufferHeight) y1 = canvas->bufferHeight;
+    if (x0 >= x1 || y0 >= y1) return;
+    addDirtyRect(&canvas->dirty, (ClipRect){ x0, y0, x1, y1 });
+}
+
+void Canvas_MarkAllDirty(Canvas* canvas) {
+    setFullRect(canvas, &canvas->dirty);
+}
+
+void Canvas_MarkIndexDirty(Canvas* canvas, int x0, int y0, int x1, int y1) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > canvas->bufferWidth) x1 = canvas->bufferWidth;
+    if (y1 > canvas->bufferHeight) y1 = canvas->bufferHeight;
+    if (x0 >= x1 || y0 >= y1) return;
+    addDirtyRect(&canvas->indexDirty, (ClipRect){ x0, y0, x1, y1 });
+}
+
+void Canvas_BeginFrame(Canvas* canvas) {
+    for (int i = 0; i < canvas->prevDirty.count; i++) {
+        const ClipRect* r = &canvas->prevDirty.rects[i];
+        size_t rowBytes = (size_t)(r->maxX - r->minX) * sizeof(uint32_t);
+        for (int y = r->minY; y < r->maxY; y++) {
+            memset(canvas->backBuffer + (size_t)y * canvas->pitch + r->minX, 0, rowBytes);
+        }
+    }
+    if (!canvas->indexBuffer) return;
+    for (int i = 0; i < canvas->prevIndexDirty.count; i++) {
+        const ClipRect* r = &canvas->prevIndexDirty.rects[i];
+        for (int y = r->minY; y < r->maxY; y++) {
+            memset(canvas->indexBuffer + (size_t)y * canvas->bufferWidth + r->minX, 0,
+                   (size_t)(r->maxX - r->minX));
+        }
+    }
+}
+
 void Canvas_Destroy(Canvas* canvas) {
-    free(canvas->pixels);
-    free(canvas->backBuffer);
-    SDL_DestroyTexture(canvas->texture);
-    SDL_DestroyRenderer(canvas->renderer);
+    releasePresentPixels(canvas);
+    free(canvas->ownedBuffer);
+    free(canvas->indexBuffer);
+    free(canvas->scaledBuffer);
+    if (canvas->presentMode == PRESENT_HEADLESS) return; // SDL was never initialized
+    if (canvas->texture) SDL_DestroyTexture(canvas->texture);
+    if (canvas->renderer) SDL_DestroyRenderer(canvas->renderer);
     SDL_DestroyWindow(canvas->window);
     SDL_Quit();
 }
 
+void Canvas_PutPixelPacked(Canvas* canvas, int cx, int cy, PackedColor color) {
+    int sx = canvas->bufferWidth/2 + Canvas_ScaleInt(canvas, cx);
+    int sy = canvas->bufferHeight/2 - Canvas_ScaleInt(canvas, cy);
+    if (sx < 0 || sy < 0 || sx >= canvas->bufferWidth || sy >= canvas->bufferHeight)
+        return;
+    canvas->backBuffer[(size_t)sy * canvas->pitch + sx] = color;
+    Canvas_MarkDirty(canvas, sx, sy, sx + 1, sy + 1);
+}
+
 void Canvas_PutPixel(Canvas* canvas, int cx, int cy, Color color) {
-    int sx = canvas->width/2 + cx;
-    int sy = canvas->height/2 - cy;
-    if (sx < 0 || sy < 0 || sx >= canvas->width || sy >= canvas->height)
+    Canvas_PutPixelPacked(canvas, cx, cy, Canvas_PackColor(color));
+}
+
+bool Canvas_SetIndexed(Canvas* canvas, bool enabled) {
+    // Already on: the buffer and its dirty lists stay as they are
+    if (enabled && canvas->indexBuffer) return true;
+    free(canvas->indexBuffer);
+    canvas->indexBuffer = enabled
+        ? calloc((size_t)canvas->bufferWidth * canvas->bufferHeight, sizeof(uint8_t)) : NULL;
+    canvas->indexDirty.count = 0;
+    canvas->prevIndexDirty.count = 0;
+    return !enabled || canvas->indexBuffer != NULL;
+}
+
+void Canvas_SetPalette(Canvas* canvas, int first, int count, const PackedColor* colors) {
+    if (first < 0) { colors -= first; count += first; first = 0; }
+    if (first + count > CANVAS_PALETTE_SIZE) count = CANVAS_PALETTE_SIZE - first;
+    if (count <= 0) return;
+    memcpy(&canvas->palette[first], colors, (size_t)count * sizeof(PackedColor));
+}
+
+void Canvas_ClearIndexed(Canvas* canvas, uint8_t index) {
+    memset(canvas->indexBuffer, index, (size_t)canvas->bufferWidth * canvas->bufferHeight);
+    setFullRect(canvas, &canvas->indexDirty);
+}
+
+void Canvas_PutPixelIndexed(Canvas* canvas, int cx, int cy, uint8_t index) {
+    int sx = canvas->bufferWidth/2 + Canvas_ScaleInt(canvas, cx);
+    int sy = canvas->bufferHeight/2 - Canvas_ScaleInt(canvas, cy);
+    if (sx < 0 || sy < 0 || sx >= canvas->bufferWidth || sy >= canvas->bufferHeight)
         return;
-    uint32_t pixel = (0xFF << 24)
-                   | (color.r << 16)
-                   | (color.g <<  8)
-                   | (color.b <<  0);
-    canvas->backBuffer[sy * canvas->width + sx] = pixel;
+    canvas->indexBuffer[(size_t)sy * canvas->bufferWidth + sx] = index;
+    Canvas_MarkIndexDirty(canvas, sx, sy, sx + 1, sy + 1);
+}
+
+void Canvas_ExpandIndexed(uint32_t* dst, const uint8_t* src, int count, const PackedColor* palette) {
+    int i = 0;
+#if defined(__AVX2__)
+    // Widen 8 indices to 32 bits and gather their palette entries. A 256-entry
+    // table is far too big for byte shuffles, so gathers are the vector path;
+    // lanes holding index 0 are masked off and keep the pixel under them.
+    const int* table = (const int*)palette;
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 32 <= count; i += 32) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*)(src + i));
+        if (_mm256_testz_si256(idx, idx)) continue;
+        __m128i halves[2] = { _mm256_castsi256_si128(idx), _mm256_extracti128_si256(idx, 1) };
+        for (int k = 0; k < 4; k++) {
+            __m128i part = k & 1 ? _mm_srli_si128(halves[k >> 1], 8) : halves[k >> 1];
+            __m256i lanes = _mm256_cvtepu8_epi32(part);
+            __m256i drawn = _mm256_xor_si256(_mm256_cmpeq_epi32(lanes, zero), _mm256_set1_epi32(-1));
+            __m256i* out = (__m256i*)(dst + i + 8 * k);
+            _mm256_storeu_si256(out, _mm256_mask_i32gather_epi32(_mm256_loadu_si256(out), table,
+                                                                 lanes, drawn, 4));
+        }
+    }
+#else
+    // Plain table lookups, four per iteration, skipping blank groups
+    for (; i + 4 <= count; i += 4) {
+        uint32_t group;
+        memcpy(&group, src + i, sizeof(group));
+        if (!group) continue;
+        if (src[i + 0]) dst[i + 0] = palette[src[i + 0]];
+        if (src[i + 1]) dst[i + 1] = palette[src[i + 1]];
+        if (src[i + 2]) dst[i + 2] = palette[src[i + 2]];
+        if (src[i + 3]) dst[i + 3] = palette[src[i + 3]];
+    }
+#endif
+    for (; i < count; i++) {
+        if (src[i]) dst[i] = palette[src[i]];
+    }
+}
+
+// Upscale one row: dst pixel x shows the source pixel under its center,
+// ((2x + 1) * step) >> 17 with step = srcWidth / dstWidth in 16.16 fixed point
+static void upscaleRow(uint32_t* dst, int dstWidth, const uint32_t* src, int srcWidth) {
+    int x = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    if (srcWidth * 2 == dstWidth) {
+        // Exact 2x (the 50% setting): duplicate every pixel with unpacks
+        for (; x + 8 <= dstWidth; x += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + x / 2));
+            _mm_storeu_si128((__m128i*)(dst + x), _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128((__m128i*)(dst + x + 4), _mm_unpackhi_epi32(v, v));
+        }
+        for (; x < dstWidth; x++) dst[x] = src[x / 2];
+        return;
+    }
+#endif
+    int step = (int)(((long long)srcWidth << 16) / dstWidth);
+#if defined(__AVX2__)
+    const __m256i lane = _mm256_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15);
+    const __m256i stepVec = _mm256_set1_epi32(step);
+    for (; x + 8 <= dstWidth; x += 8) {
+        __m256i centers = _mm256_add_epi32(_mm256_set1_epi32(2 * x), lane);
+        __m256i srcX = _mm256_srli_epi32(_mm256_mullo_epi32(centers, stepVec), 17);
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_i32gather_epi32((const int*)src, srcX, 4));
+    }
+#endif
+    for (; x < dstWidth; x++) {
+        dst[x] = src[((2 * x + 1) * step) >> 17];
+    }
+}
+
+void Canvas_Upscale(uint32_t* dst, int dstPitch, int dstWidth, int dstHeight,
+                    const uint32_t* src, int srcWidth, int srcHeight) {
+    int step = (int)(((long long)srcHeight << 16) / dstHeight);
+    int previous = -1;
+    for (int y = 0; y < dstHeight; y++) {
+        uint32_t* row = dst + (size_t)y * dstPitch;
+        int srcY = ((2 * y + 1) * step) >> 17;
+        if (srcY == previous) {
+            // Same source row as the line above: copy the finished row
+            memcpy(row, row - dstPitch, (size_t)dstWidth * sizeof(uint32_t));
+        } else {
+            upscaleRow(row, dstWidth, src + (size_t)srcY * srcWidth, srcWidth);
+            previous = srcY;
+        }
+    }
+}
+
+// Window pixels showing a buffer rectangle. Below scale 1 it is widened by
+// a pixel so rounding in the upscale never leaves a seam.
+static SDL_Rect windowRect(const Canvas* canvas, ClipRect r) {
+    if (canvas->bufferWidth != canvas->width || canvas->bufferHeight != canvas->height) {
+        r.minX = (int)((long long)r.minX * canvas->width / canvas->bufferWidth) - 1;
+        r.minY = (int)((long long)r.minY * canvas->height / canvas->bufferHeight) - 1;
+        r.maxX = (int)(((long long)r.maxX * canvas->width + canvas->bufferWidth - 1) / canvas->bufferWidth) + 1;
+        r.maxY = (int)(((long long)r.maxY * canvas->height + canvas->bufferHeight - 1) / canvas->bufferHeight) + 1;
+        if (r.minX < 0) r.minX = 0;
+        if (r.minY < 0) r.minY = 0;
+        if (r.maxX > canvas->width) r.maxX = canvas->width;
+        if (r.maxY > canvas->height) r.maxY = canvas->height;
+    }
+    return (SDL_Rect){ r.minX, r.minY, r.maxX - r.minX, r.maxY - r.minY };
 }
 
 void Canvas_Update(Canvas* canvas) {
-    // Upload back buffer to texture
-    SDL_UpdateTexture(
-        canvas->texture, NULL,
-        canvas->backBuffer,
-        canvas->width * sizeof(uint32_t)
-    );
-    
-    // Render the texture to the screen
-    SDL_RenderClear(canvas->renderer);
-    SDL_RenderCopy(canvas->renderer, canvas->texture, NULL, NULL);
-    SDL_RenderPresent(canvas->renderer);
-    
-    // Swap buffers
-    uint32_t* tmp = canvas->pixels;
-    canvas->pixels = canvas->backBuffer;
-    canvas->backBuffer = tmp;
+    // Indexed mode: resolve what the index buffer drew over the frame. Only
+    // those regions are expanded, and index 0 keeps the ARGB pixels under it.
+    if (canvas->indexBuffer) {
+        for (int i = 0; i < canvas->indexDirty.count; i++) {
+            ClipRect r = canvas->indexDirty.rects[i];
+            for (int y = r.minY; y < r.maxY; y++) {
+                Canvas_ExpandIndexed(canvas->backBuffer + (size_t)y * canvas->pitch + r.minX,
+                                     canvas->indexBuffer + (size_t)y * canvas->bufferWidth + r.minX,
+                                     r.maxX - r.minX, canvas->palette);
+            }
+            Canvas_MarkDirty(canvas, r.minX, r.minY, r.maxX, r.maxY);
+        }
+        canvas->prevIndexDirty = canvas->indexDirty;
+        canvas->indexDirty.count = 0;
+    }
+
+    // The frame is final here; zero-copy modes give the memory back below
+    for (int i = 0; i < canvas->frameSinkCount; i++) {
+        canvas->frameSinks[i](canvas->frameSinkData[i], canvas->backBuffer, canvas->pitch,
+                              canvas->bufferWidth, canvas->bufferHeight);
+    }
+
+    // The screen still shows the previous frame, so pixels can only differ
+    // where either frame drew. Present it whole when most of it changed.
+    DirtyRects changed = canvas->dirty;
+    for (int i = 0; i < canvas->prevDirty.count; i++) {
+        addDirtyRect(&changed, canvas->prevDirty.rects[i]);
+    }
+    long long area = 0;
+    for (int i = 0; i < changed.count; i++) {
+        const ClipRect* r = &changed.rects[i];
+        area += (long long)(r->maxX - r->minX) * (r->maxY - r->minY);
+    }
+    bool presentAll = canvas->uploadAll ||
+                      2 * area > (long long)canvas->bufferWidth * canvas->bufferHeight;
+
+    switch (canvas->presentMode) {
+        case PRESENT_COPY: {
+            // Reduced render scale: bring the frame up to the window size
+            const uint32_t* frame = canvas->backBuffer;
+            if (canvas->scaledBuffer) {
+                Canvas_Upscale(canvas->scaledBuffer, canvas->width, canvas->width, canvas->height,
+                               canvas->backBuffer, canvas->bufferWidth, canvas->bufferHeight);
+                frame = canvas->scaledBuffer;
+            }
+
+            // Upload the frame to the texture
+            if (presentAll) {
+                SDL_UpdateTexture(canvas->texture, NULL, frame, canvas->width * sizeof(uint32_t));
+            } else {
+                for (int i = 0; i < changed.count; i++) {
+                    SDL_Rect rect = windowRect(canvas, changed.rects[i]);
+                    SDL_UpdateTexture(canvas->texture, &rect,
+                                      frame + (size_t)rect.y * canvas->width + rect.x,
+                                      canvas->width * sizeof(uint32_t));
+                }
+            }
+            renderTexture(canvas);
+            break;
+        }
+
+        case PRESENT_LOCK_TEXTURE:
+            // The frame already is in the texture; unlocking uploads it
+            if (canvas->ownedBuffer) {
+                Canvas_Upscale(canvas->presentPixels, canvas->presentPitch, canvas->width, canvas->height,
+                               canvas->ownedBuffer, canvas->bufferWidth, canvas->bufferHeight);
+            }
+            releasePresentPixels(canvas);
+            renderTexture(canvas);
+            break;
+
+        case PRESENT_WINDOW_SURFACE:
+            if (canvas->ownedBuffer) {
+                Canvas_Upscale(canvas->presentPixels, canvas->presentPitch, canvas->width, canvas->height,
+                               canvas->ownedBuffer, canvas->bufferWidth, canvas->bufferHeight);
+            }
+            releasePresentPixels(canvas);
+            if (presentAll) {
+                SDL_UpdateWindowSurface(canvas->window);
+            } else {
+                SDL_Rect rects[CANVAS_MAX_DIRTY_RECTS];
+                for (int i = 0; i < changed.count; i++) {
+                    rects[i] = windowRect(canvas, changed.rects[i]);
+                }
+                SDL_UpdateWindowSurfaceRects(canvas->window, rects, changed.count);
+            }
+            break;
+
+        case PRESENT_HEADLESS:
+            // Nothing to show: the finished frame stays in the back buffer
+            break;
+    }
+
+    canvas->uploadAll = false;
+    canvas->prevDirty = canvas->dirty;
+    canvas->dirty.count = 0;
+    canvas->frameCount++;
+
+    // Zero-copy modes: take SDL's memory back for the next frame. A locked
+    // texture's old contents are undefined; the window surface keeps them.
+    if (canvas->presentMode == PRESENT_LOCK_TEXTURE ||
+        canvas->presentMode == PRESENT_WINDOW_SURFACE) {
+        uint32_t* previous = canvas->backBuffer;
+        if (!acquirePresentPixels(canvas)) {
+            fprintf(stderr, "Error: Failed to lock the frame memory: %s\n", SDL_GetError());
+            Canvas_SetPresentMode(canvas, PRESENT_COPY);
+            return;
+        }
+        bindBackBuffer(canvas, canvas->presentMode == PRESENT_WINDOW_SURFACE &&
+                               canvas->presentPixels == previous);
+    }
 }
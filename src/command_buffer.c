@@ -0,0 +1,443 @@
+#include "../include/command_buffer.h"
+#include "../include/text.h"
+#include "../include/triangle_simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define COMMAND_INITIAL_CAPACITY 256
+#define ARENA_INITIAL_CAPACITY   4096
+
+void commandBuffer_init(CommandBuffer* buffer) {
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+void commandBuffer_free(CommandBuffer* buffer) {
+    free(buffer->commands);
+    free(buffer->payload.data);
+    free(buffer->triangles.data);
+    free(buffer->order);
+    free(buffer->lines);
+    free(buffer->pixels);
+    if (buffer->soa.capacity) triangleDataSIMD_free(&buffer->soa);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+void commandBuffer_reset(CommandBuffer* buffer) {
+    buffer->count = 0;
+    buffer->group = 0;
+    buffer->payload.used = 0;
+    buffer->triangles.used = 0;
+}
+
+void commandBuffer_barrier(CommandBuffer* buffer) {
+    // An empty group costs nothing, so only count barriers that follow a command
+    if (buffer->count && buffer->commands[buffer->count - 1].group == buffer->group) buffer->group++;
+}
+
+// Reserve bytes in an arena; the offset of the block goes to *offset. Blocks
+// are packed without padding, so triangle records of consecutive calls are
+// consecutive (and stay float-aligned: the arena only holds one kind of record)
+static bool arenaAlloc(CommandArena* arena, size_t bytes, size_t* offset) {
+    size_t start = arena->used;
+    if (start + bytes > arena->capacity) {
+        size_t capacity = arena->capacity ? arena->capacity : ARENA_INITIAL_CAPACITY;
+        while (capacity < start + bytes) capacity *= 2;
+        uint8_t* data = realloc(arena->data, capacity);
+        if (!data) return false;
+        arena->data = data;
+        arena->capacity = capacity;
+    }
+    *offset = start;
+    arena->used = start + bytes;
+    return true;
+}
+
+// Append a command of the given type to the current group (NULL = out of memory)
+static DrawCommand* pushCommand(CommandBuffer* buffer, DrawCommandType type) {
+    if (buffer->count == buffer->capacity) {
+        int capacity = buffer->capacity ? buffer->capacity * 2 : COMMAND_INITIAL_CAPACITY;
+        DrawCommand* commands = realloc(buffer->commands, sizeof(DrawCommand) * (size_t)capacity);
+        if (!commands) return NULL;
+        buffer->commands = commands;
+        buffer->capacity = capacity;
+    }
+    DrawCommand* command = &buffer->commands[buffer->count++];
+    command->group = buffer->group;
+    command->type = (uint8_t)type;
+    command->mode = BLEND_REPLACE;
+    return command;
+}
+
+bool commandBuffer_line(CommandBuffer* buffer, int x0, int y0, int x1, int y1, PackedColor color) {
+    DrawCommand* command = pushCommand(buffer, DRAW_CMD_LINE);
+    if (!command) return false;
+    command->line.x0 = x0;
+    command->line.y0 = y0;
+    command->line.x1 = x1;
+    command->line.y1 = y1;
+    command->line.color = color;
+    return true;
+}
+
+bool commandBuffer_span(CommandBuffer* buffer, int y, int x0, int x1, PackedColor color, BlendMode mode) {
+    DrawCommand* command = pushCommand(buffer, DRAW_CMD_SPAN);
+    if (!command) return false;
+    command->mode = (uint8_t)mode;
+    command->span.y = y;
+    command->span.x0 = x0;
+    command->span.x1 = x1;
+    command->span.color = color;
+    return true;
+}
+
+// Reserve count triangle records and the command that draws them. A triangle
+// command right after another one in the same group extends it, since the
+// records of consecutive commands are consecutive in the arena.
+static DrawTriangle* pushTriangles(CommandBuffer* buffer, int count) {
+    size_t offset;
+    if (!arenaAlloc(&buffer->triangles, sizeof(DrawTriangle) * (size_t)count, &offset)) return NULL;
+    DrawTriangle* records = (DrawTriangle*)(buffer->triangles.data + offset);
+    int first = (int)(offset / sizeof(DrawTriangle));
+
+    DrawCommand* last = buffer->count ? &buffer->commands[buffer->count - 1] : NULL;
+    if (last && last->type == DRAW_CMD_TRIANGLES && last->group == buffer->group) {
+        last->triangles.count += count;
+        return records;
+    }
+    DrawCommand* command = pushCommand(buffer, DRAW_CMD_TRIANGLES);
+    if (!command) {
+        buffer->triangles.used = offset;
+        return NULL;
+    }
+    command->triangles.first = first;
+    command->triangles.count = count;
+    return records;
+}
+
+bool commandBuffer_triangle(CommandBuffer* buffer, float cx, float cy, float size, float angle,
+                            PackedColor color) {
+    DrawTriangle* t = pushTriangles(buffer, 1);
+    if (!t) return false;
+    t->cx = cx;
+    t->cy = cy;
+    t->size = size;
+    t->angle = angle;
+    t->color = color;
+    return true;
+}
+
+bool commandBuffer_triangles(CommandBuffer* buffer, const TriangleView* view) {
+    const size_t stride = view->stride;
+    const size_t colorStride = view->colorStride ? view->colorStride : stride;
+    const size_t activeStride = view->activeStride ? view->activeStride : stride;
+    int active = 0;
+    for (int i = 0; i < view->count; i++) {
+        active += !view->active || TRIANGLE_VIEW_AT(bool, view->active, activeStride, i);
+    }
+    if (!active) return true;
+
+    DrawTriangle* t = pushTriangles(buffer, active);
+    if (!t) return false;
+    for (int i = 0; i < view->count; i++) {
+        if (view->active && !TRIANGLE_VIEW_AT(bool, view->active, activeStride, i)) continue;
+        t->cx = TRIANGLE_VIEW_AT(float, view->cx, stride, i);
+        t->cy = TRIANGLE_VIEW_AT(float, view->cy, stride, i);
+        t->size = TRIANGLE_VIEW_AT(float, view->size, stride, i);
+        t->angle = TRIANGLE_VIEW_AT(float, view->angle, stride, i);
+        t->color = TRIANGLE_VIEW_AT(PackedColor, view->color, colorStride, i);
+        t++;
+    }
+    return true;
+}
+
+bool commandBuffer_text(CommandBuffer* buffer, int cx, int cy, const char* text, Color color) {
+    size_t length = strlen(text) + 1;
+    size_t offset;
+    if (!arenaAlloc(&buffer->payload, length, &offset)) return false;
+    DrawCommand* command = pushCommand(buffer, DRAW_CMD_TEXT);
+    if (!command) {
+        buffer->payload.used = offset;
+        return false;
+    }
+    memcpy(buffer->payload.data + offset, text, length);
+    command->text.x = cx;
+    command->text.y = cy;
+    command->text.offset = offset;
+    command->text.color = color;
+    return true;
+}
+
+bool commandBuffer_blit(CommandBuffer* buffer, int x, int y, const uint32_t* pixels, int width,
+                        int height, int pitch, BlendMode mode) {
+    DrawCommand* command = pushCommand(buffer, DRAW_CMD_BLIT);
+    if (!command) return false;
+    command->mode = (uint8_t)mode;
+    command->blit.pixels = pixels;
+    command->blit.x = x;
+    command->blit.y = y;
+    command->blit.width = width;
+    command->blit.height = height;
+    command->blit.pitch = pitch;
+    return true;
+}
+
+// Sort the commands of every group by type, keeping the recording order
+// within a type (a counting sort per group; groups are already in order)
+static bool sortCommands(CommandBuffer* buffer) {
+    if (buffer->count > buffer->orderCapacity) {
+        int* order = realloc(buffer->order, sizeof(int) * (size_t)buffer->count);
+        if (!order) return false;
+        buffer->order = order;
+        buffer->orderCapacity = buffer->count;
+    }
+    const DrawCommand* commands = buffer->commands;
+    for (int start = 0, end; start < buffer->count; start = end) {
+        int offsets[DRAW_CMD_TYPES] = {0};
+        for (end = start; end < buffer->count && commands[end].group == commands[start].group; end++) {
+            offsets[commands[end].type]++;
+        }
+        for (int t = 0, next = start; t < DRAW_CMD_TYPES; t++) {
+            int n = offsets[t];
+            offsets[t] = next;
+            next += n;
+        }
+        for (int i = start; i < end; i++) buffer->order[offsets[commands[i].type]++] = i;
+    }
+    return true;
+}
+
+// Command i of the run starting at position start of the drawing order
+// (order NULL = recording order)
+static inline const DrawCommand* runCommand(const CommandBuffer* buffer, const int* order, int start, int i) {
+    return &buffer->commands[order ? order[start + i] : start + i];
+}
+
+// Merged run of span commands, split over the workers by bands of rows:
+// every worker walks the whole run and keeps the spans on its rows, so the
+// spans covering a pixel still blend in recording order
+typedef struct {
+    Canvas*              canvas;
+    const CommandBuffer* buffer;
+    const int*           order;
+    int                  start, count;
+} SpanJob;
+
+static void drawSpanBand(void* ctx, int workerIndex, int workerCount) {
+    const SpanJob* job = ctx;
+    Canvas* canvas = job->canvas;
+    int rowStart = (int)((long)canvas->bufferHeight * workerIndex / workerCount);
+    int rowEnd = (int)((long)canvas->bufferHeight * (workerIndex + 1) / workerCount);
+    for (int i = 0; i < job->count; i++) {
+        const DrawCommand* c = runCommand(job->buffer, job->order, job->start, i);
+        int y = c->span.y;
+        if (y < rowStart || y >= rowEnd) continue;
+        int x0 = c->span.x0 < 0 ? 0 : c->span.x0;
+        int x1 = c->span.x1 > canvas->bufferWidth - 1 ? canvas->bufferWidth - 1 : c->span.x1;
+        if (x0 > x1) continue;
+        blendFillRow(canvas->backBuffer + (size_t)y * canvas->pitch + x0, x1 - x0 + 1,
+                     c->span.color, (BlendMode)c->mode);
+    }
+}
+
+static void drawSpans(CommandBuffer* buffer, Canvas* canvas, TileRenderer* tiles,
+                      const int* order, int start, int count) {
+    // One dirty rectangle for the run; the workers only write pixels
+    int minX = canvas->bufferWidth, minY = canvas->bufferHeight, maxX = -1, maxY = -1;
+    for (int i = 0; i < count; i++) {
+        const DrawCommand* c = runCommand(buffer, order, start, i);
+        if (c->span.y < 0 || c->span.y >= canvas->bufferHeight) continue;
+        int x0 = c->span.x0 < 0 ? 0 : c->span.x0;
+        int x1 = c->span.x1 > canvas->bufferWidth - 1 ? canvas->bufferWidth - 1 : c->span.x1;
+        if (x0 > x1) continue;
+        if (x0 < minX) minX = x0;
+        if (x1 > maxX) maxX = x1;
+        if (c->span.y < minY) minY = c->span.y;
+        if (c->span.y > maxY) maxY = c->span.y;
+    }
+    if (maxX < 0) return;
+    Canvas_MarkDirty(canvas, minX, minY, maxX + 1, maxY + 1);
+
+    SpanJob job = { canvas, buffer, order, start, count };
+    if (tiles && tiles->pool.workerCount > 1 && count >= 2 * COMMAND_SPANS_PER_WORKER) {
+        workerPool_run(&tiles->pool, drawSpanBand, &job);
+    } else {
+        drawSpanBand(&job, 0, 1);
+    }
+}
+
+static void drawLines(CommandBuffer* buffer, Canvas* canvas, const int* order, int start, int count) {
+    if (count > buffer->lineCapacity) {
+        int* lines = realloc(buffer->lines, sizeof(int) * 4 * (size_t)count);
+        if (lines) buffer->lines = lines;
+        PackedColor* pixels = realloc(buffer->pixels, sizeof(PackedColor) * (size_t)count);
+        if (pixels) buffer->pixels = pixels;
+        if (!lines || !pixels) {
+            // No room to merge: draw them one by one
+            for (int i = 0; i < count; i++) {
+                const DrawCommand* c = runCommand(buffer, order, start, i);
+                drawLinePacked(canvas, c->line.x0, c->line.y0, c->line.x1, c->line.y1, c->line.color);
+            }
+            return;
+        }
+        buffer->lineCapacity = count;
+    }
+
+    int halfW = canvas->bufferWidth / 2;
+    int halfH = canvas->bufferHeight / 2;
+    for (int i = 0; i < count; i++) {
+        const DrawCommand* c = runCommand(buffer, order, start, i);
+        int* l = &buffer->lines[i * 4];
+        l[0] = halfW + Canvas_ScaleInt(canvas, c->line.x0);
+        l[1] = halfH - Canvas_ScaleInt(canvas, c->line.y0);
+        l[2] = halfW + Canvas_ScaleInt(canvas, c->line.x1);
+        l[3] = halfH - Canvas_ScaleInt(canvas, c->line.y1);
+        buffer->pixels[i] = c->line.color;
+    }
+    // Lines are drawn in order, so overlaps come out as recorded
+    drawLinesBatchSIMD(canvas, buffer->lines, buffer->pixels, count);
+}
+
+// Draw count triangle records starting at first
+static void drawTriangleRecords(CommandBuffer* buffer, Canvas* canvas, TileRenderer* tiles,
+                                int first, int count) {
+    const DrawTriangle* records = (const DrawTriangle*)buffer->triangles.data + first;
+
+    if (tiles) {
+        TriangleDataSIMD* soa = &buffer->soa;
+        if (count > soa->capacity) {
+            if (soa->capacity) triangleDataSIMD_free(soa);
+            triangleDataSIMD_init(soa, count);
+        }
+        if (soa->cx && soa->cy && soa->size && soa->angle && soa->color && soa->visible) {
+            for (int i = 0; i < count; i++) {
+                soa->cx[i] = records[i].cx;
+                soa->cy[i] = records[i].cy;
+                soa->size[i] = records[i].size;
+                soa->angle[i] = records[i].angle;
+                soa->color[i] = records[i].color;
+            }
+            memset(soa->visible, 1, sizeof(bool) * (size_t)count);
+            soa->count = count;
+            renderTrianglesTiled(tiles, canvas, soa);
+            return;
+        }
+    }
+
+    TriangleView view = {0};
+    view.cx = &records->cx;
+    view.cy = &records->cy;
+    view.size = &records->size;
+    view.angle = &records->angle;
+    view.color = &records->color;
+    view.stride = sizeof(DrawTriangle);
+    view.count = count;
+    drawTriangles(canvas, &view);
+}
+
+// Draw one command with the immediate call it mirrors
+static void drawCommand(CommandBuffer* buffer, Canvas* canvas, const DrawCommand* c) {
+    switch ((DrawCommandType)c->type) {
+        case DRAW_CMD_SPAN:
+            blendSpan(canvas, c->span.y, c->span.x0, c->span.x1, c->span.color, (BlendMode)c->mode);
+            break;
+        case DRAW_CMD_TRIANGLES: {
+            const DrawTriangle* t = (const DrawTriangle*)buffer->triangles.data + c->triangles.first;
+            for (int i = 0; i < c->triangles.count; i++) {
+                drawTrianglePacked(canvas, t[i].cx, t[i].cy, t[i].size, t[i].angle, t[i].color);
+            }
+            break;
+        }
+        case DRAW_CMD_LINE:
+            drawLinePacked(canvas, c->line.x0, c->line.y0, c->line.x1, c->line.y1, c->line.color);
+            break;
+        case DRAW_CMD_BLIT:
+            blendBlit(canvas, c->blit.x, c->blit.y, c->blit.pixels, c->blit.width, c->blit.height,
+                      c->blit.pitch, (BlendMode)c->mode);
+            break;
+        case DRAW_CMD_TEXT:
+            textDraw(canvas, c->text.x, c->text.y, (const char*)buffer->payload.data + c->text.offset,
+                     c->text.color);
+            break;
+        case DRAW_CMD_TYPES:
+            break;
+    }
+}
+
+// Draw the run of count commands of one type starting at position start of
+// the drawing order (order NULL = recording order)
+static void drawRun(CommandBuffer* buffer, Canvas* canvas, TileRenderer* tiles,
+                    const int* order, int start, int count) {
+    const DrawCommand* c = runCommand(buffer, order, start, 0);
+
+    // Short runs, blits and text: one draw each
+    if (count < COMMAND_MIN_MERGE || c->type == DRAW_CMD_BLIT || c->type == DRAW_CMD_TEXT) {
+        for (int i = 0; i < count; i++) drawCommand(buffer, canvas, runCommand(buffer, order, start, i));
+        buffer->batches += count;
+        return;
+    }
+    buffer->batches++;
+
+    switch ((DrawCommandType)c->type) {
+        case DRAW_CMD_SPAN:
+            drawSpans(buffer, canvas, tiles, order, start, count);
+            break;
+        case DRAW_CMD_TRIANGLES: {
+            // Records are allocated in recording order, so a run is one range
+            const DrawCommand* last = runCommand(buffer, order, start, count - 1);
+            int first = c->triangles.first;
+            drawTriangleRecords(buffer, canvas, tiles, first,
+                                last->triangles.first + last->triangles.count - first);
+            break;
+        }
+        case DRAW_CMD_LINE:
+            drawLines(buffer, canvas, order, start, count);
+            break;
+        case DRAW_CMD_BLIT:
+        case DRAW_CMD_TEXT:
+        case DRAW_CMD_TYPES:
+            break;
+    }
+}
+
+void commandBuffer_execute(CommandBuffer* buffer, Canvas* canvas, TileRenderer* tiles) {
+    buffer->batches = 0;
+
+    // Recording order: merge the runs of consecutive commands of one type
+    if (!buffer->sortByType) {
+        for (int start = 0, n; start < buffer->count; start += n) {
+            uint8_t type = buffer->commands[start].type;
+            for (n = 1; start + n < buffer->count && buffer->commands[start + n].type == type; n++) {}
+            drawRun(buffer, canvas, tiles, NULL, start, n);
+        }
+        commandBuffer_reset(buffer);
+        return;
+    }
+
+    if (!sortCommands(buffer)) {
+        // Without room to sort, walk every group once per type and draw its
+        // commands of that type one by one: no merges, same image
+        for (int start = 0, end; start < buffer->count; start = end) {
+            uint32_t group = buffer->commands[start].group;
+            for (end = start; end < buffer->count && buffer->commands[end].group == group; end++) {}
+            for (int t = 0; t < DRAW_CMD_TYPES; t++) {
+                for (int i = start; i < end; i++) {
+                    if (buffer->commands[i].type == t) drawRun(buffer, canvas, tiles, NULL, i, 1);
+                }
+            }
+        }
+        commandBuffer_reset(buffer);
+        return;
+    }
+
+    // Runs of one type merge into one draw, across groups too: a run that
+    // crosses a barrier was drawn back to back anyway, and every merged
+    // draw keeps the recording order of its commands where they overlap
+    for (int start = 0, n; start < buffer->count; start += n) {
+        const DrawCommand* c = runCommand(buffer, buffer->order, start, 0);
+        for (n = 1; start + n < buffer->count; n++) {
+            if (runCommand(buffer, buffer->order, start, n)->type != c->type) break;
+        }
+        drawRun(buffer, canvas, tiles, buffer->order, start, n);
+    }
+    commandBuffer_reset(buffer);
+}
@@ -1,30 +1,210 @@
 #include "../include/engine.h"
 #include "../include/input.h"
 #include "../include/canvas.h"
+#include "../include/blend.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 
 // Layer management
 static Layer* layers[32];
 static int layerCount = 0;
+static struct LayerCache* layerCaches[32]; // Offscreen copy of cached layers (NULL = not cached)
 
 // Global canvas that the game uses for drawing
 static Canvas canvas;
 static int targetFPS = 60;
 static bool isRunning = true;
+static PostFx* postProcess = NULL;
+
+// Deferred rendering: layers record commands, drawn at the end of the frame
+static bool deferred = false;
+static CommandBuffer commands;
+static TileRenderer* deferredTiles = NULL;  // Started on the first deferred frame
+
+// On-demand rendering: frames only run when requested, on input or on a timer
+static bool onDemand = false;
+static bool frameRequested = true;
+static bool wakeScheduled = false;
+static Uint32 wakeTime;          // SDL_GetTicks() of the earliest scheduled frame
+
+// Longest single wait for events while idle
+#define IDLE_WAIT_MS 1000
+
+// Handle window close and escape; a window uncovered needs a whole new present
+static void handleEngineEvent(const SDL_Event* e) {
+    if (e->type == SDL_QUIT) isRunning = false;
+    if (e->type == SDL_KEYDOWN && e->key.keysym.sym == SDLK_ESCAPE) isRunning = false;
+    if (e->type == SDL_WINDOWEVENT && e->window.event == SDL_WINDOWEVENT_EXPOSED) canvas.uploadAll = true;
+}
 
 // Internal function to process SDL events and handle window close
 static void processEngineEvents(void) {
     SDL_Event e;
     while (SDL_PollEvent(&e)) {
-        if (e.type == SDL_QUIT) isRunning = false;
-        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE) isRunning = false;
+        handleEngineEvent(&e);
+    }
+}
+
+// Block until an event arrives or the scheduled frame is due
+static void waitForFrame(void) {
+    SDL_Event e;
+    while (isRunning) {
+        int timeout = IDLE_WAIT_MS;
+        if (wakeScheduled) {
+            Sint32 left = (Sint32)(wakeTime - SDL_GetTicks());
+            if (left <= 0) return;
+            if (left < timeout) timeout = left;
+        }
+        if (SDL_WaitEventTimeout(&e, timeout)) {
+            handleEngineEvent(&e);
+            return;
+        }
     }
 }
 
+// Offscreen copy of a cached layer's last render
+struct LayerCache {
+    uint32_t*  pixels;    // width x height, transparent where the layer did not draw
+    int        width;     // Buffer size it was rendered at
+    int        height;
+    DirtyRects rects;     // Regions the layer drew
+    bool       opaque[CANVAS_MAX_DIRTY_RECTS]; // Region fully drawn: copy instead of blend
+    bool       valid;
+};
+
+// Draw the commands recorded so far (deferred rendering)
+static void flushCommands(void) {
+    if (!deferred || !commands.count) return;
+    if (!deferredTiles) {
+        deferredTiles = malloc(sizeof(TileRenderer));
+        if (deferredTiles && !tileRenderer_init(deferredTiles, 0)) {
+            free(deferredTiles);
+            deferredTiles = NULL;
+        }
+    }
+    commandBuffer_execute(&commands, &canvas, deferredTiles);
+}
+
+// Stop deferred rendering and free its buffers
+static void releaseDeferred(void) {
+    commandBuffer_free(&commands);
+    if (deferredTiles) {
+        tileRenderer_free(deferredTiles);
+        free(deferredTiles);
+        deferredTiles = NULL;
+    }
+}
+
+// Render a layer into its cache: the canvas draws into the cache for the
+// duration, and its dirty tracking records the regions the layer covers
+static void renderLayerCache(Layer* layer, struct LayerCache* cache) {
+    memset(cache->pixels, 0, (size_t)cache->width * cache->height * sizeof(uint32_t));
+    uint32_t* backBuffer = canvas.backBuffer;
+    int pitch = canvas.pitch;
+    DirtyRects dirty = canvas.dirty;
+    canvas.backBuffer = cache->pixels;
+    canvas.pitch = cache->width;
+    canvas.dirty.count = 0;
+
+    layer->render();
+    flushCommands();
+
+    cache->rects = canvas.dirty;
+    canvas.backBuffer = backBuffer;
+    canvas.pitch = pitch;
+    canvas.dirty = dirty;
+
+    for (int i = 0; i < cache->rects.count; i++) {
+        const ClipRect* r = &cache->rects.rects[i];
+        bool opaque = true;
+        for (int y = r->minY; y < r->maxY && opaque; y++) {
+            const uint32_t* row = cache->pixels + (size_t)y * cache->width;
+            for (int x = r->minX; x < r->maxX; x++) {
+                if (row[x] < 0xFF000000u) { opaque = false; break; }
+            }
+        }
+        cache->opaque[i] = opaque;
+    }
+    cache->valid = true;
+}
+
+// Draw a cached layer: re-render it if needed, then copy its opaque regions
+// and composite the rest over what the layers below drew
+static void drawCachedLayer(Layer* layer, struct LayerCache* cache) {
+    if (cache->width != canvas.bufferWidth || cache->height != canvas.bufferHeight) {
+        free(cache->pixels);
+        cache->pixels = malloc((size_t)canvas.bufferWidth * canvas.bufferHeight * sizeof(uint32_t));
+        cache->width = canvas.bufferWidth;
+        cache->height = canvas.bufferHeight;
+        cache->valid = false;
+        if (!cache->pixels) { cache->width = 0; layer->render(); return; }
+    }
+    if (!cache->valid) renderLayerCache(layer, cache);
+
+    for (int i = 0; i < cache->rects.count; i++) {
+        const ClipRect* r = &cache->rects.rects[i];
+        const uint32_t* src = cache->pixels + (size_t)r->minY * cache->width + r->minX;
+        uint32_t* dst = canvas.backBuffer + (size_t)r->minY * canvas.pitch + r->minX;
+        int w = r->maxX - r->minX;
+        for (int y = r->minY; y < r->maxY; y++, src += cache->width, dst += canvas.pitch) {
+            if (cache->opaque[i]) {
+                memcpy(dst, src, (size_t)w * sizeof(uint32_t));
+            } else {
+                compositeRow(dst, src, w);
+            }
+        }
+        Canvas_MarkDirty(&canvas, r->minX, r->minY, r->maxX, r->maxY);
+    }
+}
+
+// Drop the offscreen buffer; the layer stays cached and renders again
+static void releaseLayerCache(struct LayerCache* cache) {
+    if (!cache) return;
+    free(cache->pixels);
+    cache->pixels = NULL;
+    cache->width = 0;
+    cache->height = 0;
+    cache->valid = false;
+}
+
+// One frame: update and render every enabled layer, then present
+static void runFrame(float dt) {
+    // Clear what the back buffer kept from its last frame (its dirty rectangles)
+    Canvas_BeginFrame(&canvas);
+    
+    // Call update function for each enabled layer
+    for (int i = 0; i < layerCount; i++) {
+        if (layers[i]->enabled) layers[i]->update(dt);
+    }
+    
+    // Call render function for each enabled layer in order (background to foreground)
+    // This ensures layers render on top of each other correctly
+    // Cached layers composite their offscreen copy
+    // Deferred commands are drawn before a cached layer composites and once
+    // all layers have recorded
+    for (int i = 0; i < layerCount; i++) {
+        if (!layers[i]->enabled) continue;
+        commandBuffer_barrier(&commands);
+        if (layerCaches[i]) {
+            flushCommands();
+            drawCachedLayer(layers[i], layerCaches[i]);
+        } else {
+            layers[i]->render();
+        }
+    }
+    flushCommands();
+    
+    // Full-screen passes over the finished layers
+    if (postProcess) postFx_apply(postProcess, &canvas);
+    
+    // Present the frame
+    Canvas_Update(&canvas);
+}
+
 int runEngine(const char* title, int width, int height, int fps) {
     // Initialize SDL and create canvas
     if (!Canvas_Init(&canvas, width, height)) {
@@ -58,7 +238,18 @@ int runEngine(const char* title, int width, int height, int fps) {
     
     // Main game loop
     while (isRunning) {
+        // Nothing to draw: sleep until input or a scheduled frame
+        if (onDemand && !frameRequested) {
+            waitForFrame();
+            if (!isRunning) break;
+            
+            // The idle time is no frame time: the first frame after it
+            // advances by one frame, not by the whole wait
+            previousTime = SDL_GetTicks() - frameTargetTime;
+        }
+        frameRequested = false;
         frameStart = SDL_GetTicks();
+        if (wakeScheduled && (Sint32)(wakeTime - frameStart) <= 0) wakeScheduled = false;
         
         // Process SDL events
         processEngineEvents();
@@ -72,22 +263,7 @@ int runEngine(const char* title, int width, int height, int fps) {
         previousTime = currentTime;
         float dt = deltaTime / 1000.0f;
         
-        // Clear back buffer once at the beginning of frame
-        memset(canvas.backBuffer, 0, canvas.width * canvas.height * sizeof(uint32_t));
-        
-        // Call update function for each enabled layer
-        for (int i = 0; i < layerCount; i++) {
-            if (layers[i]->enabled) layers[i]->update(dt);
-        }
-        
-        // Call render function for each enabled layer in order (background to foreground)
-        // This ensures layers render on top of each other correctly
-        for (int i = 0; i < layerCount; i++) {
-            if (layers[i]->enabled) layers[i]->render();
-        }
-        
-        // Present the frame
-        Canvas_Update(&canvas);
+        runFrame(dt);
         
         // Cap the frame rate
         frameTime = SDL_GetTicks() - frameStart;
@@ -97,12 +273,75 @@ int runEngine(const char* title, int width, int height, int fps) {
     }
     
     // Clean up resources
+    for (int i = 0; i < layerCount; i++) releaseLayerCache(layerCaches[i]);
+    releaseDeferred();
     textShutdown();
     TTF_Quit();
     Canvas_Destroy(&canvas);
     return 0;
 }
 
+int runEngineHeadless(int width, int height, int frames, float dt) {
+    // Pixel buffers only: no SDL video, window or renderer
+    if (!Canvas_InitHeadless(&canvas, width, height)) {
+        fprintf(stderr, "Failed to initialize canvas\n");
+        return 1;
+    }
+    
+    // SDL_ttf renders into memory and works without a display
+    if (TTF_Init() != 0) {
+        fprintf(stderr, "Failed to initialize SDL_ttf: %s\n", TTF_GetError());
+        Canvas_Destroy(&canvas);
+        return 1;
+    }
+    
+    // Input stays in its initial state: no keys held, mouse at the center
+    inputInit(width, height);
+    setup();
+    
+    // Fixed timestep, no events and no frame cap
+    for (int frame = 0; frame < frames; frame++) {
+        runFrame(dt);
+    }
+    
+    for (int i = 0; i < layerCount; i++) releaseLayerCache(layerCaches[i]);
+    releaseDeferred();
+    textShutdown();
+    TTF_Quit();
+    Canvas_Destroy(&canvas);
+    return 0;
+}
+
+void setPostProcess(PostFx* fx) {
+    postProcess = fx;
+}
+
+void setOnDemandRendering(bool enabled) {
+    onDemand = enabled;
+    frameRequested = true;
+}
+
+void requestFrame(void) {
+    frameRequested = true;
+}
+
+void requestFrameIn(float seconds) {
+    Uint32 when = SDL_GetTicks() + (seconds > 0.0f ? (Uint32)(seconds * 1000.0f + 0.5f) : 0);
+    if (!wakeScheduled || (Sint32)(when - wakeTime) < 0) {
+        wakeTime = when;
+        wakeScheduled = true;
+    }
+}
+
+void setDeferredRendering(bool enabled) {
+    if (deferred && !enabled) flushCommands();
+    deferred = enabled;
+}
+
+CommandBuffer* getCommandBuffer(void) {
+    return deferred ? &commands : NULL;
+}
+
 // Function to get the canvas for drawing
 Canvas* getCanvas(void) {
     return &canvas;
@@ -131,10 +370,14 @@ void registerLayer(Layer* layer) {
 void unregisterLayer(const char* name) {
     for (int i = 0; i < layerCount; i++) {
         if (strcmp(layers[i]->name, name) == 0) {
+            releaseLayerCache(layerCaches[i]);
+            free(layerCaches[i]);
             // Remove layer by shifting all subsequent layers down
             for (int j = i; j < layerCount - 1; j++) {
                 layers[j] = layers[j+1];
+                layerCaches[j] = layerCaches[j+1];
             }
+            layerCaches[layerCount - 1] = NULL;
             layerCount--;
             return;
         }
@@ -154,3 +397,34 @@ void setLayerEnabled(const char* name, bool enabled) {
     
     fprintf(stderr, "Warning: Attempted to set enabled state for nonexistent layer '%s'\n", name);
 }
+
+// Cache or stop caching a layer by name
+void setLayerCached(const char* name, bool cached) {
+    for (int i = 0; i < layerCount; i++) {
+        if (strcmp(layers[i]->name, name) == 0) {
+            if (cached && !layerCaches[i]) {
+                layerCaches[i] = calloc(1, sizeof(struct LayerCache));
+                if (!layerCaches[i]) fprintf(stderr, "Error: Failed to cache layer '%s'\n", name);
+            } else if (!cached && layerCaches[i]) {
+                releaseLayerCache(layerCaches[i]);
+                free(layerCaches[i]);
+                layerCaches[i] = NULL;
+            }
+            return;
+        }
+    }
+    
+    fprintf(stderr, "Warning: Attempted to set cached state for nonexistent layer '%s'\n", name);
+}
+
+// Make a cached layer render again on the next frame
+void invalidateLayer(const char* name) {
+    for (int i = 0; i < layerCount; i++) {
+        if (strcmp(layers[i]->name, name) == 0) {
+            if (layerCaches[i]) layerCaches[i]->valid = false;
+            return;
+        }
+    }
+    
+    fprintf(stderr, "Warning: Attempted to invalidate nonexistent layer '%s'\n", name);
+}
@@ -1,17 +1,24 @@
 #include "../include/explosion_demo.h"
 #include "../include/triangle.h"
+#include "../include/primitives.h"
 #include <stdlib.h>
 #include <math.h>
 #include <stdbool.h>
 #include <time.h>
 
-// Ensure we have the declaration for the triangle drawing function
-extern void drawTriangle(Canvas* canvas, const Triangle* t);
-
 // Array of particles for the explosion effect
 static Particle particles[MAX_PARTICLES];
 static int canvasWidth, canvasHeight;
 
+// Colors and age of each explosion's palette run (indexed mode)
+typedef struct {
+    PackedColor colors[EXPLOSION_COLORS];
+    float age;
+} ExplosionSlot;
+
+static ExplosionSlot slots[EXPLOSION_SLOTS];
+static int nextSlot = 0;
+
 // Initialize all particles as inactive
 void initExplosionDemo(int canvasW, int canvasH) {
     // Store canvas dimensions for later use
@@ -29,6 +36,12 @@ void initExplosionDemo(int canvasW, int canvasH) {
     for (int i = 0; i < MAX_PARTICLES; i++) {
         particles[i].active = false;
     }
+    
+    // Every palette run starts fully faded
+    for (int i = 0; i < EXPLOSION_SLOTS; i++) {
+        slots[i].age = PARTICLE_MAX_LIFETIME;
+    }
+    nextSlot = 0;
 }
 
 // Free any resources allocated by the explosion demo
@@ -42,13 +55,13 @@ static float randomRange(float min, float max) {
 }
 
 // Helper function to get a random color
-static Color randomColor(void) {
+static PackedColor randomColor(void) {
     // Prefer brighter colors for better visibility
-    return (Color){
+    return Canvas_PackColor((Color){
         (uint8_t)(128 + rand() % 128),
         (uint8_t)(128 + rand() % 128),
         (uint8_t)(128 + rand() % 128)
-    };
+    });
 }
 
 // Find an available particle slot or reuse the oldest one if none available
@@ -77,6 +90,14 @@ static int findAvailableParticleSlot(void) {
 
 // Create a new explosion at the specified canvas coordinates
 void handleClickExplosion(float canvasX, float canvasY) {
+    // Take the oldest palette run and give it fresh colors
+    int slot = nextSlot;
+    nextSlot = (nextSlot + 1) % EXPLOSION_SLOTS;
+    slots[slot].age = 0.0f;
+    for (int c = 0; c < EXPLOSION_COLORS; c++) {
+        slots[slot].colors[c] = randomColor();
+    }
+    
     // Create PARTICLES_PER_EXPLOSION new particles
     for (int i = 0; i < PARTICLES_PER_EXPLOSION; i++) {
         // Find an available particle slot
@@ -96,7 +117,9 @@ void handleClickExplosion(float canvasX, float canvasY) {
         
         // Random size, color, rotation
         particles[index].size = randomRange(PARTICLE_MIN_SIZE, PARTICLE_MAX_SIZE);
-        particles[index].color = randomColor();
+        int c = rand() % EXPLOSION_COLORS;
+        particles[index].color = slots[slot].colors[c];
+        particles[index].index = (uint8_t)(EXPLOSION_PALETTE_FIRST + slot * EXPLOSION_COLORS + c);
         particles[index].angle = randomRange(0, 2.0f * M_PI);
         particles[index].rotation_speed = randomRange(-10.0f, 10.0f);
         
@@ -109,6 +132,10 @@ void handleClickExplosion(float canvasX, float canvasY) {
 
 // Update all active particles
 void updateExplosion(float dt) {
+    for (int i = 0; i < EXPLOSION_SLOTS; i++) {
+        slots[i].age += dt;
+    }
+    
     for (int i = 0; i < MAX_PARTICLES; i++) {
         if (!particles[i].active) continue;
         
@@ -153,20 +180,56 @@ void renderExplosion(Canvas* canvas) {
     for (int i = 0; i < MAX_PARTICLES; i++) {
         if (!particles[i].active) continue;
         
-        // Create a temporary triangle with the particle properties
-        Triangle t;
-        t.cx = particles[i].cx;
-        t.cy = particles[i].cy;
-        t.size = particles[i].size;
-        t.angle = particles[i].angle;
+        // Same local triangle as drawTriangle, rotated and moved into place
+        float size = particles[i].size;
+        float bx[3] = { 0, size, -size };
+        float by[3] = { -size, size, size };
+        float c = cosf(particles[i].angle), s = sinf(particles[i].angle);
+        float xs[3], ys[3];
+        for (int k = 0; k < 3; k++) {
+            xs[k] = particles[i].cx + bx[k] * c - by[k] * s;
+            ys[k] = particles[i].cy + bx[k] * s + by[k] * c;
+        }
         
-        // Fade out color as the particle ages
+        // Fade out through alpha as the particle ages; additive blending makes
+        // overlapping particles glow instead of covering each other
         float fadeRatio = 1.0f - (particles[i].age / particles[i].max_age);
-        t.color.r = (uint8_t)(particles[i].color.r * fadeRatio);
-        t.color.g = (uint8_t)(particles[i].color.g * fadeRatio);
-        t.color.b = (uint8_t)(particles[i].color.b * fadeRatio);
-        
-        // Draw the particle as a small triangle
-        drawTriangle(canvas, &t);
+        uint32_t alpha = (uint32_t)(255.0f * fadeRatio);
+        PackedColor color = (particles[i].color & 0x00FFFFFFu) | (alpha << 24);
+        fillConvexPolygonPacked(canvas, xs, ys, 3, color, BLEND_ADD);
+    }
+}
+
+// Render all active particles through the palette
+void renderExplosionIndexed(Canvas* canvas) {
+    // Darken each explosion's colors with its age; particles drawn with
+    // those indices fade along without being touched
+    for (int i = 0; i < EXPLOSION_SLOTS; i++) {
+        float fadeRatio = 1.0f - slots[i].age / PARTICLE_MAX_LIFETIME;
+        if (fadeRatio < 0.0f) fadeRatio = 0.0f;
+        uint32_t scale = (uint32_t)(256.0f * fadeRatio);
+        PackedColor faded[EXPLOSION_COLORS];
+        for (int c = 0; c < EXPLOSION_COLORS; c++) {
+            PackedColor color = slots[i].colors[c];
+            uint32_t r = (((color >> 16) & 0xFF) * scale) >> 8;
+            uint32_t g = (((color >> 8) & 0xFF) * scale) >> 8;
+            uint32_t b = ((color & 0xFF) * scale) >> 8;
+            faded[c] = 0xFF000000u | (r << 16) | (g << 8) | b;
+        }
+        Canvas_SetPalette(canvas, EXPLOSION_PALETTE_FIRST + i * EXPLOSION_COLORS, EXPLOSION_COLORS, faded);
+    }
+    
+    for (int i = 0; i < MAX_PARTICLES; i++) {
+        if (!particles[i].active) continue;
+        drawTriangleIndexed(canvas, particles[i].cx, particles[i].cy, particles[i].size,
+                            particles[i].angle, particles[i].index);
+    }
+}
+
+// Check whether any particle is still alive
+bool isExplosionActive(void) {
+    for (int i = 0; i < MAX_PARTICLES; i++) {
+        if (particles[i].active) return true;
     }
+    return false;
 }
@@ -0,0 +1,378 @@
+#include "../include/frame_capture.h"
+#include <stdlib.h>
+#include <string.h>
+
+CaptureFormat frameCapture_formatForPath(const char* path) {
+    const char* ext = strrchr(path, '.');
+    if (ext && strcmp(ext, ".png") == 0) return CAPTURE_PNG;
+    if (ext && strcmp(ext, ".y4m") == 0) return CAPTURE_Y4M;
+    return CAPTURE_RAW;
+}
+
+// Y4M: 4:2:0 planes in full-range BT.601, chroma from the mean of each 2x2 block
+static bool writeY4M(FrameCapture* c, const uint32_t* frame) {
+    int w = c->width, h = c->height;
+    int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    uint8_t* yPlane = c->scratch;
+    uint8_t* uPlane = yPlane + (size_t)w * h;
+    uint8_t* vPlane = uPlane + (size_t)cw * ch;
+
+    for (int i = 0; i < w * h; i++) {
+        uint32_t p = frame[i];
+        int r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+        yPlane[i] = (uint8_t)((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+    }
+    for (int cy = 0; cy < ch; cy++) {
+        int y0 = cy * 2, y1 = y0 + 1 < h ? y0 + 1 : y0;
+        for (int cx = 0; cx < cw; cx++) {
+            int x0 = cx * 2, x1 = x0 + 1 < w ? x0 + 1 : x0;
+            uint32_t q[4] = { frame[y0 * w + x0], frame[y0 * w + x1], frame[y1 * w + x0], frame[y1 * w + x1] };
+            int r = 0, g = 0, b = 0;
+            for (int k = 0; k < 4; k++) {
+                r += (q[k] >> 16) & 0xFF;
+                g += (q[k] >> 8) & 0xFF;
+                b += q[k] & 0xFF;
+            }
+            // Sums of four pixels: the weights carry an extra factor 1/4
+            int u = (-11059 * r - 21709 * g + 32768 * b + (128 << 18) + (1 << 17)) >> 18;
+            int v = (32768 * r - 27439 * g - 5329 * b + (128 << 18) + (1 << 17)) >> 18;
+            uPlane[cy * cw + cx] = (uint8_t)(u > 255 ? 255 : u);
+            vPlane[cy * cw + cx] = (uint8_t)(v > 255 ? 255 : v);
+        }
+    }
+
+    size_t size = (size_t)w * h + 2 * (size_t)cw * ch;
+    return fputs("FRAME\n", c->file) >= 0 && fwrite(c->scratch, 1, size, c->file) == size;
+}
+
+static uint32_t crcTable[256];
+static pthread_once_t crcOnce = PTHREAD_ONCE_INIT;
+
+static void initCrcTable(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t k = n;
+        for (int i = 0; i < 8; i++) k = (k & 1) ? 0xEDB88320u ^ (k >> 1) : k >> 1;
+        crcTable[n] = k;
+    }
+}
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// PNG chunk: length, type, data, CRC of type and data
+static bool writeChunk(FILE* file, const char* type, const uint8_t* data, size_t size) {
+    uint8_t header[8], crc[4];
+    put32(header, (uint32_t)size);
+    memcpy(header + 4, type, 4);
+    put32(crc, ~crc32Update(crc32Update(0xFFFFFFFFu, header + 4, 4), data, size));
+    return fwrite(header, 1, 8, file) == 8 && fwrite(data, 1, size, file) == size &&
+           fwrite(crc, 1, 4, file) == 4;
+}
+
+// Stored (uncompressed) deflate blocks hold at most 65535 bytes
+#define PNG_BLOCK 65535
+
+// Bytes of the zlib stream holding an image of rawSize bytes in stored blocks
+static size_t pngStreamSize(size_t rawSize) {
+    size_t blocks = rawSize / PNG_BLOCK + 1;
+    return 2 + rawSize + blocks * 5 + 4;
+}
+
+// PNG: 8-bit RGB, unfiltered rows in stored deflate blocks. Compression is
+// left to the tools that read the sequence; the writer only has to keep up.
+static bool writePNG(FrameCapture* c, const uint32_t* frame) {
+    int w = c->width, h = c->height;
+    size_t rowSize = 1 + (size_t)w * 3;
+    size_t rawSize = rowSize * h;
+
+    // The raw image goes at the end of the scratch buffer, the zlib stream at its start
+    uint8_t* stream = c->scratch;
+    uint8_t* raw = c->scratch + pngStreamSize(rawSize) - rawSize;
+    for (int y = 0; y < h; y++) {
+        uint8_t* row = raw + (size_t)y * rowSize;
+        *row++ = 0; // filter: none
+        for (int x = 0; x < w; x++) {
+            uint32_t p = frame[(size_t)y * w + x];
+            *row++ = (uint8_t)(p >> 16);
+            *row++ = (uint8_t)(p >> 8);
+            *row++ = (uint8_t)p;
+        }
+    }
+
+    // Adler-32 of the raw image, before the blocks overwrite it
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < rawSize; i++) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+
+    // Each block header is written in front of its data, so moving the data
+    // down never overtakes data still to be read
+    size_t out = 0;
+    stream[out++] = 0x78;
+    stream[out++] = 0x01;
+    for (size_t done = 0; done < rawSize; ) {
+        size_t len = rawSize - done < PNG_BLOCK ? rawSize - done : PNG_BLOCK;
+        stream[out++] = done + len == rawSize ? 1 : 0;
+        stream[out++] = (uint8_t)len;
+        stream[out++] = (uint8_t)(len >> 8);
+        stream[out++] = (uint8_t)~len;
+        stream[out++] = (uint8_t)(~len >> 8);
+        memmove(stream + out, raw + done, len);
+        out += len;
+        done += len;
+    }
+    put32(stream + out, (b << 16) | a);
+    out += 4;
+
+    // c->path went through pngPattern: one integer conversion, nothing else
+    char name[1024];
+    int length = snprintf(name, sizeof(name), c->path, (int)c->written);
+    if (length < 0 || (size_t)length >= sizeof(name)) return false;
+    FILE* file = fopen(name, "wb");
+    if (!file) return false;
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8_t ihdr[13];
+    put32(ihdr, (uint32_t)w);
+    put32(ihdr + 4, (uint32_t)h);
+    ihdr[8] = 8;  // bit depth
+    ihdr[9] = 2;  // color type: RGB
+    ihdr[10] = 0; // compression: deflate
+    ihdr[11] = 0; // filter method
+    ihdr[12] = 0; // no interlace
+    bool ok = fwrite(signature, 1, 8, file) == 8 &&
+              writeChunk(file, "IHDR", ihdr, sizeof(ihdr)) &&
+              writeChunk(file, "IDAT", stream, out) &&
+              writeChunk(file, "IEND", NULL, 0);
+    return fclose(file) == 0 && ok;
+}
+
+static bool writeFrame(FrameCapture* c, const uint32_t* frame) {
+    switch (c->format) {
+        case CAPTURE_Y4M:
+            return writeY4M(c, frame);
+        case CAPTURE_PNG:
+            return writePNG(c, frame);
+        case CAPTURE_RAW:
+        default: {
+            size_t size = (size_t)c->width * c->height;
+            return fwrite(frame, sizeof(uint32_t), size, c->file) == size;
+        }
+    }
+}
+
+// Writer thread: write the oldest queued frame until stopped with an empty ring
+static void* writerMain(void* arg) {
+    FrameCapture* c = (FrameCapture*)arg;
+    size_t frameSize = (size_t)c->width * c->height;
+
+    pthread_mutex_lock(&c->mutex);
+    for (;;) {
+        while (c->count == 0 && !c->stop) {
+            pthread_cond_wait(&c->wake, &c->mutex);
+        }
+        if (c->count == 0) break;
+
+        const uint32_t* frame = c->frames + (size_t)c->head * frameSize;
+        bool failed = c->failed;
+        pthread_mutex_unlock(&c->mutex);
+
+        bool ok = !failed && writeFrame(c, frame);
+
+        pthread_mutex_lock(&c->mutex);
+        if (ok) {
+            c->written++;
+        } else {
+            if (!c->failed) fprintf(stderr, "Error: Failed to write capture frame to '%s'\n", c->path);
+            c->failed = true;
+            c->dropped++;
+        }
+        c->head = (c->head + 1) % c->ringFrames;
+        c->count--;
+    }
+    pthread_mutex_unlock(&c->mutex);
+    return NULL;
+}
+
+// PNG file name pattern for path: path itself if its only '%' starts a %d
+// or %0Nd, else path with every '%' escaped and "_%05d" before the extension
+static char* pngPattern(const char* path) {
+    int conversions = 0, others = 0;
+    for (const char* p = strchr(path, '%'); p; p = strchr(p, '%')) {
+        p++;
+        if (*p == '0') {
+            p++;
+            while (*p >= '0' && *p <= '9') p++;
+        }
+        if (*p == 'd') {
+            conversions++;
+            p++;
+        } else {
+            others++;
+        }
+    }
+
+    char* pattern = malloc(2 * strlen(path) + sizeof("_%05d"));
+    if (!pattern) return NULL;
+    if (conversions == 1 && others == 0) {
+        strcpy(pattern, path);
+        return pattern;
+    }
+    const char* ext = strrchr(path, '.');
+    const char* slash = strrchr(path, '/');
+    if (!ext || (slash && ext < slash)) ext = path + strlen(path);
+    char* out = pattern;
+    for (const char* p = path; ; p++) {
+        if (p == ext) {
+            strcpy(out, "_%05d");
+            out += strlen(out);
+        }
+        if (!*p) break;
+        if (*p == '%') *out++ = '%';
+        *out++ = *p;
+    }
+    *out = '\0';
+    return pattern;
+}
+
+bool frameCapture_start(FrameCapture* capture, const char* path, CaptureFormat format,
+                        int width, int height, int fps, int ringFrames) {
+    memset(capture, 0, sizeof(*capture));
+    if (width < 1 || height < 1 || ringFrames < 1) return false;
+    capture->width = width;
+    capture->height = height;
+    capture->fps = fps > 0 ? fps : 60;
+    capture->format = format;
+    capture->ringFrames = ringFrames;
+
+    size_t frameSize = (size_t)width * height;
+    size_t scratchSize = 0;
+    if (format == CAPTURE_Y4M) {
+        scratchSize = frameSize + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2);
+    } else if (format == CAPTURE_PNG) {
+        scratchSize = pngStreamSize((1 + (size_t)width * 3) * height);
+        pthread_once(&crcOnce, initCrcTable);
+    }
+    capture->frames = malloc(frameSize * ringFrames * sizeof(uint32_t));
+    capture->scratch = scratchSize ? malloc(scratchSize) : NULL;
+    if (format == CAPTURE_PNG) {
+        capture->path = pngPattern(path);
+    } else if ((capture->path = malloc(strlen(path) + 1))) {
+        strcpy(capture->path, path);
+    }
+    if (!capture->frames || (scratchSize && !capture->scratch) || !capture->path) goto fail;
+
+    if (format != CAPTURE_PNG) {
+        capture->file = fopen(path, "wb");
+        if (!capture->file) {
+            fprintf(stderr, "Error: Failed to open capture file '%s'\n", path);
+            goto fail;
+        }
+        if (format == CAPTURE_Y4M &&
+            fprintf(capture->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+                    width, height, capture->fps) < 0) {
+            goto fail;
+        }
+    }
+
+    pthread_mutex_init(&capture->mutex, NULL);
+    pthread_cond_init(&capture->wake, NULL);
+    if (pthread_create(&capture->thread, NULL, writerMain, capture) != 0) {
+        pthread_cond_destroy(&capture->wake);
+        pthread_mutex_destroy(&capture->mutex);
+        goto fail;
+    }
+    return true;
+
+fail:
+    if (capture->file) fclose(capture->file);
+    free(capture->frames);
+    free(capture->scratch);
+    free(capture->path);
+    memset(capture, 0, sizeof(*capture));
+    return false;
+}
+
+void frameCapture_submit(FrameCapture* capture, const uint32_t* pixels, int pitch,
+                         int width, int height) {
+    pthread_mutex_lock(&capture->mutex);
+    if (width != capture->width || height != capture->height ||
+        capture->count == capture->ringFrames || capture->failed) {
+        capture->dropped++;
+        pthread_mutex_unlock(&capture->mutex);
+        return;
+    }
+    // The slot past the queued frames is ours until count includes it
+    int slot = (capture->head + capture->count) % capture->ringFrames;
+    pthread_mutex_unlock(&capture->mutex);
+
+    uint32_t* dst = capture->frames + (size_t)slot * width * height;
+    if (pitch == width) {
+        memcpy(dst, pixels, (size_t)width * height * sizeof(uint32_t));
+    } else {
+        for (int y = 0; y < height; y++) {
+            memcpy(dst + (size_t)y * width, pixels + (size_t)y * pitch, (size_t)width * sizeof(uint32_t));
+        }
+    }
+
+    pthread_mutex_lock(&capture->mutex);
+    capture->count++;
+    pthread_cond_signal(&capture->wake);
+    pthread_mutex_unlock(&capture->mutex);
+}
+
+static void captureSink(void* data, const uint32_t* pixels, int pitch, int width, int height) {
+    frameCapture_submit((FrameCapture*)data, pixels, pitch, width, height);
+}
+
+bool frameCapture_attach(FrameCapture* capture, Canvas* canvas) {
+    return Canvas_AddFrameSink(canvas, captureSink, capture);
+}
+
+void frameCapture_detach(FrameCapture* capture, Canvas* canvas) {
+    Canvas_RemoveFrameSink(canvas, captureSink, capture);
+}
+
+void frameCapture_stop(FrameCapture* capture) {
+    if (!capture->frames) return;
+    pthread_mutex_lock(&capture->mutex);
+    capture->stop = true;
+    pthread_cond_signal(&capture->wake);
+    pthread_mutex_unlock(&capture->mutex);
+    pthread_join(capture->thread, NULL);
+
+    if (capture->file && fclose(capture->file) != 0 && !capture->failed) {
+        fprintf(stderr, "Error: Failed to write capture file '%s'\n", capture->path);
+    }
+    printf("Capture '%s': %lld frames written, %lld dropped\n",
+           capture->path, capture->written, capture->dropped);
+
+    pthread_cond_destroy(&capture->wake);
+    pthread_mutex_destroy(&capture->mutex);
+    free(capture->frames);
+    free(capture->scratch);
+    free(capture->path);
+    // The counts stay readable after the stop
+    capture->frames = NULL;
+    capture->scratch = NULL;
+    capture->path = NULL;
+    capture->file = NULL;
+}
+
+long long frameCapture_dropped(FrameCapture* capture) {
+    if (!capture->frames) return capture->dropped;
+    pthread_mutex_lock(&capture->mutex);
+    long long dropped = capture->dropped;
+    pthread_mutex_unlock(&capture->mutex);
+    return dropped;
+}
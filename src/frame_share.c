@@ -0,0 +1,172 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../include/frame_share.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Slots start one cache line into the segment
+#define FRAME_SHARE_SLOTS_OFFSET 64
+
+_Static_assert(sizeof(FrameShareHeader) <= FRAME_SHARE_SLOTS_OFFSET, "header overlaps the slots");
+_Static_assert(sizeof(FrameShareSlot) == 64, "slot header is one cache line");
+
+static FrameShareSlot* slotAt(const FrameShareHeader* header, uint64_t index) {
+    return (FrameShareSlot*)((uint8_t*)header + FRAME_SHARE_SLOTS_OFFSET + index * header->slotBytes);
+}
+
+bool frameShare_create(FrameShare* share, const char* name, int width, int height, int slotCount) {
+    memset(share, 0, sizeof(*share));
+    if (width < 1 || height < 1 || slotCount < 2) return false;
+
+    // Whole cache lines per slot keep neighbouring slots apart
+    size_t slotBytes = sizeof(FrameShareSlot) + (size_t)width * height * sizeof(uint32_t);
+    slotBytes = (slotBytes + 63) & ~(size_t)63;
+    if (slotBytes > UINT32_MAX) return false;
+    size_t size = FRAME_SHARE_SLOTS_OFFSET + slotBytes * slotCount;
+
+    // A fresh segment: readers of an old one keep their own mapping
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Failed to create shared memory '%s'\n", name);
+        return false;
+    }
+    void* base = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0) {
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    share->name = malloc(strlen(name) + 1);
+    if (base == MAP_FAILED || !share->name) {
+        fprintf(stderr, "Error: Failed to map shared memory '%s'\n", name);
+        if (base != MAP_FAILED) munmap(base, size);
+        shm_unlink(name);
+        free(share->name);
+        share->name = NULL;
+        return false;
+    }
+    strcpy(share->name, name);
+    share->base = base;
+    share->size = size;
+
+    // ftruncate zero-fills: every slot sequence starts at 0 (never written)
+    FrameShareHeader* header = (FrameShareHeader*)base;
+    header->slotCount = (uint32_t)slotCount;
+    header->slotBytes = (uint32_t)slotBytes;
+    header->width = (uint32_t)width;
+    header->height = (uint32_t)height;
+    header->version = FRAME_SHARE_VERSION;
+    atomic_store_explicit(&header->latest, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    header->magic = FRAME_SHARE_MAGIC;
+    share->header = header;
+    return true;
+}
+
+void frameShare_publish(FrameShare* share, const uint32_t* pixels, int pitch, int width, int height) {
+    FrameShareHeader* header = share->header;
+    if (!header || width > (int)header->width || height > (int)header->height) return;
+
+    uint64_t frame = ++share->frame;
+    FrameShareSlot* slot = slotAt(header, (frame - 1) % header->slotCount);
+
+    // Odd sequence first, so a reader on this slot sees the change
+    atomic_store_explicit(&slot->sequence, 2 * frame - 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    slot->frame = frame;
+    slot->timestamp = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+    slot->width = (uint32_t)width;
+    slot->height = (uint32_t)height;
+    slot->pitch = (uint32_t)width;
+    uint32_t* dst = (uint32_t*)(slot + 1);
+    if (pitch == width) {
+        memcpy(dst, pixels, (size_t)width * height * sizeof(uint32_t));
+    } else {
+        for (int y = 0; y < height; y++) {
+            memcpy(dst + (size_t)y * width, pixels + (size_t)y * pitch, (size_t)width * sizeof(uint32_t));
+        }
+    }
+
+    atomic_store_explicit(&slot->sequence, 2 * frame, memory_order_release);
+    atomic_store_explicit(&header->latest, frame, memory_order_release);
+}
+
+static void shareSink(void* data, const uint32_t* pixels, int pitch, int width, int height) {
+    frameShare_publish((FrameShare*)data, pixels, pitch, width, height);
+}
+
+bool frameShare_attach(FrameShare* share, Canvas* canvas) {
+    return Canvas_AddFrameSink(canvas, shareSink, share);
+}
+
+void frameShare_detach(FrameShare* share, Canvas* canvas) {
+    Canvas_RemoveFrameSink(canvas, shareSink, share);
+}
+
+void frameShare_destroy(FrameShare* share) {
+    if (!share->base) return;
+    munmap(share->base, share->size);
+    shm_unlink(share->name);
+    free(share->name);
+    memset(share, 0, sizeof(*share));
+}
+
+bool frameShare_openReader(FrameShareReader* reader, const char* name) {
+    memset(reader, 0, sizeof(*reader));
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= FRAME_SHARE_SLOTS_OFFSET) {
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) return false;
+
+    const FrameShareHeader* header = (const FrameShareHeader*)base;
+    if (header->magic != FRAME_SHARE_MAGIC || header->version != FRAME_SHARE_VERSION ||
+        FRAME_SHARE_SLOTS_OFFSET + (size_t)header->slotBytes * header->slotCount > (size_t)st.st_size) {
+        munmap(base, (size_t)st.st_size);
+        return false;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    reader->base = base;
+    reader->size = (size_t)st.st_size;
+    reader->header = header;
+    return true;
+}
+
+const FrameShareSlot* frameShare_latest(const FrameShareReader* reader, uint64_t* sequence) {
+    const FrameShareHeader* header = reader->header;
+    // The slot of the latest frame can be reused before we look at it;
+    // a newer frame is then the latest one, so try again
+    for (int attempt = 0; attempt < 8; attempt++) {
+        uint64_t frame = atomic_load_explicit((_Atomic uint64_t*)&header->latest, memory_order_acquire);
+        if (frame == 0) return NULL;
+        const FrameShareSlot* slot = slotAt(header, (frame - 1) % header->slotCount);
+        uint64_t seq = atomic_load_explicit((_Atomic uint64_t*)&slot->sequence, memory_order_acquire);
+        if (seq == 2 * frame) {
+            *sequence = seq;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+bool frameShare_valid(const FrameShareSlot* slot, uint64_t sequence) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit((_Atomic uint64_t*)&slot->sequence, memory_order_relaxed) == sequence;
+}
+
+void frameShare_closeReader(FrameShareReader* reader) {
+    if (reader->base) munmap((void*)reader->base, reader->size);
+    memset(reader, 0, sizeof(*reader));
+}
@@ -10,7 +10,9 @@
 #include "../include/engine.h"
 #include "../include/input.h"
 #include "../include/triangle.h"
+#include "../include/primitives.h"
 #include "../include/text.h"
+#include "../include/explosion_demo.h"
 #include "hello_world_demo.h"
 
 /**
@@ -39,6 +41,11 @@ static int WINDOW_HEIGHT = 600;           /**< Window height in pixels (default)
 static Triangle triangles[NUM_TRIANGLES]; /**< Array of triangles */
 static Circle circles[NUM_CIRCLES];       /**< Array of circles */
 static bool darkBackground = true;        /**< Background color toggle */
+static bool paused = false;               /**< Shapes frozen (P key) */
+static PostFx glow;                       /**< Trails and bloom (G key), started on first use */
+static bool glowReady = false;            /**< glow holds its passes */
+static bool glowOn = false;               /**< glow runs over every frame */
+static bool wasClicking = false;          /**< Left button held last frame */
 
 /* Layer declarations */
 static void bgUpdate(float dt);
@@ -49,6 +56,10 @@ static void fgUpdate(float dt);
 static void fgRender(void);
 static Layer foreground = { "Foreground", fgUpdate, fgRender, true };
 
+static void fxUpdate(float dt);
+static void fxRender(void);
+static Layer explosions = { "Explosions", fxUpdate, fxRender, true };
+
 /**
  * @brief Generate a random color
  * 
@@ -64,72 +75,6 @@ static Color randomColor(void) {
     return c;
 }
 
-/**
- * @brief Draw a circle at the specified position
- * 
- * Implements a filled circle using Bresenham's circle algorithm.
- * 
- * @param canvas Pointer to the Canvas to draw on
- * @param cx X-coordinate of circle center
- * @param cy Y-coordinate of circle center
- * @param radius Radius of the circle in pixels
- * @param color Color to use for drawing the circle
- */
-static void drawCircle(Canvas* canvas, float cx, float cy, float radius, Color color) {
-    // Draw a circle using Bresenham's circle algorithm
-    int x = 0;
-    int y = (int)radius;
-    int d = 3 - 2 * (int)radius;
-    
-    while (y >= x) {
-        // Draw the eight octants
-        Canvas_PutPixel(canvas, (int)cx + x, (int)cy + y, color);
-        Canvas_PutPixel(canvas, (int)cx + y, (int)cy + x, color);
-        Canvas_PutPixel(canvas, (int)cx - x, (int)cy + y, color);
-        Canvas_PutPixel(canvas, (int)cx - y, (int)cy + x, color);
-        Canvas_PutPixel(canvas, (int)cx + x, (int)cy - y, color);
-        Canvas_PutPixel(canvas, (int)cx + y, (int)cy - x, color);
-        Canvas_PutPixel(canvas, (int)cx - x, (int)cy - y, color);
-        Canvas_PutPixel(canvas, (int)cx - y, (int)cy - x, color);
-        
-        if (d < 0) {
-            d = d + 4 * x + 6;
-        } else {
-            d = d + 4 * (x - y) + 10;
-            y--;
-        }
-        x++;
-    }
-    
-    // Fill the circle
-    for (int r = 0; r < radius; r++) {
-        int x = 0;
-        int y = r;
-        int d = 3 - 2 * r;
-        
-        while (y >= x) {
-            // Draw horizontal lines between the points
-            for (int i = (int)cx - x; i <= (int)cx + x; i++) {
-                Canvas_PutPixel(canvas, i, (int)cy + y, color);
-                Canvas_PutPixel(canvas, i, (int)cy - y, color);
-            }
-            
-            for (int i = (int)cx - y; i <= (int)cx + y; i++) {
-                Canvas_PutPixel(canvas, i, (int)cy + x, color);
-                Canvas_PutPixel(canvas, i, (int)cy - x, color);
-            }
-            
-            if (d < 0) {
-                d = d + 4 * x + 6;
-            } else {
-                d = d + 4 * (x - y) + 10;
-                y--;
-            }
-            x++;
-        }
-    }
-}
-
 /**
  * @brief Set the window dimensions for the hello world demo
  * 
@@ -193,6 +138,15 @@ void helloWorldDemo_Setup(void) {
     // Register layers
     registerLayer(&background);
     registerLayer(&foreground);
+    registerLayer(&explosions);
+    setLayerCached("Background", true); /* Only changes when SPACE toggles it */
+    
+    // Explosions draw palette indices over the frame and fade through the palette
+    initExplosionDemo(WINDOW_WIDTH, WINDOW_HEIGHT);
+    if (!Canvas_SetIndexed(getCanvas(), true)) {
+        fprintf(stderr, "Error: Failed to enable indexed mode, explosions are off\n");
+        explosions.enabled = false;
+    }
     
     // Initialize text rendering with font from assets/fonts directory
     if (!textInit("Ribeye-Regular.ttf", 24)) {
@@ -204,13 +158,17 @@ void helloWorldDemo_Setup(void) {
     printf("Hello World Demo with Bouncing Shapes\n");
     printf("Controls:\n");
     printf("  SPACE: Toggle background color\n");
+    printf("  P: Pause/resume the shapes\n");
+    printf("  G: Toggle motion trails and glow\n");
+    printf("  Click: Spawn an explosion (indexed mode, palette fade)\n");
     printf("  ESC: Exit\n");
 }
 
 /**
  * @brief Background layer update function
  * 
- * Handles space key to toggle background color.
+ * Handles space key to toggle background color and G to toggle the
+ * trails and glow post-processing.
  * 
  * @param dt Delta time in seconds since last update
  */
@@ -219,9 +177,21 @@ static void bgUpdate(float dt) {
     // We still handle the space key here as it's background-related
     if (wasKeyJustPressed(SDL_SCANCODE_SPACE)) {
         darkBackground = !darkBackground;
+        invalidateLayer("Background");
         printf("Background color toggled: %s\n", darkBackground ? "Dark" : "Dark Blue");
     }
     
+    // Trails fade the last frames out behind the shapes, the bloom makes bright ones glow
+    if (wasKeyJustPressed(SDL_SCANCODE_G)) {
+        if (!glowReady) {
+            glowReady = postFx_init(&glow, 0) && postFx_addDecay(&glow, 0.85f) &&
+                        postFx_addBloom(&glow, 96, 6, 2, 0.9f);
+        }
+        glowOn = glowReady && !glowOn;
+        setPostProcess(glowOn ? &glow : NULL);
+        printf("Trails and glow: %s\n", glowOn ? "On" : "Off");
+    }
+    
     (void)dt; // Avoid unused parameter warning
 }
 
@@ -235,12 +205,8 @@ static void bgRender(void) {
     
     // If darkBackground is false, fill with dark blue
     if (!darkBackground) {
-        for (int y = 0; y < WINDOW_HEIGHT; y++) {
-            for (int x = 0; x < WINDOW_WIDTH; x++) {
-                Color darkBlue = {20, 20, 50};
-                Canvas_PutPixel(canvas, x - WINDOW_WIDTH/2, WINDOW_HEIGHT/2 - y, darkBlue);
-            }
-        }
+        Color darkBlue = {20, 20, 50};
+        fillRect(canvas, 0.0f, 0.0f, (float)WINDOW_WIDTH, (float)WINDOW_HEIGHT, darkBlue);
     }
 }
 
@@ -253,9 +219,19 @@ static void bgRender(void) {
  * @param dt Delta time in seconds since last update
  */
 static void fgUpdate(float dt) {
+    // Checked before inputUpdate below, which clears the key's transition
+    if (wasKeyJustPressed(SDL_SCANCODE_P)) {
+        paused = !paused;
+        printf("Shapes %s\n", paused ? "paused" : "resumed");
+    }
+    
     // Process input first - this is the main input update for all layers
     inputUpdate();
     
+    // Frozen shapes need no new frames: the engine sleeps until the next key
+    if (paused) return;
+    requestFrame();
+    
     // Update triangles (rotate them)
     for (int i = 0; i < NUM_TRIANGLES; i++) {
         // Rotate triangle based on its speed
@@ -333,8 +309,36 @@ static void fgRender(void) {
     
     // Draw all circles
     for (int i = 0; i < NUM_CIRCLES; i++) {
-        drawCircle(canvas, circles[i].cx, circles[i].cy, circles[i].radius, circles[i].color);
+        fillCircle(canvas, circles[i].cx, circles[i].cy, circles[i].radius, circles[i].color);
     }
 }
 
+/**
+ * @brief Explosion layer update function
+ * 
+ * Spawns an explosion where the left button goes down and moves the
+ * particles. Runs on while paused, requesting frames until they are gone.
+ * 
+ * @param dt Delta time in seconds since last update
+ */
+static void fxUpdate(float dt) {
+    bool clicking = isLeftMousePressed();
+    if (clicking && !wasClicking) {
+        handleClickExplosion((float)getMouseX(), (float)getMouseY());
+    }
+    wasClicking = clicking;
+    
+    updateExplosion(dt);
+    if (isExplosionActive()) requestFrame();
+}
+
+/**
+ * @brief Explosion layer render function
+ * 
+ * Draws the particles into the index buffer, over everything else.
+ */
+static void fxRender(void) {
+    renderExplosionIndexed(getCanvas());
+}
+
 /* End of the hello world demo implementation */
@@ -7,6 +7,9 @@
  *   - Randomly placed bouncing triangles with rotation
  *   - Randomly placed bouncing circles
  *   - Toggleable background color with SPACE key
+ *   - Pausing with P, which lets the engine idle (on-demand rendering)
+ *   - Motion trails and glow with G (post-processing)
+ *   - Click explosions drawn in indexed mode, faded through the palette
  * 
  * Demonstrates basic usage of the tlacuilolli engine, layers,
  * primitive shape rendering and text display.
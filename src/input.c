@@ -1,4 +1,5 @@
 #include "../include/input.h"
+#include "../include/camera.h"
 #include <SDL2/SDL.h>
 
 // Current state
@@ -94,3 +95,7 @@ int getMouseX(void) {
 int getMouseY(void) {
     return mouseY;
 }
+
+void getMouseWorld(const struct Camera* camera, float* x, float* y) {
+    camera_canvasToWorld(camera, (float)mouseX, (float)mouseY, x, y);
+}
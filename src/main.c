@@ -11,18 +11,35 @@
  * - Rendering bouncing circles with physics
  * - Displaying "Hello World!" text
  * - Handling space key to toggle background color
+ * - Pausing with P, after which the engine renders only on input
+ * - Clicking for explosions, drawn in indexed mode over the other shapes
  * 
  * @see hello_world_demo.h for the demo's API details
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
 #include "../include/engine.h"
+#include "../include/frame_capture.h"
+#include "../include/frame_share.h"
 #include "hello_world_demo.h" /* Import our hello world demo module */
 
 /* Window configuration */
 #define WINDOW_WIDTH   800 /* Window width in pixels */
 #define WINDOW_HEIGHT  600 /* Window height in pixels */
 #define TARGET_FPS     60  /* Target frame rate */
+#define CAPTURE_FRAMES 16  /* Frames that can wait for the disk before captures drop */
+#define SHARE_SLOTS    3   /* Frames kept in the shared-memory ring */
+
+/* Frame capture requested with --capture (NULL = none) */
+static const char* capturePath = NULL;
+static FrameCapture capture;
+
+/* Shared-memory frame export requested with --share (NULL = none) */
+static const char* shareName = NULL;
+static FrameShare share;
 
 /**
  * @brief Setup function - automatically called by the engine at startup
@@ -33,6 +50,49 @@
 void setup(void) {
     /* Call the hello world demo's setup function directly */
     helloWorldDemo_Setup();
+    
+    /* The demo requests frames while its shapes move; paused, the engine idles */
+    setOnDemandRendering(true);
+    
+    /* The canvas exists now, so recording can start at its buffer size */
+    if (capturePath) {
+        Canvas* canvas = getCanvas();
+        if (frameCapture_start(&capture, capturePath, frameCapture_formatForPath(capturePath),
+                               canvas->bufferWidth, canvas->bufferHeight, TARGET_FPS, CAPTURE_FRAMES)) {
+            frameCapture_attach(&capture, canvas);
+        } else {
+            fprintf(stderr, "Error: Failed to start capture to '%s'\n", capturePath);
+        }
+    }
+    
+    /* Slots of the full logical size fit the frames at any render scale */
+    if (shareName) {
+        Canvas* canvas = getCanvas();
+        if (frameShare_create(&share, shareName, canvas->width, canvas->height, SHARE_SLOTS)) {
+            frameShare_attach(&share, canvas);
+        }
+    }
+}
+
+/**
+ * @brief Run the demo without a display and report its frame time
+ * 
+ * Renders the given number of frames at a fixed 1/TARGET_FPS step into
+ * the headless canvas, for measuring throughput on machines without a screen.
+ * 
+ * @param frames Number of frames to render
+ * @return Exit code (0 on success, non-zero on failure)
+ */
+static int runHeadless(int frames) {
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    int result = runEngineHeadless(WINDOW_WIDTH, WINDOW_HEIGHT, frames, 1.0f / TARGET_FPS);
+    gettimeofday(&end, NULL);
+    if (result != 0) return result;
+
+    double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+    printf("%d frames in %.1f ms (%.3f ms/frame)\n", frames, ms, frames > 0 ? ms / frames : 0.0);
+    return 0;
 }
 
 /**
@@ -41,12 +101,44 @@ void setup(void) {
  * Initializes the hello world demo with proper window dimensions,
  * then starts the engine which will call our setup() function.
  * 
+ * Options:
+ * - "--headless FRAMES" renders that many frames without a window and exits
+ * - "--capture PATH" records every frame to PATH: .y4m, .png (one file per
+ *   frame; PATH may hold the number as %d or %0Nd, e.g. frame_%05d.png) or
+ *   raw ARGB for anything else
+ * - "--share NAME" publishes every frame to the POSIX shared memory NAME
+ *   (e.g. /tlacuilolli) for other processes (see frame_share.h)
+ * 
  * @return Exit code (0 on success, non-zero on failure)
  */
-int main(void) {
+int main(int argc, char** argv) {
+    int headlessFrames = -1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            headlessFrames = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--capture") == 0) {
+            capturePath = argv[i + 1];
+        } else if (strcmp(argv[i], "--share") == 0) {
+            shareName = argv[i + 1];
+        } else {
+            fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+    
     /* Set dimensions for the hello world demo */
     helloWorldDemo_SetDimensions(WINDOW_WIDTH, WINDOW_HEIGHT);
     
-    /* Run the engine with the window parameters */
-    return runEngine("Hello World Bouncing Shapes", WINDOW_WIDTH, WINDOW_HEIGHT, TARGET_FPS);
+    int result;
+    if (headlessFrames >= 0) {
+        result = runHeadless(headlessFrames);
+    } else {
+        /* Run the engine with the window parameters */
+        result = runEngine("Hello World Bouncing Shapes", WINDOW_WIDTH, WINDOW_HEIGHT, TARGET_FPS);
+    }
+    
+    /* The canvas is gone: flush what is still queued and report drops */
+    frameCapture_stop(&capture);
+    frameShare_destroy(&share);
+    return result;
 }
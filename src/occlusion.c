@@ -0,0 +1,300 @@
+#include "../include/occlusion.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Vertices beyond this are left to the rasterizer, which rejects them;
+// it also keeps the scalar bounds from overflowing
+#define COVERAGE_GUARD_BAND 16384
+
+void coverage_init(CoverageBuffer* coverage) {
+    memset(coverage, 0, sizeof(*coverage));
+}
+
+void coverage_free(CoverageBuffer* coverage) {
+    free(coverage->blocks);
+    free(coverage->tiles);
+    free(coverage->order);
+    free(coverage->sortScratch);
+    free(coverage->keyScratch);
+    memset(coverage, 0, sizeof(*coverage));
+}
+
+// Bits first..last (0..7) of a block row
+static uint64_t rowBits(int first, int last) {
+    return (0xFFull >> (7 - (last - first))) << first;
+}
+
+// Rows first..last (0..7) of a block, each with the bits of columns
+static uint64_t rectBits(uint64_t columns, int first, int last) {
+    uint64_t rows = (~0ull >> (56 - 8 * (last - first))) << (8 * first);
+    return (columns * 0x0101010101010101ull) & rows;
+}
+
+bool coverage_begin(CoverageBuffer* coverage, int width, int height) {
+    coverage->occluded = 0;
+    if (width != coverage->width || height != coverage->height || !coverage->blocks) {
+        int blocksX = (width + COVERAGE_BLOCK_SIZE - 1) / COVERAGE_BLOCK_SIZE;
+        int blocksY = (height + COVERAGE_BLOCK_SIZE - 1) / COVERAGE_BLOCK_SIZE;
+        int tilesX = (width + COVERAGE_TILE_SIZE - 1) / COVERAGE_TILE_SIZE;
+        int tilesY = (height + COVERAGE_TILE_SIZE - 1) / COVERAGE_TILE_SIZE;
+        uint64_t* blocks = malloc(sizeof(uint64_t) * (size_t)blocksX * blocksY);
+        uint64_t* tiles = malloc(sizeof(uint64_t) * (size_t)tilesX * tilesY);
+        if (!blocks || !tiles) {
+            free(blocks);
+            free(tiles);
+            return false;
+        }
+        free(coverage->blocks);
+        free(coverage->tiles);
+        coverage->blocks = blocks;
+        coverage->tiles = tiles;
+        coverage->blocksX = blocksX;
+        coverage->blocksY = blocksY;
+        coverage->tilesX = tilesX;
+        coverage->tilesY = tilesY;
+        coverage->width = width;
+        coverage->height = height;
+    }
+
+    memset(coverage->blocks, 0, sizeof(uint64_t) * (size_t)coverage->blocksX * coverage->blocksY);
+    memset(coverage->tiles, 0, sizeof(uint64_t) * (size_t)coverage->tilesX * coverage->tilesY);
+
+    // Pixels past the right and bottom edges count as covered
+    int lastX = width - 1 - (coverage->blocksX - 1) * COVERAGE_BLOCK_SIZE;
+    int lastY = height - 1 - (coverage->blocksY - 1) * COVERAGE_BLOCK_SIZE;
+    if (lastX < 7) {
+        uint64_t outside = rectBits(rowBits(lastX + 1, 7), 0, 7);
+        for (int by = 0; by < coverage->blocksY; by++) {
+            coverage->blocks[(size_t)by * coverage->blocksX + coverage->blocksX - 1] |= outside;
+        }
+    }
+    if (lastY < 7) {
+        uint64_t outside = rectBits(0xFF, lastY + 1, 7);
+        for (int bx = 0; bx < coverage->blocksX; bx++) {
+            coverage->blocks[(size_t)(coverage->blocksY - 1) * coverage->blocksX + bx] |= outside;
+        }
+    }
+
+    // So do the blocks of the edge tiles that lie past the buffer
+    int tileBlocks = COVERAGE_TILE_SIZE / COVERAGE_BLOCK_SIZE;
+    int lastBlockX = coverage->blocksX - 1 - (coverage->tilesX - 1) * tileBlocks;
+    int lastBlockY = coverage->blocksY - 1 - (coverage->tilesY - 1) * tileBlocks;
+    for (int ty = 0; ty < coverage->tilesY; ty++) {
+        for (int tx = 0; tx < coverage->tilesX; tx++) {
+            uint64_t outside = 0;
+            if (tx == coverage->tilesX - 1 && lastBlockX < 7) outside |= rectBits(rowBits(lastBlockX + 1, 7), 0, 7);
+            if (ty == coverage->tilesY - 1 && lastBlockY < 7) outside |= rectBits(0xFF, lastBlockY + 1, 7);
+            coverage->tiles[(size_t)ty * coverage->tilesX + tx] = outside;
+        }
+    }
+    return true;
+}
+
+static bool ensureOrderCapacity(CoverageBuffer* c, int count) {
+    if (count <= c->capacity) return true;
+    int capacity = c->capacity ? c->capacity * 2 : 1024;
+    while (capacity < count) capacity *= 2;
+
+    int* order = realloc(c->order, sizeof(int) * (size_t)capacity);
+    if (!order) return false;
+    c->order = order;
+    int* sortScratch = realloc(c->sortScratch, sizeof(int) * (size_t)capacity);
+    if (!sortScratch) return false;
+    c->sortScratch = sortScratch;
+    uint32_t* keyScratch = realloc(c->keyScratch, sizeof(uint32_t) * 2 * (size_t)capacity);
+    if (!keyScratch) return false;
+    c->keyScratch = keyScratch;
+
+    c->capacity = capacity;
+    return true;
+}
+
+bool coverage_sortFrontToBack(CoverageBuffer* coverage, const bool* visible, const uint32_t* keys,
+                              int count) {
+    if (!ensureOrderCapacity(coverage, count)) return false;
+
+    // Visible primitives, last submitted first
+    int n = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        if (visible[i]) coverage->order[n++] = i;
+    }
+    coverage->orderCount = n;
+    if (!keys) return true;
+
+    // Stable LSD radix sort on the inverted keys (highest key first), one
+    // byte per pass. Passes over a byte every key shares are skipped.
+    int* items = coverage->order;
+    int* itemsOut = coverage->sortScratch;
+    uint32_t* sortKeys = coverage->keyScratch;
+    uint32_t* sortKeysOut = coverage->keyScratch + coverage->capacity;
+    for (int i = 0; i < n; i++) sortKeys[i] = ~keys[items[i]];
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        int counts[256] = {0};
+        for (int i = 0; i < n; i++) counts[(sortKeys[i] >> shift) & 0xFF]++;
+        if (n == 0 || counts[(sortKeys[0] >> shift) & 0xFF] == n) continue;
+
+        int offset = 0;
+        for (int d = 0; d < 256; d++) {
+            int bucket = counts[d];
+            counts[d] = offset;
+            offset += bucket;
+        }
+        for (int i = 0; i < n; i++) {
+            int at = counts[(sortKeys[i] >> shift) & 0xFF]++;
+            itemsOut[at] = items[i];
+            sortKeysOut[at] = sortKeys[i];
+        }
+
+        int* t = items; items = itemsOut; itemsOut = t;
+        uint32_t* k = sortKeys; sortKeys = sortKeysOut; sortKeysOut = k;
+    }
+
+    // An odd number of passes leaves the result in the scratch array
+    if (items != coverage->order) {
+        coverage->sortScratch = coverage->order;
+        coverage->order = items;
+    }
+    return true;
+}
+
+bool coverage_isOccluded(const CoverageBuffer* coverage, int minX, int minY, int maxX, int maxY) {
+    int bx0 = minX >> 3, bx1 = maxX >> 3;
+    int by0 = minY >> 3, by1 = maxY >> 3;
+
+    // Tiles first: are all the blocks the rectangle touches full?
+    bool blocksFull = true;
+    for (int ty = by0 >> 3; ty <= by1 >> 3 && blocksFull; ty++) {
+        int first = by0 - ty * 8 > 0 ? by0 - ty * 8 : 0;
+        int last = by1 - ty * 8 < 7 ? by1 - ty * 8 : 7;
+        for (int tx = bx0 >> 3; tx <= bx1 >> 3; tx++) {
+            int left = bx0 - tx * 8 > 0 ? bx0 - tx * 8 : 0;
+            int right = bx1 - tx * 8 < 7 ? bx1 - tx * 8 : 7;
+            uint64_t need = rectBits(rowBits(left, right), first, last);
+            if ((coverage->tiles[(size_t)ty * coverage->tilesX + tx] & need) != need) {
+                blocksFull = false;
+                break;
+            }
+        }
+    }
+    if (blocksFull) return true;
+
+    // Then the pixels of every block
+    for (int by = by0; by <= by1; by++) {
+        int first = minY - by * 8 > 0 ? minY - by * 8 : 0;
+        int last = maxY - by * 8 < 7 ? maxY - by * 8 : 7;
+        for (int bx = bx0; bx <= bx1; bx++) {
+            int left = minX - bx * 8 > 0 ? minX - bx * 8 : 0;
+            int right = maxX - bx * 8 < 7 ? maxX - bx * 8 : 7;
+            uint64_t need = rectBits(rowBits(left, right), first, last);
+            if ((coverage->blocks[(size_t)by * coverage->blocksX + bx] & need) != need) return false;
+        }
+    }
+    return true;
+}
+
+unsigned coverage_testTriangles(CoverageBuffer* coverage, const int vx[3][SIMD_LANES],
+                                const int vy[3][SIMD_LANES], int count) {
+    // Screen bounds clipped to the buffer, inclusive, one lane per triangle
+    int minX[SIMD_LANES], minY[SIMD_LANES], maxX[SIMD_LANES], maxY[SIMD_LANES];
+    unsigned guarded = 0; // lanes left to the rasterizer
+    int halfW = coverage->width / 2;
+    int halfH = coverage->height / 2;
+
+#if defined(__AVX2__)
+    __m256i x0 = _mm256_loadu_si256((const __m256i*)vx[0]);
+    __m256i x1 = _mm256_loadu_si256((const __m256i*)vx[1]);
+    __m256i x2 = _mm256_loadu_si256((const __m256i*)vx[2]);
+    __m256i y0 = _mm256_loadu_si256((const __m256i*)vy[0]);
+    __m256i y1 = _mm256_loadu_si256((const __m256i*)vy[1]);
+    __m256i y2 = _mm256_loadu_si256((const __m256i*)vy[2]);
+    __m256i guard = _mm256_set1_epi32(COVERAGE_GUARD_BAND);
+    __m256i far = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_abs_epi32(x0), guard),
+                        _mm256_cmpgt_epi32(_mm256_abs_epi32(x1), guard)),
+        _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_abs_epi32(x2), guard),
+                        _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_abs_epi32(y0), guard),
+                                        _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_abs_epi32(y1), guard),
+                                                        _mm256_cmpgt_epi32(_mm256_abs_epi32(y2), guard)))));
+    guarded = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(far));
+
+    // Canvas y points up: the top screen row comes from the largest y
+    __m256i half_w = _mm256_set1_epi32(halfW);
+    __m256i half_h = _mm256_set1_epi32(halfH);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i right = _mm256_set1_epi32(coverage->width - 1);
+    __m256i bottom = _mm256_set1_epi32(coverage->height - 1);
+    __m256i left_x = _mm256_add_epi32(half_w, _mm256_min_epi32(_mm256_min_epi32(x0, x1), x2));
+    __m256i right_x = _mm256_add_epi32(half_w, _mm256_max_epi32(_mm256_max_epi32(x0, x1), x2));
+    __m256i top_y = _mm256_sub_epi32(half_h, _mm256_max_epi32(_mm256_max_epi32(y0, y1), y2));
+    __m256i bottom_y = _mm256_sub_epi32(half_h, _mm256_min_epi32(_mm256_min_epi32(y0, y1), y2));
+    _mm256_storeu_si256((__m256i*)minX, _mm256_max_epi32(left_x, zero));
+    _mm256_storeu_si256((__m256i*)maxX, _mm256_min_epi32(right_x, right));
+    _mm256_storeu_si256((__m256i*)minY, _mm256_max_epi32(top_y, zero));
+    _mm256_storeu_si256((__m256i*)maxY, _mm256_min_epi32(bottom_y, bottom));
+#elif defined(__SSE2__)
+    // SSE2 has no 32-bit min/max or abs: select through compare masks
+#define MIN_EPI32(a, b) _mm_or_si128(_mm_and_si128(_mm_cmplt_epi32(a, b), a), _mm_andnot_si128(_mm_cmplt_epi32(a, b), b))
+#define MAX_EPI32(a, b) _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi32(a, b), a), _mm_andnot_si128(_mm_cmpgt_epi32(a, b), b))
+#define FAR(v) _mm_or_si128(_mm_cmpgt_epi32(v, guard), _mm_cmplt_epi32(v, neg_guard))
+    __m128i x0 = _mm_loadu_si128((const __m128i*)vx[0]);
+    __m128i x1 = _mm_loadu_si128((const __m128i*)vx[1]);
+    __m128i x2 = _mm_loadu_si128((const __m128i*)vx[2]);
+    __m128i y0 = _mm_loadu_si128((const __m128i*)vy[0]);
+    __m128i y1 = _mm_loadu_si128((const __m128i*)vy[1]);
+    __m128i y2 = _mm_loadu_si128((const __m128i*)vy[2]);
+    __m128i guard = _mm_set1_epi32(COVERAGE_GUARD_BAND);
+    __m128i neg_guard = _mm_set1_epi32(-COVERAGE_GUARD_BAND);
+    __m128i far = _mm_or_si128(_mm_or_si128(FAR(x0), FAR(x1)),
+                               _mm_or_si128(_mm_or_si128(FAR(x2), FAR(y0)), _mm_or_si128(FAR(y1), FAR(y2))));
+    guarded = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(far));
+
+    // Canvas y points up: the top screen row comes from the largest y
+    __m128i half_w = _mm_set1_epi32(halfW);
+    __m128i half_h = _mm_set1_epi32(halfH);
+    __m128i zero = _mm_setzero_si128();
+    __m128i right = _mm_set1_epi32(coverage->width - 1);
+    __m128i bottom = _mm_set1_epi32(coverage->height - 1);
+    __m128i left_x = _mm_add_epi32(half_w, MIN_EPI32(MIN_EPI32(x0, x1), x2));
+    __m128i right_x = _mm_add_epi32(half_w, MAX_EPI32(MAX_EPI32(x0, x1), x2));
+    __m128i top_y = _mm_sub_epi32(half_h, MAX_EPI32(MAX_EPI32(y0, y1), y2));
+    __m128i bottom_y = _mm_sub_epi32(half_h, MIN_EPI32(MIN_EPI32(y0, y1), y2));
+    _mm_storeu_si128((__m128i*)minX, MAX_EPI32(left_x, zero));
+    _mm_storeu_si128((__m128i*)maxX, MIN_EPI32(right_x, right));
+    _mm_storeu_si128((__m128i*)minY, MAX_EPI32(top_y, zero));
+    _mm_storeu_si128((__m128i*)maxY, MIN_EPI32(bottom_y, bottom));
+#undef MIN_EPI32
+#undef MAX_EPI32
+#undef FAR
+#else
+    for (int i = 0; i < count; i++) {
+        int loX = vx[0][i], hiX = vx[0][i], loY = vy[0][i], hiY = vy[0][i];
+        for (int v = 0; v < 3; v++) {
+            if (abs(vx[v][i]) > COVERAGE_GUARD_BAND || abs(vy[v][i]) > COVERAGE_GUARD_BAND) guarded |= 1u << i;
+            if (vx[v][i] < loX) loX = vx[v][i];
+            if (vx[v][i] > hiX) hiX = vx[v][i];
+            if (vy[v][i] < loY) loY = vy[v][i];
+            if (vy[v][i] > hiY) hiY = vy[v][i];
+        }
+        if (guarded & (1u << i)) {
+            minX[i] = minY[i] = maxX[i] = maxY[i] = 0;
+            continue;
+        }
+        minX[i] = halfW + loX > 0 ? halfW + loX : 0;
+        maxX[i] = halfW + hiX < coverage->width - 1 ? halfW + hiX : coverage->width - 1;
+        minY[i] = halfH - hiY > 0 ? halfH - hiY : 0;
+        maxY[i] = halfH - loY < coverage->height - 1 ? halfH - loY : coverage->height - 1;
+    }
+#endif
+
+    unsigned rejected = 0;
+    for (int i = 0; i < count; i++) {
+        if (guarded & (1u << i)) continue;
+        if (minX[i] > maxX[i] || minY[i] > maxY[i] ||
+            coverage_isOccluded(coverage, minX[i], minY[i], maxX[i], maxY[i])) {
+            rejected |= 1u << i;
+            coverage->occluded++;
+        }
+    }
+    return rejected;
+}
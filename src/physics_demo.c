@@ -1,5 +1,6 @@
 #include "../include/physics_demo.h"
 #include "../include/triangle.h"
+#include "../include/primitives.h"
 #include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
@@ -26,12 +27,12 @@ static float randomRange(float min, float max) {
 }
 
 // Helper function to get a random color
-static Color randomColor(void) {
-    return (Color){
+static PackedColor randomColor(void) {
+    return Canvas_PackColor((Color){
         (uint8_t)(128 + rand() % 128),
         (uint8_t)(128 + rand() % 128),
         (uint8_t)(128 + rand() % 128)
-    };
+    });
 }
 
 // Helper function to create a square with specific properties
@@ -41,50 +42,10 @@ static void createObstacle(int index, float x, float y, float width, float heigh
     obstacles[index].width = width;
     obstacles[index].height = height;
     obstacles[index].angle = angle;
-    obstacles[index].color = color;
+    obstacles[index].color = Canvas_PackColor(color);
     obstacles[index].active = true;
 }
 
-// Function to draw a rotated rectangle
-static void drawRotatedRectangle(Canvas* canvas, const Obstacle* obstacle) {
-    // Calculate the four corners of the rectangle
-    float halfWidth = obstacle->width / 2.0f;
-    float halfHeight = obstacle->height / 2.0f;
-    
-    // Pre-calculate sine and cosine of the angle
-    float cosa = cosf(obstacle->angle);
-    float sina = sinf(obstacle->angle);
-    
-    // Calculate corner positions (rotated around center)
-    float corners[4][2] = {
-        { -halfWidth, -halfHeight }, // Top-left
-        {  halfWidth, -halfHeight }, // Top-right
-        {  halfWidth,  halfHeight }, // Bottom-right
-        { -halfWidth,  halfHeight }  // Bottom-left
-    };
-    
-    int xPoints[4], yPoints[4];
-    
-    // Rotate and translate each corner
-    for (int i = 0; i < 4; i++) {
-        // Rotate point around origin
-        float rx = corners[i][0] * cosa - corners[i][1] * sina;
-        float ry = corners[i][0] * sina + corners[i][1] * cosa;
-        
-        // Just directly add the rotated point to the obstacle center
-        // Our physics is working correctly, and the triangles are interacting properly
-        // So we'll keep this simple coordinate transformation
-        xPoints[i] = (int)(obstacle->cx + rx);
-        yPoints[i] = (int)(obstacle->cy + ry);
-    }
-    
-    // Draw the four lines of the rectangle
-    for (int i = 0; i < 4; i++) {
-        int next = (i + 1) % 4;
-        drawLine(canvas, xPoints[i], yPoints[i], xPoints[next], yPoints[next], obstacle->color);
-    }
-}
-
 // Initialize the physics demo
 void initPhysicsDemo(int canvasW, int canvasH) {
     // Store canvas dimensions for collision detection
@@ -192,11 +153,11 @@ void spawnProjectile(float x, float y, float targetX, float targetY) {
     objects[index].angularVelocity = randomRange(-3.0f, 3.0f);
     
     // Make projectile a bright color to stand out
-    objects[index].color = (Color){
+    objects[index].color = Canvas_PackColor((Color){
         (uint8_t)(180 + rand() % 75),
         (uint8_t)(180 + rand() % 75),
         (uint8_t)(180 + rand() % 75)
-    };
+    });
     
     objects[index].active = true;
 }
@@ -543,28 +504,29 @@ void updatePhysics(float dt) {
     }
 }
 
-// Render all physics objects
-void renderPhysics(Canvas* canvas) {
-    // First render the obstacles
+// Render the obstacles
+void renderObstacles(Canvas* canvas) {
     for (int i = 0; i < OBSTACLE_COUNT; i++) {
         if (obstacles[i].active) {
-            drawRotatedRectangle(canvas, &obstacles[i]);
+            const Obstacle* o = &obstacles[i];
+            fillRotatedRectPacked(canvas, o->cx, o->cy, o->width, o->height, o->angle,
+                                  o->color, BLEND_REPLACE);
         }
     }
-    
-    // Then render the physics objects (triangles)
+}
+
+// Render the physics objects (triangles)
+void renderPhysicsObjects(Canvas* canvas) {
     for (int i = 0; i < PHYSICS_COUNT; i++) {
         if (!objects[i].active) continue;
         
-        // Create a temporary triangle with the physics object properties
-        Triangle t;
-        t.cx = objects[i].cx;
-        t.cy = objects[i].cy;
-        t.size = objects[i].size;
-        t.angle = objects[i].angle;
-        t.color = objects[i].color;
-        
-        // Draw the triangle
-        drawTriangle(canvas, &t);
+        const PhysicsObject* o = &objects[i];
+        drawTrianglePacked(canvas, o->cx, o->cy, o->size, o->angle, o->color);
     }
 }
+
+// Render all physics objects
+void renderPhysics(Canvas* canvas) {
+    renderObstacles(canvas);
+    renderPhysicsObjects(canvas);
+}
@@ -0,0 +1,572 @@
+#include "../include/post_fx.h"
+#include "../include/simd.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline int clampIndex(int i, int count) {
+    return i < 0 ? 0 : (i >= count ? count - 1 : i);
+}
+
+// The box filters divide a running sum of d = 2 * radius + 1 pixels as
+// (sum * recip) >> 16, which is what the 16-bit lanes' mulhi computes.
+// Rounding recip up keeps 255 * d at 255.
+static inline uint32_t boxRecip(int radius) {
+    uint32_t d = (uint32_t)(2 * radius + 1);
+    return (65536u + d - 1) / d;
+}
+
+// ---------------------------------------------------------------------------
+// Decay: dst = max(dst, history * keep / 256) per channel, history = dst
+
+static inline uint32_t maxBytes(uint32_t a, uint32_t b) {
+    uint32_t r = 0;
+    for (int s = 0; s < 32; s += 8) {
+        uint32_t x = (a >> s) & 0xFF, y = (b >> s) & 0xFF;
+        r |= (x > y ? x : y) << s;
+    }
+    return r;
+}
+
+static inline uint32_t fadePixel(uint32_t p, uint32_t keep) {
+    // Two channels per multiply; keep <= 256 keeps every product in its 16 bits
+    uint32_t rb = (((p & 0x00FF00FFu) * keep) >> 8) & 0x00FF00FFu;
+    uint32_t ga = (((p >> 8) & 0x00FF00FFu) * keep) & 0xFF00FF00u;
+    return rb | ga;
+}
+
+static void decayRow(uint32_t* dst, uint32_t* history, int count, int keep) {
+    int x = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i k = _mm256_set1_epi16((short)keep);
+    for (; x + 8 <= count; x += 8) {
+        __m256i h = _mm256_loadu_si256((const __m256i*)(history + x));
+        __m256i lo = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(h, zero), k), 8);
+        __m256i hi = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(h, zero), k), 8);
+        __m256i d = _mm256_max_epu8(_mm256_loadu_si256((const __m256i*)(dst + x)),
+                                    _mm256_packus_epi16(lo, hi));
+        _mm256_storeu_si256((__m256i*)(dst + x), d);
+        _mm256_storeu_si256((__m256i*)(history + x), d);
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i k = _mm_set1_epi16((short)keep);
+    for (; x + 4 <= count; x += 4) {
+        __m128i h = _mm_loadu_si128((const __m128i*)(history + x));
+        __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(h, zero), k), 8);
+        __m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(h, zero), k), 8);
+        __m128i d = _mm_max_epu8(_mm_loadu_si128((const __m128i*)(dst + x)), _mm_packus_epi16(lo, hi));
+        _mm_storeu_si128((__m128i*)(dst + x), d);
+        _mm_storeu_si128((__m128i*)(history + x), d);
+    }
+#endif
+    for (; x < count; x++) {
+        uint32_t d = maxBytes(dst[x], fadePixel(history[x], (uint32_t)keep));
+        dst[x] = d;
+        history[x] = d;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Horizontal box blur of rows [y0, y1). The running sum walks along a row,
+// so the vector paths run several rows side by side instead: 2 rows per
+// SSE2 register and 4 per AVX2 register, 4 16-bit channels each.
+
+static void blurRowScalar(uint32_t* dst, const uint32_t* src, int width, int radius, uint32_t recip) {
+    uint32_t sum[4] = { 0, 0, 0, 0 };
+    for (int k = -radius; k <= radius; k++) {
+        uint32_t p = src[clampIndex(k, width)];
+        for (int c = 0; c < 4; c++) sum[c] += (p >> (8 * c)) & 0xFF;
+    }
+    for (int x = 0; x < width; x++) {
+        uint32_t out = 0;
+        for (int c = 0; c < 4; c++) out |= ((sum[c] * recip) >> 16) << (8 * c);
+        dst[x] = out;
+        uint32_t in = src[clampIndex(x + radius + 1, width)];
+        uint32_t gone = src[clampIndex(x - radius, width)];
+        for (int c = 0; c < 4; c++) sum[c] += ((in >> (8 * c)) & 0xFF) - ((gone >> (8 * c)) & 0xFF);
+    }
+}
+
+// Away from the row ends the vector paths step 4 pixels at a time: 4
+// pixels of each row are loaded at once and transposed into one register
+// per column, and the outputs are transposed back the same way.
+#if defined(__AVX2__)
+static inline __m256i loadColumn4(const uint32_t* const rows[4], int x) {
+    return _mm256_cvtepu8_epi16(_mm_set_epi32((int)rows[3][x], (int)rows[2][x],
+                                              (int)rows[1][x], (int)rows[0][x]));
+}
+
+// Transpose 4 rows of 4 pixels into 4 columns of 4 rows (and back)
+static inline void transpose4(__m128i* a, __m128i* b, __m128i* c, __m128i* d) {
+    __m128i t0 = _mm_unpacklo_epi32(*a, *b), t1 = _mm_unpacklo_epi32(*c, *d);
+    __m128i t2 = _mm_unpackhi_epi32(*a, *b), t3 = _mm_unpackhi_epi32(*c, *d);
+    *a = _mm_unpacklo_epi64(t0, t1);
+    *b = _mm_unpackhi_epi64(t0, t1);
+    *c = _mm_unpacklo_epi64(t2, t3);
+    *d = _mm_unpackhi_epi64(t2, t3);
+}
+
+static inline void loadColumns4(const uint32_t* const rows[4], int x, __m256i col[4]) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(rows[0] + x));
+    __m128i b = _mm_loadu_si128((const __m128i*)(rows[1] + x));
+    __m128i c = _mm_loadu_si128((const __m128i*)(rows[2] + x));
+    __m128i d = _mm_loadu_si128((const __m128i*)(rows[3] + x));
+    transpose4(&a, &b, &c, &d);
+    col[0] = _mm256_cvtepu8_epi16(a);
+    col[1] = _mm256_cvtepu8_epi16(b);
+    col[2] = _mm256_cvtepu8_epi16(c);
+    col[3] = _mm256_cvtepu8_epi16(d);
+}
+
+static inline __m128i packColumn4(__m256i sum, __m256i r) {
+    __m256i out = _mm256_mulhi_epu16(sum, r);
+    return _mm_packus_epi16(_mm256_castsi256_si128(out), _mm256_extracti128_si256(out, 1));
+}
+
+static void blurRows4(uint32_t* const dst[4], const uint32_t* const src[4], int width, int radius,
+                      uint32_t recip) {
+    const __m256i r = _mm256_set1_epi16((short)recip);
+    __m256i sum = _mm256_setzero_si256();
+    for (int k = -radius; k <= radius; k++) sum = _mm256_add_epi16(sum, loadColumn4(src, clampIndex(k, width)));
+    int x = 0;
+    while (x < width) {
+        if (x >= radius && x + radius + 4 < width) {
+            __m256i in[4], gone[4];
+            loadColumns4(src, x + radius + 1, in);
+            loadColumns4(src, x - radius, gone);
+            __m128i out[4];
+            for (int j = 0; j < 4; j++) {
+                out[j] = packColumn4(sum, r);
+                // 16-bit wraparound: the sum is back in range once gone is subtracted
+                sum = _mm256_sub_epi16(_mm256_add_epi16(sum, in[j]), gone[j]);
+            }
+            transpose4(&out[0], &out[1], &out[2], &out[3]);
+            for (int i = 0; i < 4; i++) _mm_storeu_si128((__m128i*)(dst[i] + x), out[i]);
+            x += 4;
+            continue;
+        }
+        __m128i p = packColumn4(sum, r);
+        dst[0][x] = (uint32_t)_mm_cvtsi128_si32(p);
+        dst[1][x] = (uint32_t)_mm_extract_epi32(p, 1);
+        dst[2][x] = (uint32_t)_mm_extract_epi32(p, 2);
+        dst[3][x] = (uint32_t)_mm_extract_epi32(p, 3);
+        sum = _mm256_add_epi16(sum, loadColumn4(src, clampIndex(x + radius + 1, width)));
+        sum = _mm256_sub_epi16(sum, loadColumn4(src, clampIndex(x - radius, width)));
+        x++;
+    }
+}
+#define BLUR_ROWS 4
+#elif defined(__SSE2__)
+static inline __m128i loadColumn2(const uint32_t* const rows[2], int x) {
+    return _mm_unpacklo_epi8(_mm_set_epi32(0, 0, (int)rows[1][x], (int)rows[0][x]), _mm_setzero_si128());
+}
+
+static inline void loadColumns2(const uint32_t* const rows[2], int x, __m128i col[4]) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = _mm_loadu_si128((const __m128i*)(rows[0] + x));
+    __m128i b = _mm_loadu_si128((const __m128i*)(rows[1] + x));
+    __m128i lo = _mm_unpacklo_epi32(a, b), hi = _mm_unpackhi_epi32(a, b);
+    col[0] = _mm_unpacklo_epi8(lo, zero);
+    col[1] = _mm_unpackhi_epi8(lo, zero);
+    col[2] = _mm_unpacklo_epi8(hi, zero);
+    col[3] = _mm_unpackhi_epi8(hi, zero);
+}
+
+static void blurRows2(uint32_t* const dst[2], const uint32_t* const src[2], int width, int radius,
+                      uint32_t recip) {
+    const __m128i r = _mm_set1_epi16((short)recip);
+    __m128i sum = _mm_setzero_si128();
+    for (int k = -radius; k <= radius; k++) sum = _mm_add_epi16(sum, loadColumn2(src, clampIndex(k, width)));
+    int x = 0;
+    while (x < width) {
+        if (x >= radius && x + radius + 4 < width) {
+            __m128i in[4], gone[4], out[4];
+            loadColumns2(src, x + radius + 1, in);
+            loadColumns2(src, x - radius, gone);
+            for (int j = 0; j < 4; j++) {
+                out[j] = _mm_mulhi_epu16(sum, r);
+                // 16-bit wraparound: the sum is back in range once gone is subtracted
+                sum = _mm_sub_epi16(_mm_add_epi16(sum, in[j]), gone[j]);
+            }
+            // Columns 0,1 and 2,3 hold rows 0,1 each: gather each row's pixels
+            __m128i a = _mm_shuffle_epi32(_mm_packus_epi16(out[0], out[1]), _MM_SHUFFLE(3, 1, 2, 0));
+            __m128i b = _mm_shuffle_epi32(_mm_packus_epi16(out[2], out[3]), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i*)(dst[0] + x), _mm_unpacklo_epi64(a, b));
+            _mm_storeu_si128((__m128i*)(dst[1] + x), _mm_unpackhi_epi64(a, b));
+            x += 4;
+            continue;
+        }
+        __m128i p = _mm_packus_epi16(_mm_mulhi_epu16(sum, r), _mm_setzero_si128());
+        dst[0][x] = (uint32_t)_mm_cvtsi128_si32(p);
+        dst[1][x] = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(p, 4));
+        sum = _mm_add_epi16(sum, loadColumn2(src, clampIndex(x + radius + 1, width)));
+        sum = _mm_sub_epi16(sum, loadColumn2(src, clampIndex(x - radius, width)));
+        x++;
+    }
+}
+#define BLUR_ROWS 2
+#else
+#define BLUR_ROWS 1
+#endif
+
+static void blurHorizontal(uint32_t* dst, int dstPitch, const uint32_t* src, int srcPitch,
+                           int width, int y0, int y1, int radius) {
+    uint32_t recip = boxRecip(radius);
+    int y = y0;
+#if BLUR_ROWS > 1
+    for (; y + BLUR_ROWS <= y1; y += BLUR_ROWS) {
+        uint32_t* d[BLUR_ROWS];
+        const uint32_t* s[BLUR_ROWS];
+        for (int i = 0; i < BLUR_ROWS; i++) {
+            d[i] = dst + (size_t)(y + i) * dstPitch;
+            s[i] = src + (size_t)(y + i) * srcPitch;
+        }
+#if defined(__AVX2__)
+        blurRows4(d, s, width, radius, recip);
+#else
+        blurRows2(d, s, width, radius, recip);
+#endif
+    }
+#endif
+    for (; y < y1; y++) {
+        blurRowScalar(dst + (size_t)y * dstPitch, src + (size_t)y * srcPitch, width, radius, recip);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Vertical box blur of rows [y0, y1): one running sum per column and
+// channel, slid down a row at a time, vectorized across the columns. The
+// vector part keeps its sums in the unpacked register order, the scalar
+// tail in pixel order.
+
+// sums += add - sub (sub may be NULL)
+static void slideSums(uint16_t* sums, const uint32_t* add, const uint32_t* sub, int width) {
+    int x = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    for (; x + 8 <= width; x += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(add + x));
+        __m256i s = sub ? _mm256_loadu_si256((const __m256i*)(sub + x)) : zero;
+        __m256i* lo = (__m256i*)(sums + (size_t)x * 4);
+        __m256i* hi = lo + 1;
+        _mm256_storeu_si256(lo, _mm256_sub_epi16(_mm256_add_epi16(_mm256_loadu_si256(lo),
+                            _mm256_unpacklo_epi8(a, zero)), _mm256_unpacklo_epi8(s, zero)));
+        _mm256_storeu_si256(hi, _mm256_sub_epi16(_mm256_add_epi16(_mm256_loadu_si256(hi),
+                            _mm256_unpackhi_epi8(a, zero)), _mm256_unpackhi_epi8(s, zero)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 4 <= width; x += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(add + x));
+        __m128i s = sub ? _mm_loadu_si128((const __m128i*)(sub + x)) : zero;
+        __m128i* lo = (__m128i*)(sums + (size_t)x * 4);
+        __m128i* hi = lo + 1;
+        _mm_storeu_si128(lo, _mm_sub_epi16(_mm_add_epi16(_mm_loadu_si128(lo), _mm_unpacklo_epi8(a, zero)),
+                                           _mm_unpacklo_epi8(s, zero)));
+        _mm_storeu_si128(hi, _mm_sub_epi16(_mm_add_epi16(_mm_loadu_si128(hi), _mm_unpackhi_epi8(a, zero)),
+                                           _mm_unpackhi_epi8(s, zero)));
+    }
+#endif
+    for (; x < width; x++) {
+        uint32_t a = add[x], s = sub ? sub[x] : 0;
+        for (int c = 0; c < 4; c++) {
+            sums[x * 4 + c] = (uint16_t)(sums[x * 4 + c] + ((a >> (8 * c)) & 0xFF) - ((s >> (8 * c)) & 0xFF));
+        }
+    }
+}
+
+static void sumsToRow(uint32_t* dst, const uint16_t* sums, int width, uint32_t recip) {
+    int x = 0;
+#if defined(__AVX2__)
+    const __m256i r = _mm256_set1_epi16((short)recip);
+    for (; x + 8 <= width; x += 8) {
+        const __m256i* s = (const __m256i*)(sums + (size_t)x * 4);
+        __m256i lo = _mm256_mulhi_epu16(_mm256_loadu_si256(s), r);
+        __m256i hi = _mm256_mulhi_epu16(_mm256_loadu_si256(s + 1), r);
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_packus_epi16(lo, hi));
+    }
+#elif defined(__SSE2__)
+    const __m128i r = _mm_set1_epi16((short)recip);
+    for (; x + 4 <= width; x += 4) {
+        const __m128i* s = (const __m128i*)(sums + (size_t)x * 4);
+        __m128i lo = _mm_mulhi_epu16(_mm_loadu_si128(s), r);
+        __m128i hi = _mm_mulhi_epu16(_mm_loadu_si128(s + 1), r);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; x < width; x++) {
+        uint32_t out = 0;
+        for (int c = 0; c < 4; c++) out |= (((uint32_t)sums[x * 4 + c] * recip) >> 16) << (8 * c);
+        dst[x] = out;
+    }
+}
+
+static void blurVertical(uint32_t* dst, int dstPitch, const uint32_t* src, int srcPitch,
+                         int width, int height, int y0, int y1, int radius, uint16_t* sums) {
+    if (y0 >= y1) return;
+    uint32_t recip = boxRecip(radius);
+    memset(sums, 0, sizeof(uint16_t) * 4 * (size_t)width);
+    for (int k = -radius; k <= radius; k++) {
+        slideSums(sums, src + (size_t)clampIndex(y0 + k, height) * srcPitch, NULL, width);
+    }
+    for (int y = y0; y < y1; y++) {
+        sumsToRow(dst + (size_t)y * dstPitch, sums, width, recip);
+        if (y + 1 < y1) {
+            slideSums(sums, src + (size_t)clampIndex(y + radius + 1, height) * srcPitch,
+                      src + (size_t)clampIndex(y - radius, height) * srcPitch, width);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Bloom: glow = max(pixel - threshold, 0), blurred, then pixel += glow * strength / 256
+
+static void thresholdRow(uint32_t* dst, const uint32_t* src, int count, int threshold) {
+    int x = 0;
+    // Alpha is thresholded at 255, so the glow leaves it alone
+    uint32_t t = (uint32_t)threshold * 0x010101u | 0xFF000000u;
+#if defined(__AVX2__)
+    const __m256i tv = _mm256_set1_epi32((int)t);
+    for (; x + 8 <= count; x += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(src + x));
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_subs_epu8(p, tv));
+    }
+#elif defined(__SSE2__)
+    const __m128i tv = _mm_set1_epi32((int)t);
+    for (; x + 4 <= count; x += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(src + x));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_subs_epu8(p, tv));
+    }
+#endif
+    for (; x < count; x++) {
+        uint32_t p = src[x], out = 0;
+        for (int s = 0; s < 32; s += 8) {
+            int c = (int)((p >> s) & 0xFF) - (int)((t >> s) & 0xFF);
+            out |= (uint32_t)(c > 0 ? c : 0) << s;
+        }
+        dst[x] = out;
+    }
+}
+
+static void addGlowRow(uint32_t* dst, const uint32_t* glow, int count, int strength) {
+    int x = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i k = _mm256_set1_epi16((short)strength);
+    for (; x + 8 <= count; x += 8) {
+        __m256i g = _mm256_loadu_si256((const __m256i*)(glow + x));
+        __m256i lo = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(g, zero), k), 8);
+        __m256i hi = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(g, zero), k), 8);
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + x));
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_adds_epu8(d, _mm256_packus_epi16(lo, hi)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i k = _mm_set1_epi16((short)strength);
+    for (; x + 4 <= count; x += 4) {
+        __m128i g = _mm_loadu_si128((const __m128i*)(glow + x));
+        __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(g, zero), k), 8);
+        __m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(g, zero), k), 8);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_adds_epu8(d, _mm_packus_epi16(lo, hi)));
+    }
+#endif
+    for (; x < count; x++) {
+        uint32_t d = dst[x], g = fadePixel(glow[x], (uint32_t)strength), out = 0;
+        for (int s = 0; s < 32; s += 8) {
+            uint32_t c = ((d >> s) & 0xFF) + ((g >> s) & 0xFF);
+            out |= (c > 255 ? 255 : c) << s;
+        }
+        dst[x] = out;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Grade: three table lookups per pixel (AVX2 gathers 8 pixels per table)
+
+static void gradeRow(uint32_t* dst, int count, const uint32_t lut[3][256]) {
+    int x = 0;
+#if defined(__AVX2__)
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+    for (; x + 8 <= count; x += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(dst + x));
+        __m256i r = _mm256_i32gather_epi32((const int*)lut[0], _mm256_and_si256(_mm256_srli_epi32(p, 16), mask), 4);
+        __m256i g = _mm256_i32gather_epi32((const int*)lut[1], _mm256_and_si256(_mm256_srli_epi32(p, 8), mask), 4);
+        __m256i b = _mm256_i32gather_epi32((const int*)lut[2], _mm256_and_si256(p, mask), 4);
+        __m256i out = _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, _mm256_and_si256(p, alpha)));
+        _mm256_storeu_si256((__m256i*)(dst + x), out);
+    }
+#endif
+    for (; x < count; x++) {
+        uint32_t p = dst[x];
+        dst[x] = lut[0][(p >> 16) & 0xFF] | lut[1][(p >> 8) & 0xFF] | lut[2][p & 0xFF] | (p & 0xFF000000u);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+// Blur rows [y0, y1) of image (pitch pixels per row) through tmp, iterations times
+static void blurBand(PostFx* fx, uint32_t* image, int pitch, const PostFxPass* pass,
+                     int y0, int y1, uint16_t* sums) {
+    for (int i = 0; i < pass->iterations; i++) {
+        blurHorizontal(fx->scratch[0], fx->width, image, pitch, fx->width, y0, y1, pass->radius);
+        workerPool_barrier(&fx->pool);
+        blurVertical(image, pitch, fx->scratch[0], fx->width, fx->width, fx->height, y0, y1,
+                     pass->radius, sums);
+        workerPool_barrier(&fx->pool);
+    }
+}
+
+// Every worker runs the whole chain on its row band
+static void postFxJob(void* ctx, int workerIndex, int workerCount) {
+    PostFx* fx = ctx;
+    int y0 = fx->height * workerIndex / workerCount;
+    int y1 = fx->height * (workerIndex + 1) / workerCount;
+    uint16_t* sums = fx->columnSums + (size_t)workerIndex * 4 * fx->width;
+    int w = fx->width;
+
+    for (int p = 0; p < fx->passCount; p++) {
+        const PostFxPass* pass = &fx->passes[p];
+        switch (pass->type) {
+            case POSTFX_DECAY:
+                for (int y = y0; y < y1; y++) {
+                    decayRow(fx->pixels + (size_t)y * fx->pitch, fx->history + (size_t)y * w, w, pass->keep);
+                }
+                break;
+            case POSTFX_BLUR:
+                blurBand(fx, fx->pixels, fx->pitch, pass, y0, y1, sums);
+                break;
+            case POSTFX_BLOOM:
+                for (int y = y0; y < y1; y++) {
+                    thresholdRow(fx->scratch[1] + (size_t)y * w, fx->pixels + (size_t)y * fx->pitch, w,
+                                 pass->threshold);
+                }
+                workerPool_barrier(&fx->pool);
+                blurBand(fx, fx->scratch[1], w, pass, y0, y1, sums);
+                for (int y = y0; y < y1; y++) {
+                    addGlowRow(fx->pixels + (size_t)y * fx->pitch, fx->scratch[1] + (size_t)y * w, w,
+                               pass->strength);
+                }
+                break;
+            case POSTFX_GRADE:
+                for (int y = y0; y < y1; y++) {
+                    gradeRow(fx->pixels + (size_t)y * fx->pitch, w, pass->lut);
+                }
+                break;
+        }
+        workerPool_barrier(&fx->pool);
+    }
+}
+
+bool postFx_init(PostFx* fx, int workerCount) {
+    memset(fx, 0, sizeof(*fx));
+    return workerPool_init(&fx->pool, workerCount);
+}
+
+static void freeBuffers(PostFx* fx) {
+    free(fx->history);
+    free(fx->scratch[0]);
+    free(fx->scratch[1]);
+    free(fx->columnSums);
+    fx->history = fx->scratch[0] = fx->scratch[1] = NULL;
+    fx->columnSums = NULL;
+    fx->width = fx->height = 0;
+}
+
+void postFx_free(PostFx* fx) {
+    workerPool_free(&fx->pool);
+    freeBuffers(fx);
+    fx->passCount = 0;
+}
+
+// Size the buffers for a width x height frame; a new size starts a new trail
+static bool ensureBuffers(PostFx* fx, int width, int height) {
+    if (fx->history && fx->width == width && fx->height == height) return true;
+    freeBuffers(fx);
+    size_t pixels = (size_t)width * height;
+    fx->history = calloc(pixels, sizeof(uint32_t));
+    fx->scratch[0] = malloc(pixels * sizeof(uint32_t));
+    fx->scratch[1] = malloc(pixels * sizeof(uint32_t));
+    fx->columnSums = malloc(sizeof(uint16_t) * 4 * (size_t)width * (size_t)fx->pool.workerCount);
+    if (!fx->history || !fx->scratch[0] || !fx->scratch[1] || !fx->columnSums) {
+        freeBuffers(fx);
+        return false;
+    }
+    fx->width = width;
+    fx->height = height;
+    return true;
+}
+
+static PostFxPass* addPass(PostFx* fx, PostFxPassType type) {
+    if (fx->passCount == POSTFX_MAX_PASSES) return NULL;
+    PostFxPass* pass = &fx->passes[fx->passCount++];
+    memset(pass, 0, sizeof(*pass));
+    pass->type = type;
+    return pass;
+}
+
+static int clampRadius(int radius) {
+    return radius < 1 ? 1 : (radius > POSTFX_MAX_RADIUS ? POSTFX_MAX_RADIUS : radius);
+}
+
+static int toFraction256(float v) {
+    int f = (int)lroundf(v * 256.0f);
+    return f < 0 ? 0 : (f > 256 ? 256 : f);
+}
+
+bool postFx_addDecay(PostFx* fx, float keep) {
+    PostFxPass* pass = addPass(fx, POSTFX_DECAY);
+    if (!pass) return false;
+    pass->keep = toFraction256(keep);
+    return true;
+}
+
+bool postFx_addBlur(PostFx* fx, int radius, int iterations) {
+    PostFxPass* pass = addPass(fx, POSTFX_BLUR);
+    if (!pass) return false;
+    pass->radius = clampRadius(radius);
+    pass->iterations = iterations < 1 ? 1 : iterations;
+    return true;
+}
+
+bool postFx_addBloom(PostFx* fx, int threshold, int radius, int iterations, float strength) {
+    PostFxPass* pass = addPass(fx, POSTFX_BLOOM);
+    if (!pass) return false;
+    pass->threshold = threshold < 0 ? 0 : (threshold > 255 ? 255 : threshold);
+    pass->radius = clampRadius(radius);
+    pass->iterations = iterations < 1 ? 1 : iterations;
+    pass->strength = toFraction256(strength);
+    return true;
+}
+
+bool postFx_addGrade(PostFx* fx, const uint8_t* red, const uint8_t* green, const uint8_t* blue) {
+    PostFxPass* pass = addPass(fx, POSTFX_GRADE);
+    if (!pass) return false;
+    for (int i = 0; i < 256; i++) {
+        pass->lut[0][i] = (uint32_t)red[i] << 16;
+        pass->lut[1][i] = (uint32_t)green[i] << 8;
+        pass->lut[2][i] = blue[i];
+    }
+    return true;
+}
+
+void postFx_clear(PostFx* fx) {
+    fx->passCount = 0;
+    if (fx->history) memset(fx->history, 0, sizeof(uint32_t) * (size_t)fx->width * fx->height);
+}
+
+void postFx_apply(PostFx* fx, Canvas* canvas) {
+    if (fx->passCount == 0) return;
+    if (!ensureBuffers(fx, canvas->bufferWidth, canvas->bufferHeight)) {
+        fprintf(stderr, "Error: Failed to allocate post-processing buffers\n");
+        return;
+    }
+    fx->pixels = canvas->backBuffer;
+    fx->pitch = canvas->pitch;
+    workerPool_run(&fx->pool, postFxJob, fx);
+    Canvas_MarkAllDirty(canvas);
+}
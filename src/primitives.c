@@ -0,0 +1,234 @@
+#include "../include/primitives.h"
+#include "../include/simd.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Spans follow a pixel-center rule: pixel x is covered by the interval
+// [left, right) when left <= x + 0.5 < right, i.e. x runs from
+// ceil(left - 0.5) to ceil(right - 0.5) - 1. Rows use the same rule in y.
+static inline int firstCovered(float edge) {
+    // Keep far off-canvas edges in int range
+    if (edge < -1e9f) edge = -1e9f;
+    if (edge > 1e9f) edge = 1e9f;
+    return (int)ceilf(edge - 0.5f);
+}
+
+void fillRow(uint32_t* dst, int count, uint32_t pixel) {
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i pixel_vec = _mm256_set1_epi32((int)pixel);
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(dst + i), pixel_vec);
+    }
+#elif defined(__SSE2__)
+    __m128i pixel_vec = _mm_set1_epi32((int)pixel);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(dst + i), pixel_vec);
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = pixel;
+    }
+}
+
+void fillSpan(Canvas* canvas, int y, int x0, int x1, uint32_t pixel) {
+    if (y < 0 || y >= canvas->bufferHeight) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 > canvas->bufferWidth - 1) x1 = canvas->bufferWidth - 1;
+    if (x0 > x1) return;
+    fillRow(canvas->backBuffer + (size_t)y * canvas->pitch + x0, x1 - x0 + 1, pixel);
+    Canvas_MarkDirty(canvas, x0, y, x1 + 1, y + 1);
+}
+
+// Paint the span [left, right) of screen row y (a row coveredRows returned),
+// given in float screen coordinates. Opaque shapes use BLEND_REPLACE, which
+// blendFillRow turns into a plain fillRow. Shapes mark their whole bounding
+// box dirty once instead of every span.
+static inline void paintSpan(Canvas* canvas, int y, float left, float right,
+                             uint32_t pixel, BlendMode mode) {
+    int x0 = firstCovered(left);
+    int x1 = firstCovered(right) - 1;
+    if (x0 < 0) x0 = 0;
+    if (x1 > canvas->bufferWidth - 1) x1 = canvas->bufferWidth - 1;
+    if (x0 > x1) return;
+    blendFillRow(canvas->backBuffer + (size_t)y * canvas->pitch + x0, x1 - x0 + 1, pixel, mode);
+}
+
+// Mark the columns covered by [left, right) on rows yStart..yEnd dirty
+static inline void markShapeDirty(Canvas* canvas, float left, float right, int yStart, int yEnd) {
+    if (yStart > yEnd) return;
+    Canvas_MarkDirty(canvas, firstCovered(left), yStart, firstCovered(right), yEnd + 1);
+}
+
+// Rows whose centers lie in [top, bottom), clipped to the canvas
+static void coveredRows(const Canvas* canvas, float top, float bottom, int* yStart, int* yEnd) {
+    *yStart = firstCovered(top);
+    *yEnd = firstCovered(bottom) - 1;
+    if (*yStart < 0) *yStart = 0;
+    if (*yEnd > canvas->bufferHeight - 1) *yEnd = canvas->bufferHeight - 1;
+}
+
+void fillRectPacked(Canvas* canvas, float cx, float cy, float width, float height,
+                    PackedColor pixel, BlendMode mode) {
+    if (width <= 0.0f || height <= 0.0f) return;
+
+    // Screen space: x right, y down
+    width *= canvas->renderScale;
+    height *= canvas->renderScale;
+    float left = Canvas_ToBufferX(canvas, cx) - width * 0.5f;
+    float top  = Canvas_ToBufferY(canvas, cy) - height * 0.5f;
+
+    int yStart, yEnd;
+    coveredRows(canvas, top, top + height, &yStart, &yEnd);
+    markShapeDirty(canvas, left, left + width, yStart, yEnd);
+    for (int y = yStart; y <= yEnd; y++) {
+        paintSpan(canvas, y, left, left + width, pixel, mode);
+    }
+}
+
+void fillRect(Canvas* canvas, float cx, float cy, float width, float height, Color color) {
+    fillRectPacked(canvas, cx, cy, width, height, Canvas_PackColor(color), BLEND_REPLACE);
+}
+
+void fillRectBlend(Canvas* canvas, float cx, float cy, float width, float height,
+                   ColorRGBA color, BlendMode mode) {
+    fillRectPacked(canvas, cx, cy, width, height, Canvas_PackColorRGBA(color), mode);
+}
+
+void fillCirclePacked(Canvas* canvas, float cx, float cy, float radius,
+                      PackedColor pixel, BlendMode mode) {
+    if (radius <= 0.0f) return;
+
+    float sx = Canvas_ToBufferX(canvas, cx);
+    float sy = Canvas_ToBufferY(canvas, cy);
+    radius *= canvas->renderScale;
+    float r2 = radius * radius;
+
+    // One span per row: the chord of the circle through the row center
+    int yStart, yEnd;
+    coveredRows(canvas, sy - radius, sy + radius, &yStart, &yEnd);
+    markShapeDirty(canvas, sx - radius, sx + radius, yStart, yEnd);
+    for (int y = yStart; y <= yEnd; y++) {
+        float dy = (float)y + 0.5f - sy;
+        float d2 = r2 - dy * dy;
+        if (d2 <= 0.0f) continue;
+        float half = sqrtf(d2);
+        paintSpan(canvas, y, sx - half, sx + half, pixel, mode);
+    }
+}
+
+void fillCircle(Canvas* canvas, float cx, float cy, float radius, Color color) {
+    fillCirclePacked(canvas, cx, cy, radius, Canvas_PackColor(color), BLEND_REPLACE);
+}
+
+void fillCircleBlend(Canvas* canvas, float cx, float cy, float radius,
+                     ColorRGBA color, BlendMode mode) {
+    fillCirclePacked(canvas, cx, cy, radius, Canvas_PackColorRGBA(color), mode);
+}
+
+// x of the edge a->b at height y (a and b in screen space, ay != by)
+static inline float edgeX(const float* xs, const float* ys, int a, int b, float y) {
+    return xs[a] + (y - ys[a]) * (xs[b] - xs[a]) / (ys[b] - ys[a]);
+}
+
+// Scan-convert a convex polygon given in screen space. The boundary is split
+// at the top and bottom vertices into two chains that are walked down
+// together, one edge at a time, so every row costs O(1).
+static void fillConvexScreen(Canvas* canvas, const float* xs, const float* ys, int count,
+                             uint32_t pixel, BlendMode mode) {
+    if (count < 3) return;
+
+    int top = 0, bottom = 0, left = 0, right = 0;
+    for (int i = 1; i < count; i++) {
+        if (ys[i] < ys[top]) top = i;
+        if (ys[i] > ys[bottom]) bottom = i;
+        if (xs[i] < xs[left]) left = i;
+        if (xs[i] > xs[right]) right = i;
+    }
+
+    int yStart, yEnd;
+    coveredRows(canvas, ys[top], ys[bottom], &yStart, &yEnd);
+    if (yStart > yEnd) return;
+    markShapeDirty(canvas, xs[left], xs[right], yStart, yEnd);
+
+    // Chain a walks forward through the vertices, chain b backward
+    int a = top, aNext = (top + 1) % count;
+    int b = top, bNext = (top + count - 1) % count;
+    for (int y = yStart; y <= yEnd; y++) {
+        float yc = (float)y + 0.5f;
+        while (aNext != bottom && ys[aNext] <= yc) {
+            a = aNext;
+            aNext = (a + 1) % count;
+        }
+        while (bNext != bottom && ys[bNext] <= yc) {
+            b = bNext;
+            bNext = (b + count - 1) % count;
+        }
+
+        float xa = edgeX(xs, ys, a, aNext, yc);
+        float xb = edgeX(xs, ys, b, bNext, yc);
+        if (xa < xb) {
+            paintSpan(canvas, y, xa, xb, pixel, mode);
+        } else {
+            paintSpan(canvas, y, xb, xa, pixel, mode);
+        }
+    }
+}
+
+// Vertices fillConvexPolygon converts on the stack; larger polygons get
+// heap scratch
+#define MAX_POLYGON_VERTICES 64
+
+void fillConvexPolygonPacked(Canvas* canvas, const float* xs, const float* ys, int count,
+                             PackedColor pixel, BlendMode mode) {
+    float stackX[MAX_POLYGON_VERTICES], stackY[MAX_POLYGON_VERTICES];
+    float* sx = stackX;
+    float* sy = stackY;
+    if (count > MAX_POLYGON_VERTICES) {
+        sx = malloc(sizeof(float) * 2 * (size_t)count);
+        if (!sx) return;
+        sy = sx + count;
+    }
+
+    for (int i = 0; i < count; i++) {
+        sx[i] = Canvas_ToBufferX(canvas, xs[i]);
+        sy[i] = Canvas_ToBufferY(canvas, ys[i]);
+    }
+    fillConvexScreen(canvas, sx, sy, count, pixel, mode);
+    if (sx != stackX) free(sx);
+}
+
+void fillConvexPolygon(Canvas* canvas, const float* xs, const float* ys, int count, Color color) {
+    fillConvexPolygonPacked(canvas, xs, ys, count, Canvas_PackColor(color), BLEND_REPLACE);
+}
+
+void fillConvexPolygonBlend(Canvas* canvas, const float* xs, const float* ys, int count,
+                            ColorRGBA color, BlendMode mode) {
+    fillConvexPolygonPacked(canvas, xs, ys, count, Canvas_PackColorRGBA(color), mode);
+}
+
+void fillRotatedRectPacked(Canvas* canvas, float cx, float cy, float width, float height,
+                           float angle, PackedColor pixel, BlendMode mode) {
+    float hw = width * 0.5f, hh = height * 0.5f;
+    float c = cosf(angle), s = sinf(angle);
+
+    // Corners rotated around the center, in order around the rectangle
+    float lx[4] = { -hw,  hw, hw, -hw };
+    float ly[4] = { -hh, -hh, hh,  hh };
+    float xs[4], ys[4];
+    for (int i = 0; i < 4; i++) {
+        xs[i] = cx + lx[i] * c - ly[i] * s;
+        ys[i] = cy + lx[i] * s + ly[i] * c;
+    }
+    fillConvexPolygonPacked(canvas, xs, ys, 4, pixel, mode);
+}
+
+void fillRotatedRect(Canvas* canvas, float cx, float cy, float width, float height,
+                     float angle, Color color) {
+    fillRotatedRectPacked(canvas, cx, cy, width, height, angle, Canvas_PackColor(color), BLEND_REPLACE);
+}
+
+void fillRotatedRectBlend(Canvas* canvas, float cx, float cy, float width, float height,
+                          float angle, ColorRGBA color, BlendMode mode) {
+    fillRotatedRectPacked(canvas, cx, cy, width, height, angle, Canvas_PackColorRGBA(color), mode);
+}
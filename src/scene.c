@@ -0,0 +1,361 @@
+#include "../include/scene.h"
+#include "../include/triangle.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SCENE_ALIVE   1
+#define SCENE_CHANGED 2
+
+void scene_init(Scene* scene) {
+    memset(scene, 0, sizeof(*scene));
+}
+
+static void freeBins(Scene* scene) {
+    for (int t = 0; t < scene->tilesX * scene->tilesY; t++) {
+        free(scene->bins[t].items);
+    }
+    free(scene->bins);
+    free(scene->tileDirty);
+    scene->bins = NULL;
+    scene->tileDirty = NULL;
+    scene->tilesX = scene->tilesY = 0;
+}
+
+void scene_free(Scene* scene) {
+    free(scene->cx);
+    free(scene->cy);
+    free(scene->size);
+    free(scene->angle);
+    free(scene->color);
+    free(scene->verts);
+    free(scene->bounds);
+    free(scene->flags);
+    free(scene->changed);
+    free(scene->freeHandles);
+    freeBins(scene);
+    free(scene->pixels);
+    memset(scene, 0, sizeof(*scene));
+}
+
+// Grow the per-primitive arrays to hold at least count primitives
+static bool ensureCapacity(Scene* s, int count) {
+    if (count <= s->capacity) return true;
+    int capacity = s->capacity ? s->capacity * 2 : 256;
+    while (capacity < count) capacity *= 2;
+
+#define GROW(field) do { \
+        void* p = realloc(s->field, sizeof(*s->field) * (size_t)capacity); \
+        if (!p) return false; \
+        s->field = p; \
+    } while (0)
+    GROW(cx);
+    GROW(cy);
+    GROW(size);
+    GROW(angle);
+    GROW(color);
+    GROW(bounds);
+    GROW(flags);
+    GROW(changed);
+    GROW(freeHandles);
+    void* verts = realloc(s->verts, sizeof(int) * 6 * (size_t)capacity);
+    if (!verts) return false;
+    s->verts = verts;
+#undef GROW
+
+    s->capacity = capacity;
+    return true;
+}
+
+static void markChanged(Scene* s, int handle) {
+    if (s->flags[handle] & SCENE_CHANGED) return;
+    s->flags[handle] |= SCENE_CHANGED;
+    s->changed[s->changedCount++] = handle;
+}
+
+static void markTileDirty(Scene* s, int tile) {
+    if (s->tileDirty[tile]) return;
+    s->tileDirty[tile] = 1;
+    s->dirtyCount++;
+}
+
+static void markAllTilesDirty(Scene* s) {
+    int tileCount = s->tilesX * s->tilesY;
+    memset(s->tileDirty, 1, (size_t)tileCount);
+    s->dirtyCount = tileCount;
+}
+
+// First position in bin whose handle is not below handle
+static int binSearch(const SceneBin* bin, int handle) {
+    int lo = 0, hi = bin->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (bin->items[mid] < handle) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static bool binInsert(SceneBin* bin, int handle) {
+    if (bin->count == bin->capacity) {
+        int capacity = bin->capacity ? bin->capacity * 2 : 16;
+        int* items = realloc(bin->items, sizeof(int) * (size_t)capacity);
+        if (!items) return false;
+        bin->items = items;
+        bin->capacity = capacity;
+    }
+    int at = binSearch(bin, handle);
+    memmove(bin->items + at + 1, bin->items + at, sizeof(int) * (size_t)(bin->count - at));
+    bin->items[at] = handle;
+    bin->count++;
+    return true;
+}
+
+static void binRemove(SceneBin* bin, int handle) {
+    int at = binSearch(bin, handle);
+    if (at == bin->count || bin->items[at] != handle) return;
+    bin->count--;
+    memmove(bin->items + at, bin->items + at + 1, sizeof(int) * (size_t)(bin->count - at));
+}
+
+// Take a primitive out of its tiles, which then need redrawing
+static void unbin(Scene* s, int handle) {
+    ClipRect* b = &s->bounds[handle];
+    for (int ty = b->minY; ty < b->maxY; ty++) {
+        for (int tx = b->minX; tx < b->maxX; tx++) {
+            int tile = ty * s->tilesX + tx;
+            binRemove(&s->bins[tile], handle);
+            markTileDirty(s, tile);
+        }
+    }
+    *b = (ClipRect){ 0, 0, 0, 0 };
+}
+
+// Transform a primitive and put it into the tiles its bounding box touches
+static void bin(Scene* s, const Canvas* canvas, int handle) {
+    int* v = &s->verts[6 * handle];
+    int vx[3], vy[3];
+    triangleOutlineVertices(canvas, s->cx[handle], s->cy[handle], s->size[handle],
+                            s->angle[handle], vx, vy);
+    int minX = vx[0], maxX = vx[0], minY = vy[0], maxY = vy[0];
+    for (int i = 0; i < 3; i++) {
+        v[2 * i] = vx[i];
+        v[2 * i + 1] = vy[i];
+        if (vx[i] < minX) minX = vx[i];
+        if (vx[i] > maxX) maxX = vx[i];
+        if (vy[i] < minY) minY = vy[i];
+        if (vy[i] > maxY) maxY = vy[i];
+    }
+    if (minX < 0) minX = 0;
+    if (minY < 0) minY = 0;
+    if (maxX > s->width - 1) maxX = s->width - 1;
+    if (maxY > s->height - 1) maxY = s->height - 1;
+    if (minX > maxX || minY > maxY) return;
+
+    ClipRect tiles = { minX / SCENE_TILE_SIZE, minY / SCENE_TILE_SIZE,
+                       maxX / SCENE_TILE_SIZE + 1, maxY / SCENE_TILE_SIZE + 1 };
+    for (int ty = tiles.minY; ty < tiles.maxY; ty++) {
+        for (int tx = tiles.minX; tx < tiles.maxX; tx++) {
+            int tile = ty * s->tilesX + tx;
+            // Out of memory: the primitive is left out of this tile
+            binInsert(&s->bins[tile], handle);
+            markTileDirty(s, tile);
+        }
+    }
+    s->bounds[handle] = tiles;
+}
+
+// Size the image and tile grid for the canvas. A new size or render scale
+// moves every primitive, so all of them are binned again.
+static bool ensureImage(Scene* s, const Canvas* canvas) {
+    if (s->pixels && s->width == canvas->bufferWidth && s->height == canvas->bufferHeight &&
+        s->renderScale == canvas->renderScale) {
+        return true;
+    }
+
+    freeBins(s);
+    free(s->pixels);
+    s->width = canvas->bufferWidth;
+    s->height = canvas->bufferHeight;
+    s->renderScale = canvas->renderScale;
+    s->target = NULL;
+    s->tilesX = (s->width + SCENE_TILE_SIZE - 1) / SCENE_TILE_SIZE;
+    s->tilesY = (s->height + SCENE_TILE_SIZE - 1) / SCENE_TILE_SIZE;
+    int tileCount = s->tilesX * s->tilesY;
+    s->pixels = malloc(sizeof(uint32_t) * (size_t)s->width * s->height);
+    s->bins = calloc((size_t)tileCount, sizeof(SceneBin));
+    s->tileDirty = malloc((size_t)tileCount);
+    if (!s->pixels || !s->bins || !s->tileDirty) {
+        freeBins(s);
+        free(s->pixels);
+        s->pixels = NULL;
+        return false;
+    }
+    markAllTilesDirty(s);
+
+    for (int h = 0; h < s->count; h++) {
+        s->bounds[h] = (ClipRect){ 0, 0, 0, 0 };
+        if (s->flags[h] & SCENE_ALIVE) markChanged(s, h);
+    }
+    return true;
+}
+
+SceneHandle scene_addTriangle(Scene* scene, float cx, float cy, float size, float angle,
+                              PackedColor color) {
+    int handle;
+    if (scene->freeCount > 0) {
+        handle = scene->freeHandles[--scene->freeCount];
+    } else {
+        if (!ensureCapacity(scene, scene->count + 1)) return -1;
+        handle = scene->count++;
+        scene->flags[handle] = 0;
+        scene->bounds[handle] = (ClipRect){ 0, 0, 0, 0 };
+    }
+    scene->cx[handle] = cx;
+    scene->cy[handle] = cy;
+    scene->size[handle] = size;
+    scene->angle[handle] = angle;
+    scene->color[handle] = color;
+    scene->flags[handle] |= SCENE_ALIVE;
+    markChanged(scene, handle);
+    return handle;
+}
+
+static bool isAlive(const Scene* scene, SceneHandle handle) {
+    return handle >= 0 && handle < scene->count && (scene->flags[handle] & SCENE_ALIVE);
+}
+
+void scene_setTriangle(Scene* scene, SceneHandle handle, float cx, float cy, float size, float angle) {
+    if (!isAlive(scene, handle)) return;
+    if (scene->cx[handle] == cx && scene->cy[handle] == cy &&
+        scene->size[handle] == size && scene->angle[handle] == angle) {
+        return;
+    }
+    scene->cx[handle] = cx;
+    scene->cy[handle] = cy;
+    scene->size[handle] = size;
+    scene->angle[handle] = angle;
+    markChanged(scene, handle);
+}
+
+void scene_setColor(Scene* scene, SceneHandle handle, PackedColor color) {
+    if (!isAlive(scene, handle) || scene->color[handle] == color) return;
+    scene->color[handle] = color;
+    markChanged(scene, handle);
+}
+
+void scene_remove(Scene* scene, SceneHandle handle) {
+    if (!isAlive(scene, handle)) return;
+    // Unbinned by the next scene_draw, even if the handle is reused before
+    scene->flags[handle] &= ~SCENE_ALIVE;
+    markChanged(scene, handle);
+    scene->freeHandles[scene->freeCount++] = handle;
+}
+
+void scene_setBackground(Scene* scene, PackedColor background) {
+    if (scene->background == background) return;
+    scene->background = background;
+    if (scene->tileDirty) markAllTilesDirty(scene);
+}
+
+// Redraw one tile of the image: background, then its primitives in handle order
+static void redrawTile(Scene* s, Canvas* view, int tx, int ty) {
+    ClipRect clip = { tx * SCENE_TILE_SIZE, ty * SCENE_TILE_SIZE,
+                      (tx + 1) * SCENE_TILE_SIZE, (ty + 1) * SCENE_TILE_SIZE };
+    if (clip.maxX > s->width) clip.maxX = s->width;
+    if (clip.maxY > s->height) clip.maxY = s->height;
+    for (int y = clip.minY; y < clip.maxY; y++) {
+        uint32_t* row = s->pixels + (size_t)y * s->width;
+        for (int x = clip.minX; x < clip.maxX; x++) row[x] = s->background;
+    }
+
+    const SceneBin* bin = &s->bins[ty * s->tilesX + tx];
+    for (int i = 0; i < bin->count; i++) {
+        int h = bin->items[i];
+        const int* v = &s->verts[6 * h];
+        PackedColor pixel = s->color[h];
+        drawLineScreen(view, v[0], v[1], v[2], v[3], pixel, &clip);
+        drawLineScreen(view, v[2], v[3], v[4], v[5], pixel, &clip);
+        drawLineScreen(view, v[4], v[5], v[0], v[1], pixel, &clip);
+    }
+}
+
+static void copyRect(const Scene* s, Canvas* canvas, ClipRect r) {
+    size_t rowBytes = (size_t)(r.maxX - r.minX) * sizeof(uint32_t);
+    for (int y = r.minY; y < r.maxY; y++) {
+        memcpy(canvas->backBuffer + (size_t)y * canvas->pitch + r.minX,
+               s->pixels + (size_t)y * s->width + r.minX, rowBytes);
+    }
+}
+
+void scene_draw(Scene* scene, Canvas* canvas) {
+    if (!ensureImage(scene, canvas)) return;
+
+    // Changed primitives leave their old tiles and enter their new ones
+    for (int i = 0; i < scene->changedCount; i++) {
+        int h = scene->changed[i];
+        scene->flags[h] &= ~SCENE_CHANGED;
+        unbin(scene, h);
+        if (scene->flags[h] & SCENE_ALIVE) bin(scene, canvas, h);
+    }
+    scene->changedCount = 0;
+
+    // The drawing kernels write through a canvas: point one at the image
+    Canvas view = *canvas;
+    view.backBuffer = scene->pixels;
+    view.pitch = scene->width;
+    if (scene->dirtyCount > 0) {
+        for (int ty = 0; ty < scene->tilesY; ty++) {
+            for (int tx = 0; tx < scene->tilesX; tx++) {
+                if (scene->tileDirty[ty * scene->tilesX + tx]) redrawTile(scene, &view, tx, ty);
+            }
+        }
+    }
+
+    // The canvas still holds our last copy, except where Canvas_BeginFrame
+    // cleared it and where this frame drew already
+    bool keep = scene->target == canvas->backBuffer && scene->targetPitch == canvas->pitch &&
+                canvas->frameCount - scene->targetFrame <= 1 && !canvas->uploadAll;
+    scene->target = canvas->backBuffer;
+    scene->targetPitch = canvas->pitch;
+    scene->targetFrame = canvas->frameCount;
+    if (!keep) {
+        copyRect(scene, canvas, (ClipRect){ 0, 0, scene->width, scene->height });
+        Canvas_MarkAllDirty(canvas);
+        memset(scene->tileDirty, 0, (size_t)(scene->tilesX * scene->tilesY));
+        scene->dirtyCount = 0;
+        return;
+    }
+    // Restored regions are drawn this frame like any other (the lists are
+    // copied first: marking merges into canvas->dirty)
+    DirtyRects restore = canvas->dirty;
+    DirtyRects cleared = canvas->prevDirty;
+    for (int i = 0; i < cleared.count; i++) {
+        const ClipRect r = cleared.rects[i];
+        copyRect(scene, canvas, r);
+        Canvas_MarkDirty(canvas, r.minX, r.minY, r.maxX, r.maxY);
+    }
+    for (int i = 0; i < restore.count; i++) {
+        const ClipRect r = restore.rects[i];
+        copyRect(scene, canvas, r);
+        Canvas_MarkDirty(canvas, r.minX, r.minY, r.maxX, r.maxY);
+    }
+    if (scene->dirtyCount == 0) return;
+
+    // Changed tiles, a run of neighbours at a time
+    for (int ty = 0; ty < scene->tilesY; ty++) {
+        uint8_t* dirty = scene->tileDirty + (size_t)ty * scene->tilesX;
+        for (int tx = 0; tx < scene->tilesX; tx++) {
+            if (!dirty[tx]) continue;
+            int end = tx;
+            while (end < scene->tilesX && dirty[end]) dirty[end++] = 0;
+            ClipRect r = { tx * SCENE_TILE_SIZE, ty * SCENE_TILE_SIZE,
+                           end * SCENE_TILE_SIZE, (ty + 1) * SCENE_TILE_SIZE };
+            if (r.maxX > scene->width) r.maxX = scene->width;
+            if (r.maxY > scene->height) r.maxY = scene->height;
+            copyRect(scene, canvas, r);
+            Canvas_MarkDirty(canvas, r.minX, r.minY, r.maxX, r.maxY);
+            tx = end;
+        }
+    }
+    scene->dirtyCount = 0;
+}
@@ -0,0 +1,207 @@
+#include "../include/stamp_cache.h"
+#include "../include/triangle.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Scratch raster the stamps are drawn in, anchor pixel in the middle
+#define STAMP_RASTER 64
+
+void stampCache_free(StampCache* cache) {
+    free(cache->stamps);
+    free(cache->rows);
+    free(cache->exact);
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Draw the outline of one size and angle into raster and pack it as a stamp.
+// The vertices are those calcTriangleVertices gives around a center at the
+// origin, rounded; canvas y points up, so the screen offsets flip it.
+static void rasterizeStamp(Canvas* view, float size, float angle, Stamp* stamp,
+                           uint64_t* rows, int* rowCount) {
+    float bx[3] = { 0, size, -size };
+    float by[3] = { -size, size, size };
+    float c = cosf(angle);
+    float s = sinf(angle);
+    int px[3], py[3];
+    for (int i = 0; i < 3; i++) {
+        px[i] = STAMP_RASTER / 2 + (int)lrintf(bx[i] * c - by[i] * s);
+        py[i] = STAMP_RASTER / 2 - (int)lrintf(bx[i] * s + by[i] * c);
+    }
+
+    memset(view->backBuffer, 0, sizeof(uint32_t) * STAMP_RASTER * STAMP_RASTER);
+    ClipRect clip = { 0, 0, STAMP_RASTER, STAMP_RASTER };
+    drawLineScreen(view, px[0], py[0], px[1], py[1], 1, &clip);
+    drawLineScreen(view, px[1], py[1], px[2], py[2], 1, &clip);
+    drawLineScreen(view, px[2], py[2], px[0], py[0], 1, &clip);
+
+    int minX = px[0], maxX = px[0], minY = py[0], maxY = py[0];
+    for (int i = 1; i < 3; i++) {
+        if (px[i] < minX) minX = px[i];
+        if (px[i] > maxX) maxX = px[i];
+        if (py[i] < minY) minY = py[i];
+        if (py[i] > maxY) maxY = py[i];
+    }
+    stamp->x = (int8_t)(minX - STAMP_RASTER / 2);
+    stamp->y = (int8_t)(minY - STAMP_RASTER / 2);
+    stamp->width = (uint8_t)(maxX - minX + 1);
+    stamp->height = (uint8_t)(maxY - minY + 1);
+    stamp->firstRow = *rowCount;
+    for (int y = minY; y <= maxY; y++) {
+        const uint32_t* src = view->backBuffer + y * STAMP_RASTER;
+        uint64_t bits = 0;
+        for (int x = minX; x <= maxX; x++) {
+            if (src[x]) bits |= 1ull << (x - minX);
+        }
+        rows[(*rowCount)++] = bits;
+    }
+}
+
+bool stampCache_init(StampCache* cache, int maxSize, int angleSteps) {
+    memset(cache, 0, sizeof(*cache));
+    if (maxSize < 1 || maxSize > STAMP_CACHE_MAX_SIZE || angleSteps < 1) return false;
+
+    cache->maxSize = maxSize;
+    cache->angleSteps = angleSteps;
+    cache->sizeClasses = maxSize * STAMP_SIZE_STEPS + 1;
+    int stampCount = cache->sizeClasses * angleSteps;
+
+    // A stamp of half-height s spans at most 2*s*sqrt(2) + 2 rows
+    int rowsPerStamp = (int)(2.0f * maxSize * 1.4143f) + 2;
+    cache->stamps = malloc(sizeof(Stamp) * (size_t)stampCount);
+    cache->rows = malloc(sizeof(uint64_t) * (size_t)stampCount * rowsPerStamp);
+    uint32_t* raster = malloc(sizeof(uint32_t) * STAMP_RASTER * STAMP_RASTER);
+    if (!cache->stamps || !cache->rows || !raster) {
+        free(raster);
+        stampCache_free(cache);
+        return false;
+    }
+
+    // drawLineScreen only needs the buffer and its pitch
+    Canvas view;
+    memset(&view, 0, sizeof(view));
+    view.backBuffer = raster;
+    view.bufferWidth = view.bufferHeight = view.pitch = STAMP_RASTER;
+
+    int rowCount = 0;
+    for (int sc = 0; sc < cache->sizeClasses; sc++) {
+        for (int a = 0; a < angleSteps; a++) {
+            rasterizeStamp(&view, (float)sc / STAMP_SIZE_STEPS, a * (2.0f * (float)M_PI / angleSteps),
+                           &cache->stamps[sc * angleSteps + a], cache->rows, &rowCount);
+        }
+    }
+    free(raster);
+
+    // Give back the rows the estimate left over
+    uint64_t* rows = realloc(cache->rows, sizeof(uint64_t) * (size_t)rowCount);
+    if (rows) cache->rows = rows;
+    return true;
+}
+
+// Write pixel to the set bits of a stamp's rows, the first row at dst.
+// Outline rows are mostly empty, so the loops jump from one set chunk to
+// the next.
+static void stampPattern(uint32_t* dst, int pitch, const uint64_t* rows, int height, uint32_t pixel) {
+#if defined(__AVX2__)
+    const __m256i laneBit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i pixel_vec = _mm256_set1_epi32((int)pixel);
+#elif defined(__SSE2__)
+    const __m128i pixel_vec = _mm_set1_epi32((int)pixel);
+#endif
+    for (int r = 0; r < height; r++, dst += pitch) {
+        uint64_t bits = rows[r];
+#if defined(__AVX2__)
+        while (bits) {
+            int x = __builtin_ctzll(bits) & ~7;
+            int chunk = (int)(bits >> x) & 0xFF;
+            bits &= ~(0xFFull << x);
+            // Lanes without a bit are not written, even past the stamp's width
+            __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(chunk), laneBit), laneBit);
+            _mm256_maskstore_epi32((int*)(dst + x), mask, pixel_vec);
+        }
+#elif defined(__SSE2__)
+        while (bits) {
+            int x = __builtin_ctzll(bits) & ~3;
+            unsigned chunk = (unsigned)(bits >> x) & 0xF;
+            bits &= ~(0xFull << x);
+            if (chunk == 0xF) {
+                _mm_storeu_si128((__m128i*)(dst + x), pixel_vec);
+            } else {
+                for (; chunk; chunk &= chunk - 1) dst[x + __builtin_ctz(chunk)] = pixel;
+            }
+        }
+#else
+        for (; bits; bits &= bits - 1) dst[__builtin_ctzll(bits)] = pixel;
+#endif
+    }
+}
+
+void renderTrianglesStamped(Canvas* canvas, TriangleDataSIMD* data, StampCache* cache) {
+    if (data->count > cache->exactCapacity) {
+        bool* exact = realloc(cache->exact, sizeof(bool) * (size_t)data->count);
+        if (!exact) {
+            renderTrianglesSIMD(canvas, data);
+            return;
+        }
+        cache->exact = exact;
+        cache->exactCapacity = data->count;
+    }
+
+    const float scale = canvas->renderScale;
+    const float angleScale = cache->angleSteps / (2.0f * (float)M_PI);
+    const float sizeLimit = (float)cache->maxSize;
+    const float placeLimit = 16384.0f;
+    const int halfW = canvas->bufferWidth / 2;
+    const int halfH = canvas->bufferHeight / 2;
+    int minX = canvas->bufferWidth, minY = canvas->bufferHeight, maxX = -1, maxY = -1;
+    int stamped = 0, exactCount = 0;
+
+    for (int i = 0; i < data->count; i++) {
+        cache->exact[i] = false;
+        if (!data->visible[i]) continue;
+
+        // Small and fully on the canvas, or left to the exact path (negative
+        // sizes draw mirrored outlines, which have no stamps)
+        float size = data->size[i] * scale;
+        float cx = data->cx[i] * scale;
+        float cy = data->cy[i] * scale;
+        if (!(size >= 0.0f && size <= sizeLimit && fabsf(cx) < placeLimit && fabsf(cy) < placeLimit)) {
+            cache->exact[i] = true;
+            exactCount++;
+            continue;
+        }
+        int sizeClass = (int)(size * STAMP_SIZE_STEPS + 0.5f);
+        if (sizeClass > cache->sizeClasses - 1) sizeClass = cache->sizeClasses - 1;
+        int step = (int)floorf(data->angle[i] * angleScale + 0.5f) % cache->angleSteps;
+        if (step < 0) step += cache->angleSteps;
+        const Stamp* stamp = &cache->stamps[sizeClass * cache->angleSteps + step];
+
+        int x0 = halfW + (int)cx + stamp->x;
+        int y0 = halfH - (int)cy + stamp->y;
+        if (x0 < 0 || y0 < 0 || x0 + stamp->width > canvas->bufferWidth ||
+            y0 + stamp->height > canvas->bufferHeight) {
+            cache->exact[i] = true;
+            exactCount++;
+            continue;
+        }
+
+        stampPattern(canvas->backBuffer + (size_t)y0 * canvas->pitch + x0, canvas->pitch,
+                     cache->rows + stamp->firstRow, stamp->height, data->color[i]);
+
+        if (x0 < minX) minX = x0;
+        if (y0 < minY) minY = y0;
+        if (x0 + stamp->width > maxX) maxX = x0 + stamp->width;
+        if (y0 + stamp->height > maxY) maxY = y0 + stamp->height;
+        stamped++;
+    }
+    cache->stamped = stamped;
+
+    // One dirty rectangle for all stamps keeps the bookkeeping out of the loop
+    if (stamped) Canvas_MarkDirty(canvas, minX, minY, maxX, maxY);
+
+    if (exactCount) {
+        TriangleDataSIMD rest = *data;
+        rest.visible = cache->exact;
+        renderTrianglesSIMD(canvas, &rest);
+    }
+}
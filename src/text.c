@@ -1,13 +1,57 @@
 #include "../include/text.h"
+#include "../include/blend.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>  // For getcwd
 
 // Font handle
 static TTF_Font* font = NULL;
 
+// Glyph image shrunk to the render scale, grown as needed
+static uint32_t* scaledGlyphs = NULL;
+static size_t scaledCapacity = 0;
+
+// Box-filter a width x height ARGB image down to dstWidth x dstHeight
+// (each at most the source size) into scaledGlyphs
+static bool shrinkGlyphs(const uint32_t* src, int width, int height, int srcPitch,
+                         int dstWidth, int dstHeight) {
+    size_t size = (size_t)dstWidth * dstHeight;
+    if (size > scaledCapacity) {
+        uint32_t* pixels = realloc(scaledGlyphs, size * sizeof(uint32_t));
+        if (!pixels) return false;
+        scaledGlyphs = pixels;
+        scaledCapacity = size;
+    }
+    for (int dy = 0; dy < dstHeight; dy++) {
+        int sy0 = (int)((long long)dy * height / dstHeight);
+        int sy1 = (int)((long long)(dy + 1) * height / dstHeight);
+        if (sy1 <= sy0) sy1 = sy0 + 1;
+        for (int dx = 0; dx < dstWidth; dx++) {
+            int sx0 = (int)((long long)dx * width / dstWidth);
+            int sx1 = (int)((long long)(dx + 1) * width / dstWidth);
+            if (sx1 <= sx0) sx1 = sx0 + 1;
+            uint32_t a = 0, r = 0, g = 0, b = 0;
+            for (int sy = sy0; sy < sy1; sy++) {
+                const uint32_t* row = src + (size_t)sy * srcPitch;
+                for (int sx = sx0; sx < sx1; sx++) {
+                    uint32_t p = row[sx];
+                    a += p >> 24;
+                    r += (p >> 16) & 0xFF;
+                    g += (p >> 8) & 0xFF;
+                    b += p & 0xFF;
+                }
+            }
+            uint32_t n = (uint32_t)((sy1 - sy0) * (sx1 - sx0));
+            scaledGlyphs[(size_t)dy * dstWidth + dx] =
+                ((a + n / 2) / n) << 24 | ((r + n / 2) / n) << 16 | ((g + n / 2) / n) << 8 | ((b + n / 2) / n);
+        }
+    }
+    return true;
+}
+
 bool textInit(const char* fontFilename, int fontSize) {
     // Check if TTF was initialized
     if (!TTF_WasInit()) {
@@ -70,71 +114,53 @@ void textDraw(Canvas* canvas, int cx, int cy, const char* text, Color color) {
     }
     
     // Calculate text dimensions and position
+    // Glyphs are rendered at the font's size in window pixels, so below
+    // render scale 1 they are shrunk to keep their size on screen
     int textWidth = surface->w;
     int textHeight = surface->h;
+    if (canvas->renderScale != 1.0f) {
+        textWidth = (int)lroundf(surface->w * canvas->renderScale);
+        textHeight = (int)lroundf(surface->h * canvas->renderScale);
+        if (textWidth < 1) textWidth = 1;
+        if (textHeight < 1) textHeight = 1;
+    }
     
     // Convert from centered coordinates to top-left origin
     // Our canvas origin is in the center, SDL's surface origin is top-left
-    int x = canvas->width / 2 + cx - textWidth / 2;   // Center text horizontally around cx
-    int y = canvas->height / 2 - cy - textHeight / 2; // And vertically around cy
+    int x = canvas->bufferWidth / 2 + Canvas_ScaleInt(canvas, cx) - textWidth / 2;   // Center text horizontally around cx
+    int y = canvas->bufferHeight / 2 - Canvas_ScaleInt(canvas, cy) - textHeight / 2; // And vertically around cy
     
     // Check if completely off-screen
     if (x + textWidth < 0 || y + textHeight < 0 || 
-        x >= canvas->width || y >= canvas->height) {
+        x >= canvas->bufferWidth || y >= canvas->bufferHeight) {
         SDL_FreeSurface(surface);
         return;
     }
     
-    // Get format information
-    SDL_PixelFormat* format = surface->format;
-    
-    // Only proceed if surface is in a recognized format
-    if (format->BytesPerPixel != 4) {
-        fprintf(stderr, "Unsupported surface format: %d bytes per pixel\n", format->BytesPerPixel);
+    // The blit below expects ARGB8888, which is what the blended renderer returns
+    if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
         SDL_FreeSurface(surface);
-        return;
+        if (!converted) {
+            fprintf(stderr, "Failed to convert text surface: '%s'\n", SDL_GetError());
+            return;
+        }
+        surface = converted;
     }
     
-    // Access pixel data
-    Uint32* src = (Uint32*)surface->pixels;
-    
-    // Copy pixels to canvas, converting from SDL format to our format
-    for (int sy = 0; sy < textHeight; sy++) {
-        for (int sx = 0; sx < textWidth; sx++) {
-            // Get source pixel in SDL format
-            int srcIndex = sy * (surface->pitch / 4) + sx;
-            Uint32 pixel = src[srcIndex];
-            
-            // Extract RGBA components
-            Uint8 r, g, b, a;
-            SDL_GetRGBA(pixel, format, &r, &g, &b, &a);
-            
-            // Skip fully transparent pixels
-            if (a < 10) continue;
-            
-            // Create a blended color based on alpha
-            // Adjust the alpha scaling to taste
-            Color pixelColor;
-            if (a >= 250) {
-                // Fully opaque - use the original color
-                pixelColor = color;
-            } else {
-                // Alpha-scale the original color
-                float alphaFactor = a / 255.0f;
-                pixelColor.r = (uint8_t)(color.r * alphaFactor);
-                pixelColor.g = (uint8_t)(color.g * alphaFactor);
-                pixelColor.b = (uint8_t)(color.b * alphaFactor);
-            }
-            
-            // Calculate position in canvas coordinates
-            // Convert from top-left origin to centered origin
-            int canvasX = x + sx - canvas->width / 2;
-            int canvasY = canvas->height / 2 - (y + sy);
-            
-            // Put the pixel on the canvas
-            Canvas_PutPixel(canvas, canvasX, canvasY, pixelColor);
+    // Source-over blend the anti-aliased glyphs onto whatever is already drawn
+    const uint32_t* glyphs = (const uint32_t*)surface->pixels;
+    int glyphPitch = surface->pitch / 4;
+    if (textWidth != surface->w || textHeight != surface->h) {
+        if (!shrinkGlyphs(glyphs, surface->w, surface->h, glyphPitch, textWidth, textHeight)) {
+            fprintf(stderr, "Error: Out of memory scaling text\n");
+            SDL_FreeSurface(surface);
+            return;
         }
+        glyphs = scaledGlyphs;
+        glyphPitch = textWidth;
     }
+    blendBlit(canvas, x, y, glyphs, textWidth, textHeight, glyphPitch, BLEND_ALPHA);
     
     // Clean up
     SDL_FreeSurface(surface);
@@ -145,4 +171,7 @@ void textShutdown(void) {
         TTF_CloseFont(font);
         font = NULL;
     }
+    free(scaledGlyphs);
+    scaledGlyphs = NULL;
+    scaledCapacity = 0;
 }
@@ -0,0 +1,234 @@
+#include "../include/tile_renderer.h"
+#include "../include/triangle.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+// Grow the per-triangle arrays to hold at least count triangles
+static bool ensureTriangleCapacity(TileRenderer* r, int count) {
+    if (count <= r->triangleCapacity) return true;
+
+    int* verts = realloc(r->verts, sizeof(int) * 6 * (size_t)count);
+    if (verts) r->verts = verts;
+    int* tileRect = realloc(r->tileRect, sizeof(int) * 4 * (size_t)count);
+    if (tileRect) r->tileRect = tileRect;
+
+    if (!verts || !tileRect) return false;
+    r->triangleCapacity = count;
+    return true;
+}
+
+// Rebuild the tile grid when the canvas size changes
+static bool ensureTileGrid(TileRenderer* r, int width, int height) {
+    if (r->binStart && r->width == width && r->height == height) return true;
+
+    r->width = width;
+    r->height = height;
+    r->tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    r->tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    r->tileCount = r->tilesX * r->tilesY;
+
+    free(r->binCounts);
+    free(r->binStart);
+    r->binCounts = malloc(sizeof(int) * (size_t)r->tileCount * (size_t)r->pool.workerCount);
+    r->binStart = malloc(sizeof(int) * (size_t)(r->tileCount + 1));
+    return r->binCounts && r->binStart;
+}
+
+bool tileRenderer_init(TileRenderer* renderer, int workerCount) {
+    memset(renderer, 0, sizeof(*renderer));
+    atomic_init(&renderer->nextTile, 0);
+    return workerPool_init(&renderer->pool, workerCount);
+}
+
+void tileRenderer_free(TileRenderer* renderer) {
+    workerPool_free(&renderer->pool);
+    free(renderer->verts);
+    free(renderer->tileRect);
+    free(renderer->binCounts);
+    free(renderer->binStart);
+    free(renderer->binItems);
+    memset(renderer, 0, sizeof(*renderer));
+}
+
+// Frame job, run by every worker:
+//   1. transform own chunk of triangles and count tile overlaps per tile
+//   2. (worker 0) prefix-sum the counts into per-worker bin offsets
+//   3. scatter own chunk into the bins, preserving submission order
+//   4. claim tiles from a shared counter and rasterize them
+static void tileJob(void* ctx, int workerIndex, int workerCount) {
+    TileRenderer* r = (TileRenderer*)ctx;
+    const TriangleDataSIMD* data = r->data;
+    const int tileCount = r->tileCount;
+    const int halfW = r->width / 2;
+    const int halfH = r->height / 2;
+    const float scale = r->canvas->renderScale;
+
+    int begin = (int)((long long)data->count * workerIndex / workerCount);
+    int end   = (int)((long long)data->count * (workerIndex + 1) / workerCount);
+    int* counts = r->binCounts + (size_t)workerIndex * tileCount;
+
+    // A single worker gains nothing from binning: draw in order, clipped to the canvas
+    if (workerCount == 1) {
+        ClipRect full = { 0, 0, r->width, r->height };
+        int minX = r->width, minY = r->height, maxX = -1, maxY = -1;
+        for (int i = 0; i < data->count; i++) {
+            if (!data->visible[i]) continue;
+            int vx[3], vy[3];
+            calcTriangleVertices(data->cx[i] * scale, data->cy[i] * scale, data->size[i] * scale,
+                                 data->angle[i], vx, vy);
+            for (int k = 0; k < 3; k++) {
+                int n = (k + 1) % 3;
+                int sx = halfW + vx[k], sy = halfH - vy[k];
+                if (sx < minX) minX = sx;
+                if (sx > maxX) maxX = sx;
+                if (sy < minY) minY = sy;
+                if (sy > maxY) maxY = sy;
+                drawLineScreen(r->canvas, sx, sy, halfW + vx[n], halfH - vy[n], data->color[i], &full);
+            }
+        }
+        Canvas_MarkDirty(r->canvas, minX, minY, maxX + 1, maxY + 1);
+        return;
+    }
+
+    // Phase 1: vertex setup and counting
+    memset(counts, 0, sizeof(int) * (size_t)tileCount);
+    for (int i = begin; i < end; i++) {
+        int* rect = &r->tileRect[i * 4];
+        rect[0] = 1; rect[2] = 0; // empty until proven visible
+
+        if (!data->visible[i]) continue;
+
+        int vx[3], vy[3];
+        calcTriangleVertices(data->cx[i] * scale, data->cy[i] * scale, data->size[i] * scale,
+                             data->angle[i], vx, vy);
+
+        // Convert to top-left origin screen space
+        int* v = &r->verts[i * 6];
+        int minX = r->width, minY = r->height, maxX = -1, maxY = -1;
+        for (int k = 0; k < 3; k++) {
+            int sx = halfW + vx[k];
+            int sy = halfH - vy[k];
+            v[k * 2 + 0] = sx;
+            v[k * 2 + 1] = sy;
+            if (sx < minX) minX = sx;
+            if (sx > maxX) maxX = sx;
+            if (sy < minY) minY = sy;
+            if (sy > maxY) maxY = sy;
+        }
+
+        // Entirely off screen
+        if (maxX < 0 || maxY < 0 || minX >= r->width || minY >= r->height) continue;
+
+        if (minX < 0) minX = 0;
+        if (minY < 0) minY = 0;
+        if (maxX >= r->width) maxX = r->width - 1;
+        if (maxY >= r->height) maxY = r->height - 1;
+
+        rect[0] = minX / TILE_SIZE;
+        rect[1] = minY / TILE_SIZE;
+        rect[2] = maxX / TILE_SIZE;
+        rect[3] = maxY / TILE_SIZE;
+
+        for (int ty = rect[1]; ty <= rect[3]; ty++) {
+            for (int tx = rect[0]; tx <= rect[2]; tx++) {
+                counts[ty * r->tilesX + tx]++;
+            }
+        }
+    }
+
+    workerPool_barrier(&r->pool);
+
+    // Phase 2: turn counts into write offsets (worker w of tile t writes after workers < w)
+    if (workerIndex == 0) {
+        int total = 0;
+        for (int t = 0; t < tileCount; t++) {
+            r->binStart[t] = total;
+            for (int w = 0; w < workerCount; w++) {
+                int* c = &r->binCounts[(size_t)w * tileCount + t];
+                int n = *c;
+                *c = total;
+                total += n;
+            }
+        }
+        r->binStart[tileCount] = total;
+
+        // Everything drawn this frame lies in the tiles that received triangles
+        int minTX = r->tilesX, minTY = r->tilesY, maxTX = -1, maxTY = -1;
+        for (int t = 0; t < tileCount; t++) {
+            if (r->binStart[t + 1] == r->binStart[t]) continue;
+            int tx = t % r->tilesX, ty = t / r->tilesX;
+            if (tx < minTX) minTX = tx;
+            if (tx > maxTX) maxTX = tx;
+            if (ty < minTY) minTY = ty;
+            if (ty > maxTY) maxTY = ty;
+        }
+        Canvas_MarkDirty(r->canvas, minTX * TILE_SIZE, minTY * TILE_SIZE,
+                         (maxTX + 1) * TILE_SIZE, (maxTY + 1) * TILE_SIZE);
+
+        if (total > r->binCapacity) {
+            int* items = realloc(r->binItems, sizeof(int) * (size_t)total);
+            if (items) {
+                r->binItems = items;
+                r->binCapacity = total;
+            } else {
+                // Out of memory: draw nothing this frame rather than overflow
+                fprintf(stderr, "Error: Failed to grow tile bins to %d entries\n", total);
+                memset(r->binStart, 0, sizeof(int) * (size_t)(tileCount + 1));
+                memset(r->tileRect, 0, sizeof(int) * 4 * (size_t)data->count);
+                for (int i = 0; i < data->count; i++) r->tileRect[i * 4] = 1;
+            }
+        }
+        atomic_store(&r->nextTile, 0);
+    }
+
+    workerPool_barrier(&r->pool);
+
+    // Phase 3: scatter triangle indices into their bins
+    for (int i = begin; i < end; i++) {
+        const int* rect = &r->tileRect[i * 4];
+        for (int ty = rect[1]; ty <= rect[3] && rect[0] <= rect[2]; ty++) {
+            for (int tx = rect[0]; tx <= rect[2]; tx++) {
+                r->binItems[counts[ty * r->tilesX + tx]++] = i;
+            }
+        }
+    }
+
+    workerPool_barrier(&r->pool);
+
+    // Phase 4: rasterize whole tiles, no two workers ever touch the same pixel
+    // Clipped lines jump straight to their first pixel inside the tile, so a
+    // long edge crossing many tiles is only walked where it is visible
+    Canvas* canvas = r->canvas;
+    int t;
+    while ((t = atomic_fetch_add(&r->nextTile, 1)) < tileCount) {
+        ClipRect tile;
+        tile.minX = (t % r->tilesX) * TILE_SIZE;
+        tile.minY = (t / r->tilesX) * TILE_SIZE;
+        tile.maxX = tile.minX + TILE_SIZE < r->width ? tile.minX + TILE_SIZE : r->width;
+        tile.maxY = tile.minY + TILE_SIZE < r->height ? tile.minY + TILE_SIZE : r->height;
+
+        for (int k = r->binStart[t]; k < r->binStart[t + 1]; k++) {
+            int i = r->binItems[k];
+            const int* v = &r->verts[i * 6];
+            PackedColor pixel = data->color[i];
+            drawLineScreen(canvas, v[0], v[1], v[2], v[3], pixel, &tile);
+            drawLineScreen(canvas, v[2], v[3], v[4], v[5], pixel, &tile);
+            drawLineScreen(canvas, v[4], v[5], v[0], v[1], pixel, &tile);
+        }
+    }
+}
+
+void renderTrianglesTiled(TileRenderer* renderer, Canvas* canvas, const TriangleDataSIMD* data) {
+    if (data->count == 0) return;
+
+    if (!ensureTileGrid(renderer, canvas->bufferWidth, canvas->bufferHeight) ||
+        !ensureTriangleCapacity(renderer, data->count)) {
+        fprintf(stderr, "Error: Failed to allocate tile renderer buffers\n");
+        return;
+    }
+
+    renderer->canvas = canvas;
+    renderer->data = data;
+    workerPool_run(&renderer->pool, tileJob, renderer);
+}
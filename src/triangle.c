@@ -2,45 +2,307 @@
 #include <stdlib.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 
-// Function declaration for our wireframe line drawing helper
-void drawLine(Canvas* canvas,
-             int x0, int y0, int x1, int y1,
-             Color color);
+// Floor/ceil division for a positive divisor
+static long long floorDiv(long long a, long long b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static long long ceilDiv(long long a, long long b) {
+    return -floorDiv(-a, b);
+}
+
+// Lines are stepped along their major axis; after i major steps the minor
+// axis has advanced j(i) = floor((2*minor*i + major) / (2*major)) pixels.
+// This is exactly the pixel sequence of the classic all-octant Bresenham
+// loop, which lets us jump straight to the first visible pixel of a clipped
+// line and still produce the same pixels as the unclipped walk.
+typedef struct {
+    int px, py;                 // first visible pixel
+    int count;                  // visible pixels
+    int sx, sy;                 // step directions
+    bool xMajor;
+    bool straight;              // horizontal or vertical
+    long long err, errStep, errWrap;
+} LineWalk;
+
+// Clip a screen-space line and set up its Bresenham walk; false when nothing is visible
+static inline bool setupLineWalk(int x0, int y0, int x1, int y1, const ClipRect* clip, LineWalk* w)
+{
+    if (clip->minX >= clip->maxX || clip->minY >= clip->maxY) return false;
+
+    // Trivially reject lines whose bounding box misses the clip rect
+    if ((x0 < clip->minX && x1 < clip->minX) || (x0 >= clip->maxX && x1 >= clip->maxX) ||
+        (y0 < clip->minY && y1 < clip->minY) || (y0 >= clip->maxY && y1 >= clip->maxY)) {
+        return false;
+    }
+
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    long long adx = llabs((long long)x1 - x0);
+    long long ady = llabs((long long)y1 - y0);
+    bool xMajor = adx >= ady;
+    long long major = xMajor ? adx : ady;
+    long long minor = xMajor ? ady : adx;
+
+    long long first, last, j, err;
+    if (x0 >= clip->minX && x0 < clip->maxX && y0 >= clip->minY && y0 < clip->maxY &&
+        x1 >= clip->minX && x1 < clip->maxX && y1 >= clip->minY && y1 < clip->maxY) {
+        // Fully inside: the common case for small shapes, no clipping math needed
+        first = 0;
+        last = major;
+        j = 0;
+        err = major;
+    } else {
+        // Allowed step ranges along each axis: x = x0 + sx*k, y = y0 + sy*k
+        long long xLo = sx > 0 ? clip->minX - x0 : x0 - (clip->maxX - 1);
+        long long xHi = sx > 0 ? (clip->maxX - 1) - x0 : x0 - clip->minX;
+        long long yLo = sy > 0 ? clip->minY - y0 : y0 - (clip->maxY - 1);
+        long long yHi = sy > 0 ? (clip->maxY - 1) - y0 : y0 - clip->minY;
+        long long iLo = xMajor ? xLo : yLo, iHi = xMajor ? xHi : yHi;
+        long long jLo = xMajor ? yLo : xLo, jHi = xMajor ? yHi : xHi;
+
+        // First and last major step, clipped on the major axis
+        first = iLo > 0 ? iLo : 0;
+        last  = iHi < major ? iHi : major;
+
+        // ...and on the minor axis, by inverting j(i)
+        if (minor == 0) {
+            if (jLo > 0 || jHi < 0) return false;
+        } else {
+            long long iFromLo = ceilDiv(2 * major * jLo - major, 2 * minor);
+            long long iFromHi = ceilDiv(2 * major * (jHi + 1) - major, 2 * minor) - 1;
+            if (iFromLo > first) first = iFromLo;
+            if (iFromHi < last) last = iFromHi;
+        }
+        if (first > last) return false;
+
+        // Bresenham state at the first visible step (j stays 0 for axis-aligned lines)
+        j = minor ? floorDiv(2 * minor * first + major, 2 * major) : 0;
+        err = 2 * minor * first + major - 2 * major * j;
+    }
+
+    w->px = x0 + sx * (int)(xMajor ? first : j);
+    w->py = y0 + sy * (int)(xMajor ? j : first);
+    w->count = (int)(last - first + 1);
+    w->sx = sx;
+    w->sy = sy;
+    w->xMajor = xMajor;
+    w->straight = minor == 0;
+    w->err = err;
+    w->errStep = 2 * minor;
+    w->errWrap = 2 * major;
+    return true;
+}
+
+void drawLineScreen(Canvas* canvas, int x0, int y0, int x1, int y1,
+                    PackedColor pixel, const ClipRect* clip)
+{
+    LineWalk w;
+    if (!setupLineWalk(x0, y0, x1, y1, clip, &w)) return;
+
+    uint32_t* p = canvas->backBuffer + (ptrdiff_t)w.py * canvas->pitch + w.px;
+    ptrdiff_t rowStep = (ptrdiff_t)w.sy * canvas->pitch;
+    int count = w.count;
+    long long err = w.err;
+
+    if (w.straight) {
+        // Horizontal and vertical lines: a plain strided run
+        ptrdiff_t step = w.xMajor ? w.sx : rowStep;
+        while (count--) { *p = pixel; p += step; }
+    } else if (w.xMajor) {
+        // Shallow octants: one column per step, occasionally one row
+        while (count--) {
+            *p = pixel;
+            p += w.sx;
+            err += w.errStep;
+            if (err >= w.errWrap) { err -= w.errWrap; p += rowStep; }
+        }
+    } else {
+        // Steep octants: one row per step, occasionally one column
+        while (count--) {
+            *p = pixel;
+            p += rowStep;
+            err += w.errStep;
+            if (err >= w.errWrap) { err -= w.errWrap; p += w.sx; }
+        }
+    }
+}
+
+// Same walk as drawLineScreen, writing palette indices into the 8-bit buffer
+void drawLineScreenIndexed(Canvas* canvas, int x0, int y0, int x1, int y1,
+                           uint8_t index, const ClipRect* clip)
+{
+    LineWalk w;
+    if (!setupLineWalk(x0, y0, x1, y1, clip, &w)) return;
+
+    uint8_t* p = canvas->indexBuffer + (ptrdiff_t)w.py * canvas->bufferWidth + w.px;
+    ptrdiff_t rowStep = (ptrdiff_t)w.sy * canvas->bufferWidth;
+    int count = w.count;
+    long long err = w.err;
+
+    if (w.straight) {
+        ptrdiff_t step = w.xMajor ? w.sx : rowStep;
+        while (count--) { *p = index; p += step; }
+    } else if (w.xMajor) {
+        while (count--) {
+            *p = index;
+            p += w.sx;
+            err += w.errStep;
+            if (err >= w.errWrap) { err -= w.errWrap; p += rowStep; }
+        }
+    } else {
+        while (count--) {
+            *p = index;
+            p += rowStep;
+            err += w.errStep;
+            if (err >= w.errWrap) { err -= w.errWrap; p += w.sx; }
+        }
+    }
+}
+
+// Bounding box of a screen-space line, limited to its clip rect
+static ClipRect lineBounds(int x0, int y0, int x1, int y1, const ClipRect* clip)
+{
+    int minX = x0 < x1 ? x0 : x1, maxX = x0 < x1 ? x1 : x0;
+    int minY = y0 < y1 ? y0 : y1, maxY = y0 < y1 ? y1 : y0;
+    if (minX < clip->minX) minX = clip->minX;
+    if (minY < clip->minY) minY = clip->minY;
+    if (maxX >= clip->maxX) maxX = clip->maxX - 1;
+    if (maxY >= clip->maxY) maxY = clip->maxY - 1;
+    return (ClipRect){ minX, minY, maxX + 1, maxY + 1 };
+}
+
+// Record the bounding box of a screen-space line, limited to its clip rect
+static void markLineDirty(Canvas* canvas, int x0, int y0, int x1, int y1, const ClipRect* clip)
+{
+    ClipRect r = lineBounds(x0, y0, x1, y1, clip);
+    Canvas_MarkDirty(canvas, r.minX, r.minY, r.maxX, r.maxY);
+}
+
+// Convert a center-origin line (y up) to screen space (y down) and draw it
+static void drawLineCanvas(Canvas* canvas, int x0, int y0, int x1, int y1,
+                           PackedColor pixel, const ClipRect* clip)
+{
+    int halfW = canvas->bufferWidth / 2;
+    int halfH = canvas->bufferHeight / 2;
+    x0 = halfW + Canvas_ScaleInt(canvas, x0);
+    y0 = halfH - Canvas_ScaleInt(canvas, y0);
+    x1 = halfW + Canvas_ScaleInt(canvas, x1);
+    y1 = halfH - Canvas_ScaleInt(canvas, y1);
+    markLineDirty(canvas, x0, y0, x1, y1, clip);
+    drawLineScreen(canvas, x0, y0, x1, y1, pixel, clip);
+}
+
+void drawLineClipped(Canvas* canvas,
+                     int x0, int y0, int x1, int y1,
+                     Color color, const ClipRect* clip)
+{
+    drawLineCanvas(canvas, x0, y0, x1, y1, Canvas_PackColor(color), clip);
+}
+
+void drawLinePacked(Canvas* canvas,
+                    int x0, int y0, int x1, int y1,
+                    PackedColor color)
+{
+    ClipRect clip = { 0, 0, canvas->bufferWidth, canvas->bufferHeight };
+    drawLineCanvas(canvas, x0, y0, x1, y1, color, &clip);
+}
+
+void drawLineIndexed(Canvas* canvas,
+                     int x0, int y0, int x1, int y1,
+                     uint8_t index)
+{
+    ClipRect clip = { 0, 0, canvas->bufferWidth, canvas->bufferHeight };
+    int halfW = canvas->bufferWidth / 2;
+    int halfH = canvas->bufferHeight / 2;
+    x0 = halfW + Canvas_ScaleInt(canvas, x0);
+    y0 = halfH - Canvas_ScaleInt(canvas, y0);
+    x1 = halfW + Canvas_ScaleInt(canvas, x1);
+    y1 = halfH - Canvas_ScaleInt(canvas, y1);
+    ClipRect r = lineBounds(x0, y0, x1, y1, &clip);
+    Canvas_MarkIndexDirty(canvas, r.minX, r.minY, r.maxX, r.maxY);
+    drawLineScreenIndexed(canvas, x0, y0, x1, y1, index, &clip);
+}
 
 void drawLine(Canvas* canvas,
              int x0, int y0, int x1, int y1,
              Color color)
 {
-    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-    int err = dx + dy, e2;
-    while (true) {
-        Canvas_PutPixel(canvas, x0, y0, color);
-        if (x0 == x1 && y0 == y1) break;
-        e2 = 2*err;
-        if (e2 >= dy) { err += dy; x0 += sx; }
-        if (e2 <= dx) { err += dx; y0 += sy; }
-    }
+    drawLinePacked(canvas, x0, y0, x1, y1, Canvas_PackColor(color));
 }
 
-void drawTriangle(Canvas* canvas, const Triangle* t)
+// Screen-space vertices of the local base triangle (pointing up) rotated by
+// angle and moved to (cx, cy), scaled to the canvas' render resolution
+void triangleOutlineVertices(const Canvas* canvas, float cx, float cy, float size, float angle,
+                             int vx[3], int vy[3])
 {
-    // local base-triangle pointing up
-    float bx[3] = { 0,  t->size, -t->size };
-    float by[3] = { -t->size,  t->size,  t->size };
-    float c = cosf(t->angle), s = sinf(t->angle);
+    float scale = canvas->renderScale;
+    cx *= scale;
+    cy *= scale;
+    size *= scale;
 
-    int vx[3], vy[3];
+    float bx[3] = { 0,  size, -size };
+    float by[3] = { -size,  size,  size };
+    float c = cosf(angle), s = sinf(angle);
+
+    int halfW = canvas->bufferWidth / 2;
+    int halfH = canvas->bufferHeight / 2;
     for (int i = 0; i < 3; i++) {
         float rx = bx[i]*c - by[i]*s;
         float ry = bx[i]*s + by[i]*c;
-        vx[i] = (int)(t->cx + rx);
-        vy[i] = (int)(t->cy + ry);
+        vx[i] = halfW + (int)(cx + rx);
+        vy[i] = halfH - (int)(cy + ry);
     }
+}
+
+void drawTrianglePacked(Canvas* canvas, float cx, float cy, float size, float angle,
+                        PackedColor color)
+{
+    int vx[3], vy[3];
+    triangleOutlineVertices(canvas, cx, cy, size, angle, vx, vy);
+
+    // Bounding box of the outline
+    int minX = vx[0], maxX = vx[0], minY = vy[0], maxY = vy[0];
+    for (int i = 1; i < 3; i++) {
+        if (vx[i] < minX) minX = vx[i];
+        if (vx[i] > maxX) maxX = vx[i];
+        if (vy[i] < minY) minY = vy[i];
+        if (vy[i] > maxY) maxY = vy[i];
+    }
+    Canvas_MarkDirty(canvas, minX, minY, maxX + 1, maxY + 1);
 
     // draw the three edges
-    drawLine(canvas, vx[0], vy[0], vx[1], vy[1], t->color);
-    drawLine(canvas, vx[1], vy[1], vx[2], vy[2], t->color);
-    drawLine(canvas, vx[2], vy[2], vx[0], vy[0], t->color);
+    ClipRect clip = { 0, 0, canvas->bufferWidth, canvas->bufferHeight };
+    drawLineScreen(canvas, vx[0], vy[0], vx[1], vy[1], color, &clip);
+    drawLineScreen(canvas, vx[1], vy[1], vx[2], vy[2], color, &clip);
+    drawLineScreen(canvas, vx[2], vy[2], vx[0], vy[0], color, &clip);
+}
+
+void drawTriangleIndexed(Canvas* canvas, float cx, float cy, float size, float angle,
+                         uint8_t index)
+{
+    int vx[3], vy[3];
+    triangleOutlineVertices(canvas, cx, cy, size, angle, vx, vy);
+
+    // Bounding box of the outline, in the index buffer's dirty list
+    int minX = vx[0], maxX = vx[0], minY = vy[0], maxY = vy[0];
+    for (int i = 1; i < 3; i++) {
+        if (vx[i] < minX) minX = vx[i];
+        if (vx[i] > maxX) maxX = vx[i];
+        if (vy[i] < minY) minY = vy[i];
+        if (vy[i] > maxY) maxY = vy[i];
+    }
+    Canvas_MarkIndexDirty(canvas, minX, minY, maxX + 1, maxY + 1);
+
+    ClipRect clip = { 0, 0, canvas->bufferWidth, canvas->bufferHeight };
+    drawLineScreenIndexed(canvas, vx[0], vy[0], vx[1], vy[1], index, &clip);
+    drawLineScreenIndexed(canvas, vx[1], vy[1], vx[2], vy[2], index, &clip);
+    drawLineScreenIndexed(canvas, vx[2], vy[2], vx[0], vy[0], index, &clip);
+}
+
+void drawTriangle(Canvas* canvas, const Triangle* t)
+{
+    drawTrianglePacked(canvas, t->cx, t->cy, t->size, t->angle, Canvas_PackColor(t->color));
 }
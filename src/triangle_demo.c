@@ -1,6 +1,11 @@
 #include "../include/triangle_demo.h"
 #include "../include/triangle.h"
 #include "../include/triangle_simd.h"
+#include "../include/tile_renderer.h"
+#include "../include/stamp_cache.h"
+#include "../include/triangle_lod.h"
+#include "../include/camera.h"
+#include "../include/input.h"
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
@@ -16,6 +21,29 @@ static Triangle* triangles = NULL;
 // SIMD data structure for optimized rendering
 static TriangleDataSIMD simdData;
 
+// Tile-binned renderer, started the first time the tiled mode is used
+static TriangleRenderMode renderMode = TRIANGLE_RENDER_DEFAULT;
+static TileRenderer tileRenderer;
+static bool tileRendererReady = false;
+
+// Coverage buffer of the front-to-back filled mode
+static CoverageBuffer coverage;
+
+// Outline patterns of the stamped mode, rasterized the first time it is used
+static StampCache stampCache;
+static bool stampCacheReady = false;
+
+// Size buckets of the LOD mode, patterns built the first time it is used
+static TriangleLOD triangleLOD;
+static bool triangleLODReady = false;
+
+// Camera of the camera mode, over the triangles taken as world coordinates,
+// and the view-space copy of the visible ones
+static Camera camera;
+static TriangleDataSIMD cameraView;
+static bool cameraReady = false;
+static float cameraTime = 0.0f;
+
 // Performance timing variables
 static struct timeval lastFrameTime;
 static double lastFrameDuration = 0.0;
@@ -57,54 +85,130 @@ void initRandomTriangles(int w, int h) {
     totalFrameTime = 0.0;
 }
 
+void setTriangleRenderMode(TriangleRenderMode mode) {
+    renderMode = mode;
+}
+
 void renderRandomTriangles(Canvas* canvas, float dt) {
     // Start timing this frame
     double frameStart = getCurrentTime();
     
-#if defined(USE_AVX2) || defined(USE_SSE2)
-    // SIMD optimized path
+    if (renderMode == TRIANGLE_RENDER_TILED && !tileRendererReady) {
+        tileRendererReady = tileRenderer_init(&tileRenderer, 0);
+        if (tileRendererReady) {
+            printf("Tiled renderer started with %d workers\n", tileRenderer.pool.workerCount);
+        } else {
+            fprintf(stderr, "Error: Failed to start tiled renderer, using default path\n");
+            renderMode = TRIANGLE_RENDER_DEFAULT;
+        }
+    }
     
-    // Update all triangles and perform frustum culling with SIMD
-    updateAndCullSIMD(&simdData, dt, canvas->width, canvas->height);
+    if (renderMode == TRIANGLE_RENDER_STAMPED && !stampCacheReady) {
+        stampCacheReady = stampCache_init(&stampCache, STAMP_CACHE_DEFAULT_SIZE, STAMP_CACHE_DEFAULT_STEPS);
+        if (!stampCacheReady) {
+            fprintf(stderr, "Error: Failed to build the stamp cache, using default path\n");
+            renderMode = TRIANGLE_RENDER_DEFAULT;
+        }
+    }
     
-    // Render all visible triangles
-    renderTrianglesSIMD(canvas, &simdData);
+    if ((renderMode == TRIANGLE_RENDER_LOD || renderMode == TRIANGLE_RENDER_CAMERA) && !triangleLODReady) {
+        triangleLOD_init(&triangleLOD, LOD_POINT_BELOW, LOD_PATTERN_BELOW);
+        triangleLODReady = true;
+    }
     
-    // Update the original triangle array (just angles for mouse interaction)
-    for (int i = 0; i < TRIANGLE_COUNT; i++) {
-        triangles[i].angle = simdData.angle[i];
+    if (renderMode == TRIANGLE_RENDER_CAMERA && !cameraReady) {
+        camera_init(&camera);
+        cameraTime = 0.0f;
+        cameraReady = true;
     }
-#else
-    // Scalar fallback path
     
-    // Canvas dimensions for culling check
-    int canvas_width = canvas->width;
-    int canvas_height = canvas->height;
+    if (renderMode == TRIANGLE_RENDER_TILED) {
+        // The tiled path works on the SoA data in every build
+        updateAndCullSIMD(&simdData, dt, canvas->width, canvas->height);
+        renderTrianglesTiled(&tileRenderer, canvas, &simdData);
+        
+        for (int i = 0; i < TRIANGLE_COUNT; i++) {
+            triangles[i].angle = simdData.angle[i];
+        }
+    } else if (renderMode == TRIANGLE_RENDER_STAMPED) {
+        updateAndCullSIMD(&simdData, dt, canvas->width, canvas->height);
+        renderTrianglesStamped(canvas, &simdData, &stampCache);
+        
+        for (int i = 0; i < TRIANGLE_COUNT; i++) {
+            triangles[i].angle = simdData.angle[i];
+        }
+    } else if (renderMode == TRIANGLE_RENDER_LOD) {
+        updateAndCullSIMD(&simdData, dt, canvas->width, canvas->height);
+        renderTrianglesLOD(canvas, &simdData, &triangleLOD);
+        
+        for (int i = 0; i < TRIANGLE_COUNT; i++) {
+            triangles[i].angle = simdData.angle[i];
+        }
+    } else if (renderMode == TRIANGLE_RENDER_CAMERA) {
+        // The camera turns slowly and zooms between 0.5 and 1.5
+        cameraTime += dt;
+        camera.rotation = 0.1f * cameraTime;
+        camera_setZoom(&camera, 1.0f + 0.5f * sinf(0.3f * cameraTime));
+        camera_updateAndCull(&camera, canvas, &simdData, dt);
+        renderTrianglesCamera(canvas, &camera, &simdData, &cameraView, &triangleLOD);
+        
+        for (int i = 0; i < TRIANGLE_COUNT; i++) {
+            triangles[i].angle = simdData.angle[i];
+        }
+    } else if (renderMode == TRIANGLE_RENDER_OCCLUDED) {
+        // Occlusion culling builds on the frustum culling pass
+        updateAndCullSIMD(&simdData, dt, canvas->width, canvas->height);
+        renderFilledTrianglesOccluded(canvas, &simdData, &coverage, NULL);
+        
+        for (int i = 0; i < TRIANGLE_COUNT; i++) {
+            triangles[i].angle = simdData.angle[i];
+        }
+    } else {
+#if defined(USE_AVX2) || defined(USE_SSE2)
+        // SIMD optimized path
+    
+        // Update all triangles and perform frustum culling with SIMD
+        updateAndCullSIMD(&simdData, dt, canvas->width, canvas->height);
     
-    // Create a smaller frustum boundary to make culling visible at the edges
-    // Using 80% of the canvas size to create a visible border effect
-    float frustum_width = canvas_width * 0.8f;
-    float frustum_height = canvas_height * 0.8f;
+        // Render all visible triangles
+        renderTrianglesSIMD(canvas, &simdData);
     
-    for (int i = 0; i < TRIANGLE_COUNT; i++) {
-        triangles[i].angle += triangles[i].speed * dt;
-        
-        // Simple frustum culling - check if triangle is entirely outside our reduced frustum
-        // Consider the triangle's center position and maximum possible extent (size)
-        float max_extent = triangles[i].size * 1.5f; // Adding a small margin for rotation
-        
-        // If the triangle's bounding box is completely outside the reduced frustum, skip it
-        if (triangles[i].cx + max_extent < -frustum_width/2.0f || 
-            triangles[i].cx - max_extent > frustum_width/2.0f ||
-            triangles[i].cy + max_extent < -frustum_height/2.0f ||
-            triangles[i].cy - max_extent > frustum_height/2.0f) {
-            continue; // Skip this triangle - it's outside the reduced view
+        // Update the original triangle array (just angles for mouse interaction)
+        for (int i = 0; i < TRIANGLE_COUNT; i++) {
+            triangles[i].angle = simdData.angle[i];
         }
+#else
+        // Scalar fallback path
+    
+        // Canvas dimensions for culling check
+        int canvas_width = canvas->width;
+        int canvas_height = canvas->height;
+    
+        // Create a smaller frustum boundary to make culling visible at the edges
+        // Using 80% of the canvas size to create a visible border effect
+        float frustum_width = canvas_width * 0.8f;
+        float frustum_height = canvas_height * 0.8f;
+    
+        for (int i = 0; i < TRIANGLE_COUNT; i++) {
+            triangles[i].angle += triangles[i].speed * dt;
         
-        // Draw the triangle since it's at least partially visible
-        drawTriangle(canvas, &triangles[i]);
-    }
+            // Simple frustum culling - check if triangle is entirely outside our reduced frustum
+            // Consider the triangle's center position and maximum possible extent (size)
+            float max_extent = triangles[i].size * 1.5f; // Adding a small margin for rotation
+        
+            // If the triangle's bounding box is completely outside the reduced frustum, skip it
+            if (triangles[i].cx + max_extent < -frustum_width/2.0f || 
+                triangles[i].cx - max_extent > frustum_width/2.0f ||
+                triangles[i].cy + max_extent < -frustum_height/2.0f ||
+                triangles[i].cy - max_extent > frustum_height/2.0f) {
+                continue; // Skip this triangle - it's outside the reduced view
+            }
+        
+            // Draw the triangle since it's at least partially visible
+            drawTriangle(canvas, &triangles[i]);
+        }
 #endif
+    }
     
     // Collect timing data
     double frameEnd = getCurrentTime();
@@ -130,6 +234,12 @@ void renderRandomTriangles(Canvas* canvas, float dt) {
 #endif
         printf("FPS: %.1f, Triangles/sec: %.1fM, Frame time: %.3f ms\n", 
                fps, trianglesPerSec / 1000000.0, avgFrameTime * 1000.0);
+        if (renderMode == TRIANGLE_RENDER_OCCLUDED) {
+            printf("Occluded: %d of %d triangles\n", coverage.occluded, TRIANGLE_COUNT);
+        } else if (renderMode == TRIANGLE_RENDER_LOD || renderMode == TRIANGLE_RENDER_CAMERA) {
+            printf("LOD buckets: %d points, %d patterns, %d full\n", triangleLOD.pointCount,
+                   triangleLOD.tinyCount, triangleLOD.fullCount);
+        }
         
         // Reset counters for the next sample
         if (frameCounter >= 120) {
@@ -144,6 +254,14 @@ void updateTrianglesWithMouse(int mouseX, int mouseY, int canvasWidth, int canva
     // Note: Flip the Y coordinate because screen Y increases downward but our canvas Y increases upward
     float canvasMouseX = mouseX - canvasWidth/2.0f;
     float canvasMouseY = canvasHeight/2.0f - mouseY; // Flipped Y axis
+    float radius = MOUSE_INFLUENCE_RADIUS;
+    
+    // Through the camera the triangles live in world coordinates: push the
+    // ones under the cursor there, over the radius as it appears on screen
+    if (renderMode == TRIANGLE_RENDER_CAMERA && cameraReady) {
+        getMouseWorld(&camera, &canvasMouseX, &canvasMouseY);
+        radius /= camera.zoom;
+    }
     
     // Interaction strength multiplier (stronger when mouse is pressed)
     float strengthMultiplier = isPressed ? 2.5f : 1.0f;
@@ -156,7 +274,7 @@ void updateTrianglesWithMouse(int mouseX, int mouseY, int canvasWidth, int canva
         float distSquared = dx*dx + dy*dy;
         
         // Skip triangles too far from mouse cursor
-        if (distSquared > MOUSE_INFLUENCE_RADIUS * MOUSE_INFLUENCE_RADIUS) {
+        if (distSquared > radius * radius) {
             continue;
         }
         
@@ -178,11 +296,9 @@ void updateTrianglesWithMouse(int mouseX, int mouseY, int canvasWidth, int canva
         // Add a slight rotation effect based on mouse movement
         triangles[i].angle += (dirX + dirY) * 0.01f * strengthMultiplier;
         
-#if defined(USE_AVX2) || defined(USE_SSE2)
-        // Update SIMD data structure as well
+        // Update SIMD data structure as well (the tiled path reads it in every build)
         simdData.cx[i] = triangles[i].cx;
         simdData.cy[i] = triangles[i].cy;
         simdData.angle[i] = triangles[i].angle;
-#endif
     }
 }
\ No newline at end of file
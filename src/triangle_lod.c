@@ -0,0 +1,325 @@
+#include "../include/triangle_lod.h"
+#include "../include/triangle.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Scalar builds convert only centers this close to the origin (buffer pixels)
+#define LOD_PLACE_LIMIT 16384.0f
+
+void triangleLOD_free(TriangleLOD* lod) {
+    free(lod->points);
+    free(lod->tiny);
+    free(lod->full);
+    lod->points = lod->tiny = NULL;
+    lod->full = NULL;
+    lod->capacity = 0;
+}
+
+// The outline calcTriangleVertices gives for size 1 around the middle pixel
+// of a 3x3 raster, vertices rounded; canvas y points up, so rows flip it
+static uint16_t rasterizePattern(Canvas* view, float angle) {
+    float bx[3] = { 0, 1, -1 };
+    float by[3] = { -1, 1, 1 };
+    float c = cosf(angle);
+    float s = sinf(angle);
+    int px[3], py[3];
+    for (int i = 0; i < 3; i++) {
+        px[i] = 1 + (int)lrintf(bx[i] * c - by[i] * s);
+        py[i] = 1 - (int)lrintf(bx[i] * s + by[i] * c);
+    }
+
+    memset(view->backBuffer, 0, sizeof(uint32_t) * 9);
+    ClipRect clip = { 0, 0, 3, 3 };
+    drawLineScreen(view, px[0], py[0], px[1], py[1], 1, &clip);
+    drawLineScreen(view, px[1], py[1], px[2], py[2], 1, &clip);
+    drawLineScreen(view, px[2], py[2], px[0], py[0], 1, &clip);
+
+    uint16_t bits = 0;
+    for (int i = 0; i < 9; i++) {
+        if (view->backBuffer[i]) bits |= (uint16_t)(1u << i);
+    }
+    return bits;
+}
+
+void triangleLOD_init(TriangleLOD* lod, float pointBelow, float patternBelow) {
+    memset(lod, 0, sizeof(*lod));
+    lod->pointBelow = pointBelow;
+    lod->patternBelow = patternBelow;
+
+    // drawLineScreen only needs the buffer and its pitch
+    uint32_t raster[9];
+    Canvas view;
+    memset(&view, 0, sizeof(view));
+    view.backBuffer = raster;
+    view.bufferWidth = view.bufferHeight = view.pitch = 3;
+    for (int a = 0; a < LOD_PATTERN_STEPS; a++) {
+        lod->patterns[a] = rasterizePattern(&view, a * (2.0f * (float)M_PI / LOD_PATTERN_STEPS));
+    }
+}
+
+// Sort the visible triangles into the buckets by |size|, SIMD_LANES at a time
+static void classify(const TriangleDataSIMD* data, TriangleLOD* lod, float pointSize, float tinySize) {
+    int pointCount = 0, tinyCount = 0, fullCount = 0;
+#if defined(__AVX2__)
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 pointLimit = _mm256_set1_ps(pointSize);
+    const __m256 tinyLimit = _mm256_set1_ps(tinySize);
+#elif defined(__SSE2__)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 pointLimit = _mm_set1_ps(pointSize);
+    const __m128 tinyLimit = _mm_set1_ps(tinySize);
+#endif
+
+    for (int i = 0; i < data->count; i += SIMD_LANES) {
+        int left = data->count - i;
+        unsigned live = left >= SIMD_LANES ? (1u << SIMD_LANES) - 1 : (1u << left) - 1;
+        unsigned visible = simd_boolBits(data->visible + i) & live;
+
+#if defined(__AVX2__)
+        __m256 size = _mm256_and_ps(_mm256_loadu_ps(data->size + i), absMask);
+        unsigned point = (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(size, pointLimit, _CMP_LT_OQ)) & visible;
+        unsigned tiny = (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(size, tinyLimit, _CMP_LT_OQ)) & visible & ~point;
+#elif defined(__SSE2__)
+        __m128 size = _mm_and_ps(_mm_loadu_ps(data->size + i), absMask);
+        unsigned point = (unsigned)_mm_movemask_ps(_mm_cmplt_ps(size, pointLimit)) & visible;
+        unsigned tiny = (unsigned)_mm_movemask_ps(_mm_cmplt_ps(size, tinyLimit)) & visible & ~point;
+#else
+        float size = fabsf(data->size[i]);
+        unsigned point = (size < pointSize) & visible;
+        unsigned tiny = (size < tinySize) & visible & ~point;
+#endif
+        unsigned full = visible & ~point & ~tiny;
+
+        for (; point; point &= point - 1) lod->points[pointCount++] = i + __builtin_ctz(point);
+        for (; tiny; tiny &= tiny - 1) lod->tiny[tinyCount++] = i + __builtin_ctz(tiny);
+        for (int l = 0; l < SIMD_LANES; l++) lod->full[i + l] = (full >> l) & 1;
+        fullCount += __builtin_popcount(full);
+    }
+
+    lod->pointCount = pointCount;
+    lod->tinyCount = tinyCount;
+    lod->fullCount = fullCount;
+}
+
+// Anchor pixels (the pixel holding the center) of the n <= SIMD_LANES
+// triangles idx[0..n), and with steps their pattern orientation. Returns in
+// inside the lanes whose anchor is at least margin pixels inside the canvas
+// and in nearby those within margin pixels of it.
+static void anchorBatch(const Canvas* canvas, const TriangleDataSIMD* data, const int* idx, int n,
+                        int margin, int x[SIMD_LANES], int y[SIMD_LANES], int* steps,
+                        unsigned* inside, unsigned* nearby) {
+    const float scale = canvas->renderScale;
+    const float angleScale = LOD_PATTERN_STEPS / (2.0f * (float)M_PI);
+    const int width = canvas->bufferWidth, height = canvas->bufferHeight;
+#if defined(__AVX2__)
+    __m256i live = _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i index = _mm256_maskload_epi32(idx, live);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 scale_vec = _mm256_set1_ps(scale);
+    __m256 cx = _mm256_mask_i32gather_ps(zero, data->cx, index, _mm256_castsi256_ps(live), 4);
+    __m256 cy = _mm256_mask_i32gather_ps(zero, data->cy, index, _mm256_castsi256_ps(live), 4);
+
+    // Out-of-range centers convert to INT_MIN, which no bounds test passes
+    __m256i xv = _mm256_add_epi32(_mm256_set1_epi32(width / 2), _mm256_cvttps_epi32(_mm256_mul_ps(cx, scale_vec)));
+    __m256i yv = _mm256_sub_epi32(_mm256_set1_epi32(height / 2), _mm256_cvttps_epi32(_mm256_mul_ps(cy, scale_vec)));
+    _mm256_storeu_si256((__m256i*)x, xv);
+    _mm256_storeu_si256((__m256i*)y, yv);
+
+    __m256i in = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpgt_epi32(xv, _mm256_set1_epi32(margin - 1)),
+                         _mm256_cmpgt_epi32(_mm256_set1_epi32(width - margin), xv)),
+        _mm256_and_si256(_mm256_cmpgt_epi32(yv, _mm256_set1_epi32(margin - 1)),
+                         _mm256_cmpgt_epi32(_mm256_set1_epi32(height - margin), yv)));
+    __m256i close = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpgt_epi32(xv, _mm256_set1_epi32(-margin - 1)),
+                         _mm256_cmpgt_epi32(_mm256_set1_epi32(width + margin), xv)),
+        _mm256_and_si256(_mm256_cmpgt_epi32(yv, _mm256_set1_epi32(-margin - 1)),
+                         _mm256_cmpgt_epi32(_mm256_set1_epi32(height + margin), yv)));
+    *inside = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(in, live)));
+    *nearby = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(close, live)));
+
+    if (steps) {
+        __m256 angle = _mm256_mask_i32gather_ps(zero, data->angle, index, _mm256_castsi256_ps(live), 4);
+        __m256 step = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(angle, _mm256_set1_ps(angleScale)),
+                                                    _mm256_set1_ps(0.5f)));
+        __m256i wrapped = _mm256_and_si256(_mm256_cvttps_epi32(step), _mm256_set1_epi32(LOD_PATTERN_STEPS - 1));
+        _mm256_storeu_si256((__m256i*)steps, wrapped);
+    }
+#elif defined(__SSE2__)
+    // No gather before AVX2: set the lanes from registers, since a vector
+    // load of values just stored would wait for the pixel stores to drain.
+    // Lanes past n repeat the first triangle and are masked out.
+    int i0 = idx[0];
+    int i1 = n > 1 ? idx[1] : i0, i2 = n > 2 ? idx[2] : i0, i3 = n > 3 ? idx[3] : i0;
+    __m128 cx = _mm_setr_ps(data->cx[i0], data->cx[i1], data->cx[i2], data->cx[i3]);
+    __m128 cy = _mm_setr_ps(data->cy[i0], data->cy[i1], data->cy[i2], data->cy[i3]);
+    __m128 scale_vec = _mm_set1_ps(scale);
+    __m128i xv = _mm_add_epi32(_mm_set1_epi32(width / 2), _mm_cvttps_epi32(_mm_mul_ps(cx, scale_vec)));
+    __m128i yv = _mm_sub_epi32(_mm_set1_epi32(height / 2), _mm_cvttps_epi32(_mm_mul_ps(cy, scale_vec)));
+    _mm_storeu_si128((__m128i*)x, xv);
+    _mm_storeu_si128((__m128i*)y, yv);
+
+    __m128i in = _mm_and_si128(
+        _mm_and_si128(_mm_cmpgt_epi32(xv, _mm_set1_epi32(margin - 1)),
+                      _mm_cmplt_epi32(xv, _mm_set1_epi32(width - margin))),
+        _mm_and_si128(_mm_cmpgt_epi32(yv, _mm_set1_epi32(margin - 1)),
+                      _mm_cmplt_epi32(yv, _mm_set1_epi32(height - margin))));
+    __m128i close = _mm_and_si128(
+        _mm_and_si128(_mm_cmpgt_epi32(xv, _mm_set1_epi32(-margin - 1)),
+                      _mm_cmplt_epi32(xv, _mm_set1_epi32(width + margin))),
+        _mm_and_si128(_mm_cmpgt_epi32(yv, _mm_set1_epi32(-margin - 1)),
+                      _mm_cmplt_epi32(yv, _mm_set1_epi32(height + margin))));
+    unsigned live = (1u << n) - 1;
+    *inside = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(in)) & live;
+    *nearby = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(close)) & live;
+
+    if (steps) {
+        // floor: truncate, then step back where truncation rounded up
+        __m128 angle = _mm_setr_ps(data->angle[i0], data->angle[i1], data->angle[i2], data->angle[i3]);
+        __m128 value = _mm_add_ps(_mm_mul_ps(angle, _mm_set1_ps(angleScale)), _mm_set1_ps(0.5f));
+        __m128i step = _mm_cvttps_epi32(value);
+        step = _mm_add_epi32(step, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(step), value)));
+        _mm_storeu_si128((__m128i*)steps, _mm_and_si128(step, _mm_set1_epi32(LOD_PATTERN_STEPS - 1)));
+    }
+#else
+    *inside = *nearby = 0;
+    for (int l = 0; l < n; l++) {
+        float cx = data->cx[idx[l]] * scale;
+        float cy = data->cy[idx[l]] * scale;
+        if (!(fabsf(cx) < LOD_PLACE_LIMIT && fabsf(cy) < LOD_PLACE_LIMIT)) continue;
+        x[l] = width / 2 + (int)cx;
+        y[l] = height / 2 - (int)cy;
+        if (x[l] >= margin && x[l] < width - margin && y[l] >= margin && y[l] < height - margin) {
+            *inside |= 1u << l;
+        }
+        if (x[l] >= -margin && x[l] < width + margin && y[l] >= -margin && y[l] < height + margin) {
+            *nearby |= 1u << l;
+        }
+        if (steps) {
+            float step = floorf(data->angle[idx[l]] * angleScale + 0.5f);
+            steps[l] = fabsf(step) < LOD_PLACE_LIMIT ? (int)step & (LOD_PATTERN_STEPS - 1) : 0;
+        }
+    }
+#endif
+}
+
+typedef struct {
+    int minX, minY, maxX, maxY;
+} LODBounds;
+
+static inline void growBounds(LODBounds* b, int x0, int y0, int x1, int y1) {
+    if (x0 < b->minX) b->minX = x0;
+    if (y0 < b->minY) b->minY = y0;
+    if (x1 > b->maxX) b->maxX = x1;
+    if (y1 > b->maxY) b->maxY = y1;
+}
+
+// Point bucket: one store per triangle whose anchor is on the canvas
+static void drawPoints(Canvas* canvas, const TriangleDataSIMD* data, const int* points, int count,
+                       LODBounds* bounds) {
+    int x[SIMD_LANES], y[SIMD_LANES];
+    uint32_t* buffer = canvas->backBuffer;
+    const int pitch = canvas->pitch;
+    for (int b = 0; b < count; b += SIMD_LANES) {
+        int n = count - b < SIMD_LANES ? count - b : SIMD_LANES;
+        unsigned inside, nearby;
+        anchorBatch(canvas, data, points + b, n, 0, x, y, NULL, &inside, &nearby);
+        for (; inside; inside &= inside - 1) {
+            int l = __builtin_ctz(inside);
+            buffer[(size_t)y[l] * pitch + x[l]] = data->color[points[b + l]];
+            growBounds(bounds, x[l], y[l], x[l] + 1, y[l] + 1);
+        }
+    }
+}
+
+#if defined(__AVX2__)
+// Lane masks of the 3-bit pattern rows, the fourth lane never written
+static const int rowMasks[8][4] = {
+    {  0,  0,  0, 0 }, { -1,  0,  0, 0 }, {  0, -1,  0, 0 }, { -1, -1,  0, 0 },
+    {  0,  0, -1, 0 }, { -1,  0, -1, 0 }, {  0, -1, -1, 0 }, { -1, -1, -1, 0 },
+};
+#endif
+
+// Pattern bucket: the 3x3 outline of each triangle's orientation. Anchors
+// a pixel or more inside take the unclipped store; the rest clip per pixel.
+static void drawPatterns(Canvas* canvas, const TriangleDataSIMD* data, const TriangleLOD* lod,
+                         LODBounds* bounds) {
+    int x[SIMD_LANES], y[SIMD_LANES], steps[SIMD_LANES];
+    uint32_t* buffer = canvas->backBuffer;
+    const int pitch = canvas->pitch;
+    const int* tiny = lod->tiny;
+    for (int b = 0; b < lod->tinyCount; b += SIMD_LANES) {
+        int n = lod->tinyCount - b < SIMD_LANES ? lod->tinyCount - b : SIMD_LANES;
+        unsigned inside, nearby;
+        anchorBatch(canvas, data, tiny + b, n, 1, x, y, steps, &inside, &nearby);
+
+        for (unsigned lanes = inside; lanes; lanes &= lanes - 1) {
+            int l = __builtin_ctz(lanes);
+            uint32_t pixel = data->color[tiny[b + l]];
+            unsigned pattern = lod->patterns[steps[l]];
+            uint32_t* dst = buffer + (size_t)(y[l] - 1) * pitch + (x[l] - 1);
+#if defined(__AVX2__)
+            __m128i pixel_vec = _mm_set1_epi32((int)pixel);
+            for (int r = 0; r < 3; r++, dst += pitch) {
+                unsigned row = (pattern >> (3 * r)) & 7;
+                if (row) _mm_maskstore_epi32((int*)dst, _mm_loadu_si128((const __m128i*)rowMasks[row]), pixel_vec);
+            }
+#else
+            for (; pattern; pattern &= pattern - 1) {
+                int bit = __builtin_ctz(pattern);
+                dst[(bit / 3) * pitch + bit % 3] = pixel;
+            }
+#endif
+            growBounds(bounds, x[l] - 1, y[l] - 1, x[l] + 2, y[l] + 2);
+        }
+
+        for (unsigned lanes = nearby & ~inside; lanes; lanes &= lanes - 1) {
+            int l = __builtin_ctz(lanes);
+            uint32_t pixel = data->color[tiny[b + l]];
+            for (unsigned pattern = lod->patterns[steps[l]]; pattern; pattern &= pattern - 1) {
+                int bit = __builtin_ctz(pattern);
+                int px = x[l] - 1 + bit % 3;
+                int py = y[l] - 1 + bit / 3;
+                if (px < 0 || py < 0 || px >= canvas->bufferWidth || py >= canvas->bufferHeight) continue;
+                buffer[(size_t)py * pitch + px] = pixel;
+                growBounds(bounds, px, py, px + 1, py + 1);
+            }
+        }
+    }
+}
+
+void renderTrianglesLOD(Canvas* canvas, TriangleDataSIMD* data, TriangleLOD* lod) {
+    // The classifier writes full flags a whole batch at a time
+    int needed = (data->count + SIMD_LANES - 1) / SIMD_LANES * SIMD_LANES;
+    if (needed > lod->capacity) {
+        int* points = realloc(lod->points, sizeof(int) * (size_t)needed);
+        if (points) lod->points = points;
+        int* tiny = realloc(lod->tiny, sizeof(int) * (size_t)needed);
+        if (tiny) lod->tiny = tiny;
+        bool* full = realloc(lod->full, sizeof(bool) * (size_t)needed);
+        if (full) lod->full = full;
+        if (!points || !tiny || !full) {
+            renderTrianglesSIMD(canvas, data);
+            return;
+        }
+        lod->capacity = needed;
+    }
+
+    // Thresholds are projected heights, 2 * size * renderScale
+    float toSize = 0.5f / canvas->renderScale;
+    classify(data, lod, lod->pointBelow * toSize, lod->patternBelow * toSize);
+
+    LODBounds bounds = { canvas->bufferWidth, canvas->bufferHeight, -1, -1 };
+    drawPoints(canvas, data, lod->points, lod->pointCount, &bounds);
+    drawPatterns(canvas, data, lod, &bounds);
+
+    // One dirty rectangle for both small buckets keeps the bookkeeping out of the loops
+    if (bounds.maxX >= 0) Canvas_MarkDirty(canvas, bounds.minX, bounds.minY, bounds.maxX, bounds.maxY);
+
+    if (lod->fullCount) {
+        TriangleDataSIMD rest = *data;
+        rest.visible = lod->full;
+        renderTrianglesSIMD(canvas, &rest);
+    }
+}
@@ -1,4 +1,5 @@
 #include "../include/triangle_simd.h"
+#include "../include/primitives.h"
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
@@ -39,7 +40,7 @@ void triangleDataSIMD_init(TriangleDataSIMD* data, int capacity) {
     data->size = (float*)aligned_malloc(alignedCapacity * sizeof(float));
     data->angle = (float*)aligned_malloc(alignedCapacity * sizeof(float));
     data->speed = (float*)aligned_malloc(alignedCapacity * sizeof(float));
-    data->color = (Color*)aligned_malloc(alignedCapacity * sizeof(Color));
+    data->color = (PackedColor*)aligned_malloc(alignedCapacity * sizeof(PackedColor));
     data->visible = (bool*)aligned_malloc(alignedCapacity * sizeof(bool));
     
     // Zero out the memory
@@ -48,7 +49,7 @@ void triangleDataSIMD_init(TriangleDataSIMD* data, int capacity) {
     memset(data->size, 0, alignedCapacity * sizeof(float));
     memset(data->angle, 0, alignedCapacity * sizeof(float));
     memset(data->speed, 0, alignedCapacity * sizeof(float));
-    memset(data->color, 0, alignedCapacity * sizeof(Color));
+    memset(data->color, 0, alignedCapacity * sizeof(PackedColor));
     memset(data->visible, 0, alignedCapacity * sizeof(bool));
 }
 
@@ -87,7 +88,7 @@ void triangleDataSIMD_fromTriangles(TriangleDataSIMD* data, const Triangle* tria
         data->size[i] = triangles[i].size;
         data->angle[i] = triangles[i].angle;
         data->speed[i] = triangles[i].speed;
-        data->color[i] = triangles[i].color;
+        data->color[i] = Canvas_PackColor(triangles[i].color);
         data->visible[i] = true; // Initially all visible
     }
     
@@ -99,7 +100,7 @@ void triangleDataSIMD_fromTriangles(TriangleDataSIMD* data, const Triangle* tria
         memset(&data->size[count], 0, remainingElements * sizeof(float));
         memset(&data->angle[count], 0, remainingElements * sizeof(float));
         memset(&data->speed[count], 0, remainingElements * sizeof(float));
-        memset(&data->color[count], 0, remainingElements * sizeof(Color));
+        memset(&data->color[count], 0, remainingElements * sizeof(PackedColor));
         memset(&data->visible[count], 0, remainingElements * sizeof(bool));
     }
     
@@ -248,7 +249,7 @@ void updateAndCullSIMD(TriangleDataSIMD* data, float dt, int canvasWidth, int ca
 // drawLine is now included from triangle.h
 
 // Helper function to calculate vertices for a single triangle
-static void calcTriangleVertices(float cx, float cy, float size, float angle, int vx[3], int vy[3]) {
+void calcTriangleVertices(float cx, float cy, float size, float angle, int vx[3], int vy[3]) {
     // Local base-triangle pointing up
     float bx[3] = { 0, size, -size };
     float by[3] = { -size, size, size };
@@ -263,31 +264,22 @@ static void calcTriangleVertices(float cx, float cy, float size, float angle, in
     }
 }
 
-// Render all visible triangles using SIMD processing
-void renderTrianglesSIMD(Canvas* canvas, TriangleDataSIMD* data) {
-    for (int i = 0; i < data->count; i++) {
-        if (data->visible[i]) {
-            int vx[3], vy[3];
-            calcTriangleVertices(data->cx[i], data->cy[i], data->size[i], data->angle[i], vx, vy);
-            
-            // Draw the three edges
-            drawLine(canvas, vx[0], vy[0], vx[1], vy[1], data->color[i]);
-            drawLine(canvas, vx[1], vy[1], vx[2], vy[2], data->color[i]);
-            drawLine(canvas, vx[2], vy[2], vx[0], vy[0], data->color[i]);
-        }
-    }
-}
-
 #if defined(__AVX2__)
-// AVX2 implementation of batch triangle rendering
-void drawTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy, 
-                          const float* size, const float* angle, const Color* color,
-                          int batchSize) {
-    // Ensure batchSize <= 8
-    if (batchSize > 8) batchSize = 8;
-    
-    // For simplicity, we're calculating vertices with SIMD but still drawing with scalar code
-    // A full implementation would vectorize the line drawing as well
+// AVX2 vertex transform for up to 8 triangles, one per lane
+static void calcTriangleVerticesBatch(const float* cx, const float* cy,
+                                      const float* size, const float* angle, int batchSize,
+                                      float scale,
+                                      int vx[3][SIMD_LANES], int vy[3][SIMD_LANES]) {
+    // Pad partial batches so the vector loads never read past the caller's arrays
+    float cx_pad[8] = {0}, cy_pad[8] = {0}, size_pad[8] = {0};
+    if (batchSize < 8) {
+        memcpy(cx_pad, cx, batchSize * sizeof(float));
+        memcpy(cy_pad, cy, batchSize * sizeof(float));
+        memcpy(size_pad, size, batchSize * sizeof(float));
+        cx = cx_pad;
+        cy = cy_pad;
+        size = size_pad;
+    }
     
     // Base triangle template (common for all triangles)
     __m256 base_x0 = _mm256_set1_ps(0.0f);
@@ -297,15 +289,16 @@ void drawTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy,
     __m256 base_y1 = _mm256_set1_ps(1.0f);
     __m256 base_y2 = _mm256_set1_ps(1.0f);
     
-    // Load 8 positions, sizes and angles
-    __m256 cx_vec = _mm256_loadu_ps(cx);
-    __m256 cy_vec = _mm256_loadu_ps(cy);
-    __m256 size_vec = _mm256_loadu_ps(size);
+    // Load 8 positions and sizes, scaled to the render resolution
+    __m256 scale_vec = _mm256_set1_ps(scale);
+    __m256 cx_vec = _mm256_mul_ps(_mm256_loadu_ps(cx), scale_vec);
+    __m256 cy_vec = _mm256_mul_ps(_mm256_loadu_ps(cy), scale_vec);
+    __m256 size_vec = _mm256_mul_ps(_mm256_loadu_ps(size), scale_vec);
     
     // Calculate sin/cos for each angle
     // Note: In a production system, you'd use a fast SIMD sin/cos approximation
     // Here we'll compute them separately for simplicity
-    float c_vals[8], s_vals[8];
+    float c_vals[8] = {0}, s_vals[8] = {0};
     for (int i = 0; i < batchSize; i++) {
         c_vals[i] = cosf(angle[i]);
         s_vals[i] = sinf(angle[i]);
@@ -339,30 +332,31 @@ void drawTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy,
     __m256 vx2 = _mm256_add_ps(cx_vec, rx2);
     __m256 vy2 = _mm256_add_ps(cy_vec, ry2);
     
-    // Store results
-    float vx0_arr[8], vy0_arr[8], vx1_arr[8], vy1_arr[8], vx2_arr[8], vy2_arr[8];
-    _mm256_storeu_ps(vx0_arr, vx0);
-    _mm256_storeu_ps(vy0_arr, vy0);
-    _mm256_storeu_ps(vx1_arr, vx1);
-    _mm256_storeu_ps(vy1_arr, vy1);
-    _mm256_storeu_ps(vx2_arr, vx2);
-    _mm256_storeu_ps(vy2_arr, vy2);
-    
-    // Draw all triangles using the calculated vertices
-    for (int i = 0; i < batchSize; i++) {
-        drawLine(canvas, (int)vx0_arr[i], (int)vy0_arr[i], (int)vx1_arr[i], (int)vy1_arr[i], color[i]);
-        drawLine(canvas, (int)vx1_arr[i], (int)vy1_arr[i], (int)vx2_arr[i], (int)vy2_arr[i], color[i]);
-        drawLine(canvas, (int)vx2_arr[i], (int)vy2_arr[i], (int)vx0_arr[i], (int)vy0_arr[i], color[i]);
-    }
+    // Truncate to integer pixel coordinates and store results
+    _mm256_storeu_si256((__m256i*)vx[0], _mm256_cvttps_epi32(vx0));
+    _mm256_storeu_si256((__m256i*)vy[0], _mm256_cvttps_epi32(vy0));
+    _mm256_storeu_si256((__m256i*)vx[1], _mm256_cvttps_epi32(vx1));
+    _mm256_storeu_si256((__m256i*)vy[1], _mm256_cvttps_epi32(vy1));
+    _mm256_storeu_si256((__m256i*)vx[2], _mm256_cvttps_epi32(vx2));
+    _mm256_storeu_si256((__m256i*)vy[2], _mm256_cvttps_epi32(vy2));
 }
 
 #elif defined(__SSE2__)
-// SSE2 implementation of batch triangle rendering
-void drawTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy, 
-                          const float* size, const float* angle, const Color* color,
-                          int batchSize) {
-    // Ensure batchSize <= 4
-    if (batchSize > 4) batchSize = 4;
+// SSE2 vertex transform for up to 4 triangles, one per lane
+static void calcTriangleVerticesBatch(const float* cx, const float* cy,
+                                      const float* size, const float* angle, int batchSize,
+                                      float scale,
+                                      int vx[3][SIMD_LANES], int vy[3][SIMD_LANES]) {
+    // Pad partial batches so the vector loads never read past the caller's arrays
+    float cx_pad[4] = {0}, cy_pad[4] = {0}, size_pad[4] = {0};
+    if (batchSize < 4) {
+        memcpy(cx_pad, cx, batchSize * sizeof(float));
+        memcpy(cy_pad, cy, batchSize * sizeof(float));
+        memcpy(size_pad, size, batchSize * sizeof(float));
+        cx = cx_pad;
+        cy = cy_pad;
+        size = size_pad;
+    }
     
     // Base triangle template (common for all triangles)
     __m128 base_x0 = _mm_set1_ps(0.0f);
@@ -372,13 +366,14 @@ void drawTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy,
     __m128 base_y1 = _mm_set1_ps(1.0f);
     __m128 base_y2 = _mm_set1_ps(1.0f);
     
-    // Load 4 positions, sizes and angles
-    __m128 cx_vec = _mm_loadu_ps(cx);
-    __m128 cy_vec = _mm_loadu_ps(cy);
-    __m128 size_vec = _mm_loadu_ps(size);
+    // Load 4 positions and sizes, scaled to the render resolution
+    __m128 scale_vec = _mm_set1_ps(scale);
+    __m128 cx_vec = _mm_mul_ps(_mm_loadu_ps(cx), scale_vec);
+    __m128 cy_vec = _mm_mul_ps(_mm_loadu_ps(cy), scale_vec);
+    __m128 size_vec = _mm_mul_ps(_mm_loadu_ps(size), scale_vec);
     
     // Calculate sin/cos for each angle
-    float c_vals[4], s_vals[4];
+    float c_vals[4] = {0}, s_vals[4] = {0};
     for (int i = 0; i < batchSize; i++) {
         c_vals[i] = cosf(angle[i]);
         s_vals[i] = sinf(angle[i]);
@@ -412,35 +407,806 @@ void drawTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy,
     __m128 vx2 = _mm_add_ps(cx_vec, rx2);
     __m128 vy2 = _mm_add_ps(cy_vec, ry2);
     
-    // Store results
-    float vx0_arr[4], vy0_arr[4], vx1_arr[4], vy1_arr[4], vx2_arr[4], vy2_arr[4];
-    _mm_storeu_ps(vx0_arr, vx0);
-    _mm_storeu_ps(vy0_arr, vy0);
-    _mm_storeu_ps(vx1_arr, vx1);
-    _mm_storeu_ps(vy1_arr, vy1);
-    _mm_storeu_ps(vx2_arr, vx2);
-    _mm_storeu_ps(vy2_arr, vy2);
-    
-    // Draw all triangles using the calculated vertices
+    // Truncate to integer pixel coordinates and store results
+    _mm_storeu_si128((__m128i*)vx[0], _mm_cvttps_epi32(vx0));
+    _mm_storeu_si128((__m128i*)vy[0], _mm_cvttps_epi32(vy0));
+    _mm_storeu_si128((__m128i*)vx[1], _mm_cvttps_epi32(vx1));
+    _mm_storeu_si128((__m128i*)vy[1], _mm_cvttps_epi32(vy1));
+    _mm_storeu_si128((__m128i*)vx[2], _mm_cvttps_epi32(vx2));
+    _mm_storeu_si128((__m128i*)vy[2], _mm_cvttps_epi32(vy2));
+}
+#endif
+
+// Draw count lines given in screen space as x0,y0,x1,y1 quadruples, one by
+// one, with one dirty rectangle for the whole set
+void drawLinesBatchSIMD(Canvas* canvas, const int* lines, const PackedColor* pixel, int count) {
+    if (count <= 0) return;
+    int minX = lines[0], maxX = lines[0], minY = lines[1], maxY = lines[1];
+    for (int i = 0; i < count * 4; i += 2) {
+        if (lines[i] < minX) minX = lines[i];
+        if (lines[i] > maxX) maxX = lines[i];
+        if (lines[i + 1] < minY) minY = lines[i + 1];
+        if (lines[i + 1] > maxY) maxY = lines[i + 1];
+    }
+    Canvas_MarkDirty(canvas, minX, minY, maxX + 1, maxY + 1);
+
+    ClipRect full = { 0, 0, canvas->bufferWidth, canvas->bufferHeight };
+    for (int i = 0; i < count; i++) {
+        const int* l = &lines[i * 4];
+        drawLineScreen(canvas, l[0], l[1], l[2], l[3], pixel[i], &full);
+    }
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// Draw the outlines of a transformed vertex batch. The edges take the scalar
+// drawLineScreen walk: a lockstep kernel stepping one line per lane measured
+// slower on these short edges (see bench/line_bench.c), since every lane
+// still writes its pixel with a scalar store.
+static void drawTriangleEdgesBatch(Canvas* canvas, int vx[3][SIMD_LANES], int vy[3][SIMD_LANES],
+                                   const PackedColor* color, int batchSize) {
+    int halfW = canvas->bufferWidth / 2;
+    int halfH = canvas->bufferHeight / 2;
+    ClipRect full = { 0, 0, canvas->bufferWidth, canvas->bufferHeight };
     for (int i = 0; i < batchSize; i++) {
-        drawLine(canvas, (int)vx0_arr[i], (int)vy0_arr[i], (int)vx1_arr[i], (int)vy1_arr[i], color[i]);
-        drawLine(canvas, (int)vx1_arr[i], (int)vy1_arr[i], (int)vx2_arr[i], (int)vy2_arr[i], color[i]);
-        drawLine(canvas, (int)vx2_arr[i], (int)vy2_arr[i], (int)vx0_arr[i], (int)vy0_arr[i], color[i]);
+        int x0 = halfW + vx[0][i], y0 = halfH - vy[0][i];
+        int x1 = halfW + vx[1][i], y1 = halfH - vy[1][i];
+        int x2 = halfW + vx[2][i], y2 = halfH - vy[2][i];
+        int minX = x0 < x1 ? x0 : x1, maxX = x0 < x1 ? x1 : x0;
+        int minY = y0 < y1 ? y0 : y1, maxY = y0 < y1 ? y1 : y0;
+        if (x2 < minX) minX = x2;
+        if (x2 > maxX) maxX = x2;
+        if (y2 < minY) minY = y2;
+        if (y2 > maxY) maxY = y2;
+        Canvas_MarkDirty(canvas, minX, minY, maxX + 1, maxY + 1);
+        
+        drawLineScreen(canvas, x0, y0, x1, y1, color[i], &full);
+        drawLineScreen(canvas, x1, y1, x2, y2, color[i], &full);
+        drawLineScreen(canvas, x2, y2, x0, y0, color[i], &full);
+    }
+}
+
+// Batch triangle rendering: vertices are computed with SIMD, edges are drawn
+// by the scalar line walk
+void drawTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy, 
+                          const float* size, const float* angle, const PackedColor* color,
+                          int batchSize) {
+    // Ensure batchSize <= SIMD_LANES
+    if (batchSize > SIMD_LANES) batchSize = SIMD_LANES;
+    
+    int vx[3][SIMD_LANES], vy[3][SIMD_LANES];
+    calcTriangleVerticesBatch(cx, cy, size, angle, batchSize, canvas->renderScale, vx, vy);
+    drawTriangleEdgesBatch(canvas, vx, vy, color, batchSize);
+}
+
+// Triangles gathered into a vertex batch
+typedef struct {
+    float cx[SIMD_LANES], cy[SIMD_LANES], size[SIMD_LANES], angle[SIMD_LANES];
+    PackedColor color[SIMD_LANES];
+    int batchSize;
+} TriangleQueue;
+
+// Transform and draw the pending batch
+static void flushTriangleQueue(Canvas* canvas, TriangleQueue* q) {
+    if (q->batchSize > 0) {
+        drawTrianglesBatchSIMD(canvas, q->cx, q->cy, q->size, q->angle, q->color, q->batchSize);
+        q->batchSize = 0;
+    }
+}
+
+static inline void queueTriangle(Canvas* canvas, TriangleQueue* q, float cx, float cy, float size,
+                                 float angle, PackedColor color) {
+    q->cx[q->batchSize] = cx;
+    q->cy[q->batchSize] = cy;
+    q->size[q->batchSize] = size;
+    q->angle[q->batchSize] = angle;
+    q->color[q->batchSize] = color;
+    if (++q->batchSize == SIMD_LANES) flushTriangleQueue(canvas, q);
+}
+
+// Render all visible triangles using SIMD processing. Visible triangles are
+// gathered into full vertex batches, so every transform fills all lanes.
+void renderTrianglesSIMD(Canvas* canvas, TriangleDataSIMD* data) {
+    TriangleQueue queue;
+    queue.batchSize = 0;
+    for (int i = 0; i < data->count; i++) {
+        if (data->visible[i]) {
+            queueTriangle(canvas, &queue, data->cx[i], data->cy[i], data->size[i], data->angle[i],
+                          data->color[i]);
+        }
+    }
+    flushTriangleQueue(canvas, &queue);
+}
+
+// Strided views take the renderTrianglesSIMD pipeline: each group of
+// SIMD_LANES elements is loaded (gathered on AVX2) and culled against the
+// canvas at once, and the survivors are queued for the vertex transform.
+void drawTriangles(Canvas* canvas, const TriangleView* view) {
+    const size_t stride = view->stride;
+    const size_t colorStride = view->colorStride ? view->colorStride : stride;
+    const size_t activeStride = view->activeStride ? view->activeStride : stride;
+
+    // A triangle lies within 1.5 * size of its center (sqrt(2) with margin);
+    // half the canvas in canvas units, plus two pixels for the vertex rounding
+    const float halfW = (canvas->bufferWidth * 0.5f + 2.0f) / canvas->renderScale;
+    const float halfH = (canvas->bufferHeight * 0.5f + 2.0f) / canvas->renderScale;
+#if defined(__AVX2__)
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 margin = _mm256_set1_ps(1.5f);
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i offsets = _mm256_mullo_epi32(lane, _mm256_set1_epi32((int)stride));
+#else
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 margin = _mm_set1_ps(1.5f);
+#endif
+
+    TriangleQueue queue;
+    queue.batchSize = 0;
+    for (int base = 0; base < view->count; base += SIMD_LANES) {
+        int n = view->count - base < SIMD_LANES ? view->count - base : SIMD_LANES;
+        unsigned keep = (1u << n) - 1;
+        if (view->active) {
+            for (int l = 0; l < n; l++) {
+                if (!TRIANGLE_VIEW_AT(bool, view->active, activeStride, base + l)) keep &= ~(1u << l);
+            }
+            if (!keep) continue;
+        }
+
+        // Lanes past n are never loaded (AVX2) or repeat the first element
+#if defined(__AVX2__)
+        __m256 live = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(n), lane));
+        __m256 zero = _mm256_setzero_ps();
+#define VIEW_LANES(field) _mm256_mask_i32gather_ps(zero, &TRIANGLE_VIEW_AT(float, field, stride, base), \
+                                                  offsets, live, 1)
+        __m256 cx = VIEW_LANES(view->cx);
+        __m256 cy = VIEW_LANES(view->cy);
+        __m256 size = VIEW_LANES(view->size);
+#undef VIEW_LANES
+        __m256 extent = _mm256_mul_ps(_mm256_and_ps(size, absMask), margin);
+        __m256 outside = _mm256_or_ps(
+            _mm256_cmp_ps(_mm256_sub_ps(_mm256_and_ps(cx, absMask), extent), _mm256_set1_ps(halfW), _CMP_GT_OQ),
+            _mm256_cmp_ps(_mm256_sub_ps(_mm256_and_ps(cy, absMask), extent), _mm256_set1_ps(halfH), _CMP_GT_OQ));
+        keep &= ~(unsigned)_mm256_movemask_ps(outside);
+#else
+        int i0 = base, i1 = n > 1 ? base + 1 : base, i2 = n > 2 ? base + 2 : base, i3 = n > 3 ? base + 3 : base;
+#define VIEW_LANES(field) _mm_setr_ps(TRIANGLE_VIEW_AT(float, field, stride, i0), \
+                                      TRIANGLE_VIEW_AT(float, field, stride, i1), \
+                                      TRIANGLE_VIEW_AT(float, field, stride, i2), \
+                                      TRIANGLE_VIEW_AT(float, field, stride, i3))
+        __m128 cx = VIEW_LANES(view->cx);
+        __m128 cy = VIEW_LANES(view->cy);
+        __m128 size = VIEW_LANES(view->size);
+#undef VIEW_LANES
+        __m128 extent = _mm_mul_ps(_mm_and_ps(size, absMask), margin);
+        __m128 outside = _mm_or_ps(
+            _mm_cmpgt_ps(_mm_sub_ps(_mm_and_ps(cx, absMask), extent), _mm_set1_ps(halfW)),
+            _mm_cmpgt_ps(_mm_sub_ps(_mm_and_ps(cy, absMask), extent), _mm_set1_ps(halfH)));
+        keep &= ~(unsigned)_mm_movemask_ps(outside);
+#endif
+
+        for (; keep; keep &= keep - 1) {
+            int i = base + __builtin_ctz(keep);
+            queueTriangle(canvas, &queue,
+                          TRIANGLE_VIEW_AT(float, view->cx, stride, i),
+                          TRIANGLE_VIEW_AT(float, view->cy, stride, i),
+                          TRIANGLE_VIEW_AT(float, view->size, stride, i),
+                          TRIANGLE_VIEW_AT(float, view->angle, stride, i),
+                          TRIANGLE_VIEW_AT(PackedColor, view->color, colorStride, i));
+        }
     }
+    flushTriangleQueue(canvas, &queue);
 }
 
 #else
 // Scalar fallback implementation
 void drawTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy, 
-                          const float* size, const float* angle, const Color* color,
+                          const float* size, const float* angle, const PackedColor* color,
                           int batchSize) {
     for (int i = 0; i < batchSize; i++) {
+        drawTrianglePacked(canvas, cx[i], cy[i], size[i], angle[i], color[i]);
+    }
+}
+
+// Render all visible triangles one by one
+void renderTrianglesSIMD(Canvas* canvas, TriangleDataSIMD* data) {
+    for (int i = 0; i < data->count; i++) {
+        if (data->visible[i]) {
+            drawTrianglePacked(canvas, data->cx[i], data->cy[i], data->size[i], data->angle[i],
+                               data->color[i]);
+        }
+    }
+}
+
+// Cull and draw the active triangles of a view one by one
+void drawTriangles(Canvas* canvas, const TriangleView* view) {
+    const size_t stride = view->stride;
+    const size_t colorStride = view->colorStride ? view->colorStride : stride;
+    const size_t activeStride = view->activeStride ? view->activeStride : stride;
+    const float halfW = (canvas->bufferWidth * 0.5f + 2.0f) / canvas->renderScale;
+    const float halfH = (canvas->bufferHeight * 0.5f + 2.0f) / canvas->renderScale;
+    for (int i = 0; i < view->count; i++) {
+        if (view->active && !TRIANGLE_VIEW_AT(bool, view->active, activeStride, i)) continue;
+        float cx = TRIANGLE_VIEW_AT(float, view->cx, stride, i);
+        float cy = TRIANGLE_VIEW_AT(float, view->cy, stride, i);
+        float size = TRIANGLE_VIEW_AT(float, view->size, stride, i);
+        float extent = fabsf(size) * 1.5f;
+        if (fabsf(cx) - extent > halfW || fabsf(cy) - extent > halfH) continue;
+        drawTrianglePacked(canvas, cx, cy, size, TRIANGLE_VIEW_AT(float, view->angle, stride, i),
+                           TRIANGLE_VIEW_AT(PackedColor, view->color, colorStride, i));
+    }
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Filled triangles
+//
+// Pixels are sampled at their integer coordinates and tested against the
+// three half-space edge functions E(x, y) = (bx-ax)*(y-ay) - (by-ay)*(x-ax).
+// Stepping one pixel right adds a constant, so a row is evaluated 4 (SSE2) or
+// 8 (AVX2) pixels at a time by adding a per-lane offset vector. A top-left
+// fill rule keeps shared edges from being drawn twice.
+// ---------------------------------------------------------------------------
+
+// Within this distance of the origin the edge functions cannot overflow
+// 32-bit integers: edge deltas stay within 2^15 and, over a buffer below
+// 16384 pixels a side, so do the distances from a pixel to a vertex, hence
+// |E| < 2 * 2^15 * 2^15 = 2^31. Triangles with a vertex further out (a huge
+// one spanning the canvas, say) take the wide path below instead.
+#define FILL_GUARD_BAND 16384
+
+static bool outsideGuardBand(int x0, int y0, int x1, int y1, int x2, int y2) {
+    return abs(x0) > FILL_GUARD_BAND || abs(y0) > FILL_GUARD_BAND ||
+           abs(x1) > FILL_GUARD_BAND || abs(y1) > FILL_GUARD_BAND ||
+           abs(x2) > FILL_GUARD_BAND || abs(y2) > FILL_GUARD_BAND;
+}
+
+// Edge functions of a triangle beyond the guard band, in 128-bit integers
+// (deltas reach 2^32, so their products need more than 64 bits). Rows are
+// not stepped: each row's span is solved from them exactly, so the pixels
+// are the ones 32-bit stepping would give if it could not overflow.
+typedef struct {
+    int minX, minY, maxX, maxY;
+    long long A[3];
+    long long B[3];
+    __int128 C[3];  // E = A*x + B*y + C, top-left rule bias included
+} WideTriangleEdges;
+
+static bool setupWideTriangleEdges(const Canvas* canvas, int x0, int y0, int x1, int y1, int x2, int y2,
+                                   WideTriangleEdges* edges) {
+    __int128 area = (__int128)((long long)x1 - x0) * ((long long)y2 - y0) -
+                    (__int128)((long long)y1 - y0) * ((long long)x2 - x0);
+    if (area == 0) return false;
+    if (area < 0) {
+        int tx = x1, ty = y1;
+        x1 = x2; y1 = y2;
+        x2 = tx; y2 = ty;
+    }
+    
+    int minX = x0 < x1 ? (x0 < x2 ? x0 : x2) : (x1 < x2 ? x1 : x2);
+    int maxX = x0 > x1 ? (x0 > x2 ? x0 : x2) : (x1 > x2 ? x1 : x2);
+    int minY = y0 < y1 ? (y0 < y2 ? y0 : y2) : (y1 < y2 ? y1 : y2);
+    int maxY = y0 > y1 ? (y0 > y2 ? y0 : y2) : (y1 > y2 ? y1 : y2);
+    if (minX < 0) minX = 0;
+    if (minY < 0) minY = 0;
+    if (maxX > canvas->bufferWidth - 1) maxX = canvas->bufferWidth - 1;
+    if (maxY > canvas->bufferHeight - 1) maxY = canvas->bufferHeight - 1;
+    if (minX > maxX || minY > maxY) return false;
+    
+    // Same edges and top-left rule as setupTriangleEdges
+    int ax[3] = { x1, x2, x0 }, ay[3] = { y1, y2, y0 };
+    int bx[3] = { x2, x0, x1 }, by[3] = { y2, y0, y1 };
+    for (int e = 0; e < 3; e++) {
+        long long dx = (long long)bx[e] - ax[e];
+        long long dy = (long long)by[e] - ay[e];
+        bool topLeft = (dy < 0) || (dy == 0 && dx > 0);
+        edges->A[e] = -dy;
+        edges->B[e] = dx;
+        edges->C[e] = (__int128)dy * ax[e] - (__int128)dx * ay[e] + (topLeft ? 0 : -1);
+    }
+    edges->minX = minX;
+    edges->minY = minY;
+    edges->maxX = maxX;
+    edges->maxY = maxY;
+    return true;
+}
+
+// floor(n / d) for d > 0
+static __int128 floorDiv128(__int128 n, long long d) {
+    __int128 q = n / d;
+    return (n % d != 0 && n < 0) ? q - 1 : q;
+}
+
+// Pixels [*left, *right] of row y inside the triangle; false when none are
+static bool wideTriangleRow(const WideTriangleEdges* edges, int y, int* left, int* right) {
+    __int128 lo = edges->minX, hi = edges->maxX;
+    for (int e = 0; e < 3; e++) {
+        // A*x + k >= 0 bounds x from one side, or holds for every x or none
+        __int128 k = (__int128)edges->B[e] * y + edges->C[e];
+        long long a = edges->A[e];
+        if (a > 0) {
+            __int128 from = -floorDiv128(k, a);
+            if (from > lo) lo = from;
+        } else if (a < 0) {
+            __int128 to = floorDiv128(k, -a);
+            if (to < hi) hi = to;
+        } else if (k < 0) {
+            return false;
+        }
+    }
+    if (lo > hi) return false;
+    *left = (int)lo;
+    *right = (int)hi;
+    return true;
+}
+
+static void fillWideTriangleScreen(Canvas* canvas, int x0, int y0, int x1, int y1, int x2, int y2,
+                                   uint32_t pixel) {
+    WideTriangleEdges edges;
+    if (!setupWideTriangleEdges(canvas, x0, y0, x1, y1, x2, y2, &edges)) return;
+    for (int y = edges.minY; y <= edges.maxY; y++) {
+        int left, right;
+        if (wideTriangleRow(&edges, y, &left, &right)) {
+            fillRow(canvas->backBuffer + (size_t)y * canvas->pitch + left, right - left + 1, pixel);
+        }
+    }
+}
+
+// Half-space setup of a triangle in screen space: its bounding box clipped
+// to the canvas and the edge functions at the box's top-left pixel
+typedef struct {
+    int minX, minY, maxX, maxY;
+    int A[3];         // step per pixel in x
+    int B[3];         // step per row
+    int rowStart[3];  // values at (minX, minY), top-left rule bias included
+} TriangleEdges;
+
+// Set up the edges of a triangle within the guard band; false when it has
+// no pixels on the canvas. minX is rounded down to a multiple of alignX (a
+// power of two).
+static bool setupTriangleEdges(const Canvas* canvas, int x0, int y0, int x1, int y1, int x2, int y2,
+                               int alignX, TriangleEdges* edges) {
+    // Make the winding consistent so that inside means all edge functions >= 0
+    int64_t area = (int64_t)(x1 - x0) * (y2 - y0) - (int64_t)(y1 - y0) * (x2 - x0);
+    if (area == 0) return false;
+    if (area < 0) {
+        int tx = x1, ty = y1;
+        x1 = x2; y1 = y2;
+        x2 = tx; y2 = ty;
+    }
+    
+    // Bounding box clipped to the canvas
+    int minX = x0 < x1 ? (x0 < x2 ? x0 : x2) : (x1 < x2 ? x1 : x2);
+    int maxX = x0 > x1 ? (x0 > x2 ? x0 : x2) : (x1 > x2 ? x1 : x2);
+    int minY = y0 < y1 ? (y0 < y2 ? y0 : y2) : (y1 < y2 ? y1 : y2);
+    int maxY = y0 > y1 ? (y0 > y2 ? y0 : y2) : (y1 > y2 ? y1 : y2);
+    if (minX < 0) minX = 0;
+    if (minY < 0) minY = 0;
+    if (maxX > canvas->bufferWidth - 1) maxX = canvas->bufferWidth - 1;
+    if (maxY > canvas->bufferHeight - 1) maxY = canvas->bufferHeight - 1;
+    if (minX > maxX || minY > maxY) return false;
+    minX &= ~(alignX - 1);
+    
+    // Edge equations for v1->v2, v2->v0 and v0->v1: E = A*x + B*y + C
+    int ax[3] = { x1, x2, x0 }, ay[3] = { y1, y2, y0 };
+    int bx[3] = { x2, x0, x1 }, by[3] = { y2, y0, y1 };
+    for (int e = 0; e < 3; e++) {
+        int dx = bx[e] - ax[e];
+        int dy = by[e] - ay[e];
+        edges->A[e] = -dy;
+        edges->B[e] = dx;
+        
+        // Top-left rule: pixels exactly on a right or bottom edge are left out
+        bool topLeft = (dy < 0) || (dy == 0 && dx > 0);
+        int bias = topLeft ? 0 : -1;
+        edges->rowStart[e] = dx * (minY - ay[e]) - dy * (minX - ax[e]) + bias;
+    }
+    edges->minX = minX;
+    edges->minY = minY;
+    edges->maxX = maxX;
+    edges->maxY = maxY;
+    return true;
+}
+
+// Fill a triangle given in screen space (top-left origin, y down)
+static void fillTriangleScreen(Canvas* canvas, int x0, int y0, int x1, int y1, int x2, int y2,
+                               uint32_t pixel) {
+    if (outsideGuardBand(x0, y0, x1, y1, x2, y2)) {
+        fillWideTriangleScreen(canvas, x0, y0, x1, y1, x2, y2, pixel);
+        return;
+    }
+    TriangleEdges edges;
+    if (!setupTriangleEdges(canvas, x0, y0, x1, y1, x2, y2, 1, &edges)) return;
+    int minX = edges.minX, minY = edges.minY, maxX = edges.maxX, maxY = edges.maxY;
+    const int* A = edges.A;
+    const int* B = edges.B;
+    int* rowStart = edges.rowStart;
+    
+#if defined(__AVX2__)
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i stepA0 = _mm256_set1_epi32(A[0] * 8);
+    __m256i stepA1 = _mm256_set1_epi32(A[1] * 8);
+    __m256i stepA2 = _mm256_set1_epi32(A[2] * 8);
+    __m256i offA0 = _mm256_mullo_epi32(lane, _mm256_set1_epi32(A[0]));
+    __m256i offA1 = _mm256_mullo_epi32(lane, _mm256_set1_epi32(A[1]));
+    __m256i offA2 = _mm256_mullo_epi32(lane, _mm256_set1_epi32(A[2]));
+    __m256i pixel_vec = _mm256_set1_epi32((int)pixel);
+#elif defined(__SSE2__)
+    __m128i stepA0 = _mm_set1_epi32(A[0] * 4);
+    __m128i stepA1 = _mm_set1_epi32(A[1] * 4);
+    __m128i stepA2 = _mm_set1_epi32(A[2] * 4);
+    __m128i offA0 = _mm_setr_epi32(0, A[0], A[0] * 2, A[0] * 3);
+    __m128i offA1 = _mm_setr_epi32(0, A[1], A[1] * 2, A[1] * 3);
+    __m128i offA2 = _mm_setr_epi32(0, A[2], A[2] * 2, A[2] * 3);
+    __m128i pixel_vec = _mm_set1_epi32((int)pixel);
+#endif
+    
+    for (int y = minY; y <= maxY; y++) {
+        uint32_t* row = canvas->backBuffer + (size_t)y * canvas->pitch;
+        int w0 = rowStart[0], w1 = rowStart[1], w2 = rowStart[2];
+        int x = minX;
+        bool entered = false;
+        
+#if defined(__AVX2__)
+        __m256i e0 = _mm256_add_epi32(_mm256_set1_epi32(w0), offA0);
+        __m256i e1 = _mm256_add_epi32(_mm256_set1_epi32(w1), offA1);
+        __m256i e2 = _mm256_add_epi32(_mm256_set1_epi32(w2), offA2);
+        for (; x + 7 <= maxX; x += 8) {
+            // A pixel is inside when no edge function is negative
+            __m256i outside = _mm256_srai_epi32(_mm256_or_si256(_mm256_or_si256(e0, e1), e2), 31);
+            int outsideBits = _mm256_movemask_ps(_mm256_castsi256_ps(outside));
+            if (outsideBits != 0xFF) {
+                __m256i inside = _mm256_xor_si256(outside, _mm256_set1_epi32(-1));
+                _mm256_maskstore_epi32((int*)(row + x), inside, pixel_vec);
+                entered = true;
+            } else if (entered) {
+                break; // the inside of a convex shape is one span per row
+            }
+            e0 = _mm256_add_epi32(e0, stepA0);
+            e1 = _mm256_add_epi32(e1, stepA1);
+            e2 = _mm256_add_epi32(e2, stepA2);
+        }
+        w0 += A[0] * (x - minX);
+        w1 += A[1] * (x - minX);
+        w2 += A[2] * (x - minX);
+#elif defined(__SSE2__)
+        __m128i e0 = _mm_add_epi32(_mm_set1_epi32(w0), offA0);
+        __m128i e1 = _mm_add_epi32(_mm_set1_epi32(w1), offA1);
+        __m128i e2 = _mm_add_epi32(_mm_set1_epi32(w2), offA2);
+        for (; x + 3 <= maxX; x += 4) {
+            // A pixel is inside when no edge function is negative
+            __m128i outside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(e0, e1), e2), 31);
+            int outsideBits = _mm_movemask_ps(_mm_castsi128_ps(outside));
+            if (outsideBits == 0) {
+                _mm_storeu_si128((__m128i*)(row + x), pixel_vec);
+                entered = true;
+            } else if (outsideBits != 0xF) {
+                // SSE2 has no masked store: blend with the existing pixels
+                __m128i dst = _mm_loadu_si128((const __m128i*)(row + x));
+                dst = _mm_or_si128(_mm_and_si128(outside, dst), _mm_andnot_si128(outside, pixel_vec));
+                _mm_storeu_si128((__m128i*)(row + x), dst);
+                entered = true;
+            } else if (entered) {
+                break; // the inside of a convex shape is one span per row
+            }
+            e0 = _mm_add_epi32(e0, stepA0);
+            e1 = _mm_add_epi32(e1, stepA1);
+            e2 = _mm_add_epi32(e2, stepA2);
+        }
+        w0 += A[0] * (x - minX);
+        w1 += A[1] * (x - minX);
+        w2 += A[2] * (x - minX);
+#endif
+        
+        // Remaining pixels of the row (all of them in scalar builds)
+        for (; x <= maxX; x++) {
+            if ((w0 | w1 | w2) >= 0) {
+                row[x] = pixel;
+                entered = true;
+            } else if (entered) {
+                break;
+            }
+            w0 += A[0];
+            w1 += A[1];
+            w2 += A[2];
+        }
+        
+        rowStart[0] += B[0];
+        rowStart[1] += B[1];
+        rowStart[2] += B[2];
+    }
+}
+
+// Convert canvas (center-origin) vertices to screen space and fill
+static void fillTriangleVertices(Canvas* canvas, const int vx[3], const int vy[3], PackedColor color) {
+    int halfW = canvas->bufferWidth / 2;
+    int halfH = canvas->bufferHeight / 2;
+    int minX = vx[0], maxX = vx[0], minY = vy[0], maxY = vy[0];
+    for (int i = 1; i < 3; i++) {
+        if (vx[i] < minX) minX = vx[i];
+        if (vx[i] > maxX) maxX = vx[i];
+        if (vy[i] < minY) minY = vy[i];
+        if (vy[i] > maxY) maxY = vy[i];
+    }
+    Canvas_MarkDirty(canvas, halfW + minX, halfH - maxY, halfW + maxX + 1, halfH - minY + 1);
+    fillTriangleScreen(canvas,
+                       halfW + vx[0], halfH - vy[0],
+                       halfW + vx[1], halfH - vy[1],
+                       halfW + vx[2], halfH - vy[2],
+                       color);
+}
+
+void fillTriangleSIMD(Canvas* canvas, const Triangle* t) {
+    float s = canvas->renderScale;
+    int vx[3], vy[3];
+    calcTriangleVertices(t->cx * s, t->cy * s, t->size * s, t->angle, vx, vy);
+    fillTriangleVertices(canvas, vx, vy, Canvas_PackColor(t->color));
+}
+
+void fillTrianglesBatchSIMD(Canvas* canvas, const float* cx, const float* cy,
+                            const float* size, const float* angle, const PackedColor* color,
+                            int count) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    int vx[3][SIMD_LANES], vy[3][SIMD_LANES];
+    for (int base = 0; base < count; base += SIMD_LANES) {
+        int batchSize = count - base < SIMD_LANES ? count - base : SIMD_LANES;
+        calcTriangleVerticesBatch(cx + base, cy + base, size + base, angle + base, batchSize,
+                                  canvas->renderScale, vx, vy);
+        for (int i = 0; i < batchSize; i++) {
+            int tvx[3] = { vx[0][i], vx[1][i], vx[2][i] };
+            int tvy[3] = { vy[0][i], vy[1][i], vy[2][i] };
+            fillTriangleVertices(canvas, tvx, tvy, color[base + i]);
+        }
+    }
+#else
+    float s = canvas->renderScale;
+    for (int i = 0; i < count; i++) {
         int vx[3], vy[3];
-        calcTriangleVertices(cx[i], cy[i], size[i], angle[i], vx, vy);
+        calcTriangleVertices(cx[i] * s, cy[i] * s, size[i] * s, angle[i], vx, vy);
+        fillTriangleVertices(canvas, vx, vy, color[i]);
+    }
+#endif
+}
+
+void renderFilledTrianglesSIMD(Canvas* canvas, TriangleDataSIMD* data) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    int vx[3][SIMD_LANES], vy[3][SIMD_LANES];
+    for (int base = 0; base < data->count; base += SIMD_LANES) {
+        int batchSize = data->count - base < SIMD_LANES ? data->count - base : SIMD_LANES;
+        
+        // Skip groups that were culled entirely
+        bool anyVisible = false;
+        for (int i = 0; i < batchSize; i++) anyVisible |= data->visible[base + i];
+        if (!anyVisible) continue;
+        
+        calcTriangleVerticesBatch(&data->cx[base], &data->cy[base], &data->size[base],
+                                  &data->angle[base], batchSize, canvas->renderScale, vx, vy);
+        for (int i = 0; i < batchSize; i++) {
+            if (!data->visible[base + i]) continue;
+            int tvx[3] = { vx[0][i], vx[1][i], vx[2][i] };
+            int tvy[3] = { vy[0][i], vy[1][i], vy[2][i] };
+            fillTriangleVertices(canvas, tvx, tvy, data->color[base + i]);
+        }
+    }
+#else
+    float s = canvas->renderScale;
+    for (int i = 0; i < data->count; i++) {
+        if (data->visible[i]) {
+            int vx[3], vy[3];
+            calcTriangleVertices(data->cx[i] * s, data->cy[i] * s, data->size[i] * s,
+                                 data->angle[i], vx, vy);
+            fillTriangleVertices(canvas, vx, vy, data->color[i]);
+        }
+    }
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Front-to-back filled triangles
+//
+// Rows are walked in steps of one coverage block row (8 pixels, from an x
+// aligned to 8): only pixels whose coverage bit is clear are written, and
+// every pixel inside the triangle sets its bit. Drawing nearest first this
+// way gives the image painter's order gives, without the overdraw.
+// ---------------------------------------------------------------------------
+
+// Wide path of fillTriangleScreenCovered: each row's span split into
+// coverage blocks
+static void fillWideTriangleScreenCovered(Canvas* canvas, CoverageBuffer* coverage,
+                                          int x0, int y0, int x1, int y1, int x2, int y2, uint32_t pixel) {
+    WideTriangleEdges edges;
+    if (!setupWideTriangleEdges(canvas, x0, y0, x1, y1, x2, y2, &edges)) return;
+    for (int y = edges.minY; y <= edges.maxY; y++) {
+        int left, right;
+        if (!wideTriangleRow(&edges, y, &left, &right)) continue;
+        uint32_t* row = canvas->backBuffer + (size_t)y * canvas->pitch;
+        for (int bx = left / COVERAGE_BLOCK_SIZE; bx <= right / COVERAGE_BLOCK_SIZE; bx++) {
+            int first = bx * COVERAGE_BLOCK_SIZE;
+            int from = left > first ? left - first : 0;
+            int to = right < first + COVERAGE_BLOCK_SIZE - 1 ? right - first : COVERAGE_BLOCK_SIZE - 1;
+            unsigned inside = ((2u << to) - 1) & ~((1u << from) - 1);
+            unsigned write = inside & ~coverage_row(coverage, bx, y);
+            for (; write; write &= write - 1) row[first + __builtin_ctz(write)] = pixel;
+            coverage_addRow(coverage, bx, y, inside);
+        }
+    }
+}
+
+// Fill a screen-space triangle into the pixels coverage leaves uncovered
+static void fillTriangleScreenCovered(Canvas* canvas, CoverageBuffer* coverage,
+                                      int x0, int y0, int x1, int y1, int x2, int y2, uint32_t pixel) {
+    if (outsideGuardBand(x0, y0, x1, y1, x2, y2)) {
+        fillWideTriangleScreenCovered(canvas, coverage, x0, y0, x1, y1, x2, y2, pixel);
+        return;
+    }
+    TriangleEdges edges;
+    if (!setupTriangleEdges(canvas, x0, y0, x1, y1, x2, y2, COVERAGE_BLOCK_SIZE, &edges)) return;
+    const int* A = edges.A;
+    const int* B = edges.B;
+    int* rowStart = edges.rowStart;
+    int bx0 = edges.minX / COVERAGE_BLOCK_SIZE;
+    int bx1 = edges.maxX / COVERAGE_BLOCK_SIZE;
+    
+#if defined(__AVX2__)
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i laneBit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i stepA0 = _mm256_set1_epi32(A[0] * 8);
+    __m256i stepA1 = _mm256_set1_epi32(A[1] * 8);
+    __m256i stepA2 = _mm256_set1_epi32(A[2] * 8);
+    __m256i offA0 = _mm256_mullo_epi32(lane, _mm256_set1_epi32(A[0]));
+    __m256i offA1 = _mm256_mullo_epi32(lane, _mm256_set1_epi32(A[1]));
+    __m256i offA2 = _mm256_mullo_epi32(lane, _mm256_set1_epi32(A[2]));
+    __m256i pixel_vec = _mm256_set1_epi32((int)pixel);
+#elif defined(__SSE2__)
+    __m128i stepA0 = _mm_set1_epi32(A[0] * 4);
+    __m128i stepA1 = _mm_set1_epi32(A[1] * 4);
+    __m128i stepA2 = _mm_set1_epi32(A[2] * 4);
+    __m128i offA0 = _mm_setr_epi32(0, A[0], A[0] * 2, A[0] * 3);
+    __m128i offA1 = _mm_setr_epi32(0, A[1], A[1] * 2, A[1] * 3);
+    __m128i offA2 = _mm_setr_epi32(0, A[2], A[2] * 2, A[2] * 3);
+    __m128i pixel_vec = _mm_set1_epi32((int)pixel);
+#endif
+    
+    for (int y = edges.minY; y <= edges.maxY; y++) {
+        uint32_t* row = canvas->backBuffer + (size_t)y * canvas->pitch;
+        bool entered = false;
+        
+#if defined(__AVX2__)
+        __m256i e0 = _mm256_add_epi32(_mm256_set1_epi32(rowStart[0]), offA0);
+        __m256i e1 = _mm256_add_epi32(_mm256_set1_epi32(rowStart[1]), offA1);
+        __m256i e2 = _mm256_add_epi32(_mm256_set1_epi32(rowStart[2]), offA2);
+#elif defined(__SSE2__)
+        __m128i e0 = _mm_add_epi32(_mm_set1_epi32(rowStart[0]), offA0);
+        __m128i e1 = _mm_add_epi32(_mm_set1_epi32(rowStart[1]), offA1);
+        __m128i e2 = _mm_add_epi32(_mm_set1_epi32(rowStart[2]), offA2);
+#else
+        int w0 = rowStart[0], w1 = rowStart[1], w2 = rowStart[2];
+#endif
+        
+        for (int bx = bx0; bx <= bx1; bx++) {
+            uint32_t* span = row + bx * COVERAGE_BLOCK_SIZE;
+            unsigned covered = coverage_row(coverage, bx, y);
+            unsigned inside = 0;
+            
+#if defined(__AVX2__)
+            if (covered != 0xFF) {
+                __m256i outside = _mm256_srai_epi32(_mm256_or_si256(_mm256_or_si256(e0, e1), e2), 31);
+                inside = ~(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF;
+                unsigned write = inside & ~covered;
+                if (write) {
+                    // Lanes past the buffer are covered, so the store never touches them
+                    __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)write), laneBit), laneBit);
+                    _mm256_maskstore_epi32((int*)span, mask, pixel_vec);
+                }
+            }
+            e0 = _mm256_add_epi32(e0, stepA0);
+            e1 = _mm256_add_epi32(e1, stepA1);
+            e2 = _mm256_add_epi32(e2, stepA2);
+#elif defined(__SSE2__)
+            if (covered != 0xFF) {
+                for (int half = 0; half < 2; half++) {
+                    __m128i outside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(e0, e1), e2), 31);
+                    unsigned bits = ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+                    unsigned write = bits & ~(covered >> (half * 4));
+                    if (write == 0xF) {
+                        _mm_storeu_si128((__m128i*)(span + half * 4), pixel_vec);
+                    } else {
+                        // Pixels past the buffer are covered: write only the open ones
+                        for (; write; write &= write - 1) span[half * 4 + __builtin_ctz(write)] = pixel;
+                    }
+                    inside |= bits << (half * 4);
+                    e0 = _mm_add_epi32(e0, stepA0);
+                    e1 = _mm_add_epi32(e1, stepA1);
+                    e2 = _mm_add_epi32(e2, stepA2);
+                }
+            } else {
+                e0 = _mm_add_epi32(e0, _mm_add_epi32(stepA0, stepA0));
+                e1 = _mm_add_epi32(e1, _mm_add_epi32(stepA1, stepA1));
+                e2 = _mm_add_epi32(e2, _mm_add_epi32(stepA2, stepA2));
+            }
+#else
+            if (covered != 0xFF) {
+                for (int i = 0; i < COVERAGE_BLOCK_SIZE; i++) {
+                    if ((w0 | w1 | w2) >= 0) {
+                        inside |= 1u << i;
+                        if (!(covered & (1u << i))) span[i] = pixel;
+                    }
+                    w0 += A[0];
+                    w1 += A[1];
+                    w2 += A[2];
+                }
+            } else {
+                w0 += A[0] * COVERAGE_BLOCK_SIZE;
+                w1 += A[1] * COVERAGE_BLOCK_SIZE;
+                w2 += A[2] * COVERAGE_BLOCK_SIZE;
+            }
+#endif
+            
+            if (inside) {
+                coverage_addRow(coverage, bx, y, inside);
+                entered = true;
+            } else if (entered && covered != 0xFF) {
+                break; // the inside of a convex shape is one span per row
+            }
+        }
         
-        drawLine(canvas, vx[0], vy[0], vx[1], vy[1], color[i]);
-        drawLine(canvas, vx[1], vy[1], vx[2], vy[2], color[i]);
-        drawLine(canvas, vx[2], vy[2], vx[0], vy[0], color[i]);
+        rowStart[0] += B[0];
+        rowStart[1] += B[1];
+        rowStart[2] += B[2];
     }
 }
+
+void renderFilledTrianglesOccluded(Canvas* canvas, TriangleDataSIMD* data, CoverageBuffer* coverage,
+                                   const uint32_t* keys) {
+    if (!coverage_begin(coverage, canvas->bufferWidth, canvas->bufferHeight) ||
+        !coverage_sortFrontToBack(coverage, data->visible, keys, data->count)) {
+        renderFilledTrianglesSIMD(canvas, data);
+        return;
+    }
+    
+    int halfW = canvas->bufferWidth / 2;
+    int halfH = canvas->bufferHeight / 2;
+    float s = canvas->renderScale;
+    int vx[3][SIMD_LANES], vy[3][SIMD_LANES];
+    for (int base = 0; base < coverage->orderCount; base += SIMD_LANES) {
+        int batchSize = coverage->orderCount - base < SIMD_LANES ? coverage->orderCount - base : SIMD_LANES;
+        const int* batch = coverage->order + base;
+        
+#if defined(__AVX2__) || defined(__SSE2__)
+        // Gather the batch so its vertices are transformed together
+        float cx[SIMD_LANES], cy[SIMD_LANES], size[SIMD_LANES], angle[SIMD_LANES];
+        for (int i = 0; i < batchSize; i++) {
+            cx[i] = data->cx[batch[i]];
+            cy[i] = data->cy[batch[i]];
+            size[i] = data->size[batch[i]];
+            angle[i] = data->angle[batch[i]];
+        }
+        calcTriangleVerticesBatch(cx, cy, size, angle, batchSize, s, vx, vy);
+#else
+        int tvx[3], tvy[3];
+        calcTriangleVertices(data->cx[batch[0]] * s, data->cy[batch[0]] * s, data->size[batch[0]] * s,
+                             data->angle[batch[0]], tvx, tvy);
+        for (int v = 0; v < 3; v++) {
+            vx[v][0] = tvx[v];
+            vy[v][0] = tvy[v];
+        }
 #endif
+        
+        // Reject the batch's triangles already hidden, then draw the rest in order
+        unsigned rejected = coverage_testTriangles(coverage, vx, vy, batchSize);
+        for (int i = 0; i < batchSize; i++) {
+            if (rejected & (1u << i)) continue;
+            int minX = vx[0][i], maxX = vx[0][i], minY = vy[0][i], maxY = vy[0][i];
+            for (int v = 1; v < 3; v++) {
+                if (vx[v][i] < minX) minX = vx[v][i];
+                if (vx[v][i] > maxX) maxX = vx[v][i];
+                if (vy[v][i] < minY) minY = vy[v][i];
+                if (vy[v][i] > maxY) maxY = vy[v][i];
+            }
+            Canvas_MarkDirty(canvas, halfW + minX, halfH - maxY, halfW + maxX + 1, halfH - minY + 1);
+            fillTriangleScreenCovered(canvas, coverage,
+                                      halfW + vx[0][i], halfH - vy[0][i],
+                                      halfW + vx[1][i], halfH - vy[1][i],
+                                      halfW + vx[2][i], halfH - vy[2][i],
+                                      data->color[batch[i]]);
+        }
+    }
+}
@@ -0,0 +1,156 @@
+#include "../include/worker_pool.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// Per-thread start argument
+struct WorkerThreadArg {
+    WorkerPool* pool;
+    int         index;
+};
+
+// Thread body: sleep until a new job generation is posted, run it, report back
+static void* workerThreadMain(void* arg) {
+    struct WorkerThreadArg* self = (struct WorkerThreadArg*)arg;
+    WorkerPool* pool = self->pool;
+    unsigned seenGeneration = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seenGeneration) {
+            pthread_cond_wait(&pool->wake, &pool->mutex);
+        }
+        if (pool->shutdown) break;
+
+        seenGeneration = pool->generation;
+        WorkerJob job = pool->job;
+        void* ctx = pool->ctx;
+        pthread_mutex_unlock(&pool->mutex);
+
+        job(ctx, self->index, pool->workerCount);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->finished);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+int workerPool_cpuCount(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+bool workerPool_init(WorkerPool* pool, int workerCount) {
+    if (workerCount <= 0) workerCount = workerPool_cpuCount();
+
+    pool->threads = NULL;
+    pool->args = NULL;
+    pool->workerCount = 1;
+    pool->job = NULL;
+    pool->ctx = NULL;
+    pool->generation = 0;
+    pool->busy = 0;
+    pool->shutdown = false;
+    pool->barrierWaiting = 0;
+    pool->barrierPhase = 0;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    pthread_mutex_init(&pool->barrierMutex, NULL);
+    pthread_cond_init(&pool->barrierCond, NULL);
+
+    if (workerCount == 1) return true;
+
+    pool->threads = malloc(sizeof(pthread_t) * (size_t)(workerCount - 1));
+    pool->args = malloc(sizeof(struct WorkerThreadArg) * (size_t)(workerCount - 1));
+    if (!pool->threads || !pool->args) {
+        free(pool->threads);
+        free(pool->args);
+        pool->threads = NULL;
+        pool->args = NULL;
+        return false;
+    }
+
+    // Worker 0 is the calling thread, spawned threads take indices 1..N-1
+    for (int i = 0; i < workerCount - 1; i++) {
+        pool->args[i].pool = pool;
+        pool->args[i].index = i + 1;
+        if (pthread_create(&pool->threads[i], NULL, workerThreadMain, &pool->args[i]) != 0) {
+            fprintf(stderr, "Warning: Could only start %d of %d worker threads\n", i, workerCount - 1);
+            break;
+        }
+        pool->workerCount++;
+    }
+
+    return true;
+}
+
+void workerPool_free(WorkerPool* pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->workerCount - 1; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    free(pool->threads);
+    free(pool->args);
+    pool->threads = NULL;
+    pool->args = NULL;
+    pool->workerCount = 0;
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->finished);
+    pthread_mutex_destroy(&pool->barrierMutex);
+    pthread_cond_destroy(&pool->barrierCond);
+}
+
+void workerPool_run(WorkerPool* pool, WorkerJob job, void* ctx) {
+    if (pool->workerCount <= 1) {
+        job(ctx, 0, 1);
+        return;
+    }
+
+    // Post the job to the spawned threads
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->ctx = ctx;
+    pool->busy = pool->workerCount - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    // The calling thread is worker 0
+    job(ctx, 0, pool->workerCount);
+
+    // Wait for everyone else
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->finished, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void workerPool_barrier(WorkerPool* pool) {
+    if (pool->workerCount <= 1) return;
+
+    pthread_mutex_lock(&pool->barrierMutex);
+    unsigned phase = pool->barrierPhase;
+    if (++pool->barrierWaiting == pool->workerCount) {
+        pool->barrierWaiting = 0;
+        pool->barrierPhase++;
+        pthread_cond_broadcast(&pool->barrierCond);
+    } else {
+        while (phase == pool->barrierPhase) {
+            pthread_cond_wait(&pool->barrierCond, &pool->barrierMutex);
+        }
+    }
+    pthread_mutex_unlock(&pool->barrierMutex);
+}